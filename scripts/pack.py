@@ -24,6 +24,11 @@ from taiseilib.common import (
     write_depfile,
 )
 
+from taiseilib.resindex import (
+    RESINDEX_DIR,
+    make_index,
+)
+
 
 def pack(args):
     nocompress_file = args.directory / '.nocompress'
@@ -38,6 +43,8 @@ def pack(args):
     if (sys.version_info.major, sys.version_info.minor) >= (3, 7):
         zkwargs['compresslevel'] = 9
 
+    index_entries = []
+
     with ZipFile(str(args.output), 'w', ZIP_DEFLATED, **zkwargs) as zf:
         for path in sorted(args.directory.glob('**/*')):
             if path.name[0] == '.' or path.name == 'meson.build':
@@ -59,11 +66,17 @@ def pack(args):
                         break
 
                 zf.write(str(path), str(relpath), compress_type=ctype)
+                index_entries.append(relpath.as_posix())
+
+        # Lets the game resolve resource names without probing the VFS; see src/resource/resindex.c
+        index_name = '{}/{}.idx'.format(RESINDEX_DIR, Path(args.output).stem)
+        zf.writestr(index_name, make_index(index_entries), compress_type=ZIP_DEFLATED)
 
         if args.depfile is not None:
             write_depfile(args.depfile, args.output,
-                [args.directory.resolve() / x for x in zf.namelist()] +
+                [args.directory.resolve() / x for x in zf.namelist() if x != index_name] +
                 [str(Path(__file__).resolve())] +
+                [str(Path(__file__).resolve().parent / 'taiseilib' / 'resindex.py')] +
                 list(filter(None, [nocompress_file]))
             )
 
@@ -0,0 +1,64 @@
+#!/usr/bin/env python3
+
+from taiseilib.common import (
+    add_common_args,
+    run_main,
+    TaiseiError,
+)
+
+from pathlib import (
+    Path,
+)
+
+import argparse
+import subprocess
+import os
+
+
+def main(args):
+    parser = argparse.ArgumentParser(description='Run the simulation benchmark from a build directory.', prog=args[0])
+
+    parser.add_argument('executable',
+        help='Path to the taisei executable',
+        type=Path,
+    )
+
+    parser.add_argument('--res-path',
+        help='Resource directory to run with (the installed one is used if not given)',
+        type=Path,
+    )
+
+    parser.add_argument('--replays',
+        help='Directory with replays to run in addition to the built-in scenarios',
+        default='',
+    )
+
+    parser.add_argument('--output',
+        help='Where to write the results (JSON); defaults to stdout',
+        type=Path,
+    )
+
+    add_common_args(parser)
+    args = parser.parse_args(args[1:])
+
+    env = os.environ.copy()
+
+    if args.res_path is not None:
+        env.setdefault('TAISEI_RES_PATH', str(args.res_path))
+
+    command = [str(args.executable), '--bench={}'.format(args.replays) if args.replays else '--bench']
+
+    if args.output is not None:
+        command += ['--output', str(args.output)]
+
+    try:
+        subprocess.check_call(command, env=env)
+    except subprocess.CalledProcessError as e:
+        raise TaiseiError('Benchmark failed with exit status {}'.format(e.returncode))
+
+    if args.output is not None:
+        print('Results written to {}'.format(str(args.output)))
+
+
+if __name__ == '__main__':
+    run_main(main)
@@ -0,0 +1,36 @@
+import struct
+
+# Binary resource index, embedded into packages as resindex/<package>.idx
+# See src/resource/resindex.c for the reader.
+#
+# All integers are little-endian.
+#
+#   header:
+#       char[4]  magic = "TRIX"
+#       uint32   version = 2
+#       uint32   number of entries
+#
+#   entry:
+#       uint16   path length
+#       char[]   path, relative to the package root, '/'-separated, not NUL-terminated
+
+RESINDEX_MAGIC = b'TRIX'
+RESINDEX_VERSION = 2
+RESINDEX_DIR = 'resindex'
+
+
+def make_index(relpaths):
+    '''
+    relpaths is an iterable of '/'-separated paths of the files in the package.
+    Returns the index as bytes.
+    '''
+
+    relpaths = sorted(relpaths)
+    out = [struct.pack('<4sII', RESINDEX_MAGIC, RESINDEX_VERSION, len(relpaths))]
+
+    for relpath in relpaths:
+        encpath = relpath.encode('utf8')
+        out.append(struct.pack('<H', len(encpath)))
+        out.append(encpath)
+
+    return b''.join(out)
@@ -0,0 +1,65 @@
+#!/usr/bin/env python3
+
+from taiseilib.common import (
+    add_common_args,
+    run_main,
+    TaiseiError,
+)
+
+from pathlib import (
+    Path,
+)
+
+import argparse
+import subprocess
+import os
+
+
+def main(args):
+    parser = argparse.ArgumentParser(description='Play back replays with a snapshot round trip at every snapshot, failing if any of them desyncs.', prog=args[0])
+
+    parser.add_argument('executable',
+        help='Path to the taisei executable',
+        type=Path,
+    )
+
+    parser.add_argument('replays',
+        help='Directory with the replays to verify',
+        type=Path,
+    )
+
+    parser.add_argument('--res-path',
+        help='Resource directory to run with (the installed one is used if not given)',
+        type=Path,
+    )
+
+    parser.add_argument('--interval',
+        help='Take a snapshot, and go back to the previous one, every this many frames (default: %(default)s)',
+        type=int,
+        default=60,
+    )
+
+    add_common_args(parser)
+    args = parser.parse_args(args[1:])
+
+    if args.interval <= 0:
+        raise TaiseiError('The snapshot interval must be positive')
+
+    env = os.environ.copy()
+
+    if args.res_path is not None:
+        env.setdefault('TAISEI_RES_PATH', str(args.res_path))
+
+    env['TAISEI_REPLAY_SNAPSHOT_INTERVAL'] = str(args.interval)
+    env['TAISEI_REPLAY_SNAPSHOT_VERIFY'] = '1'
+
+    command = [str(args.executable), '--verify-replays', str(args.replays)]
+
+    try:
+        subprocess.check_call(command, env=env)
+    except subprocess.CalledProcessError as e:
+        raise TaiseiError('Snapshot verification failed with exit status {}'.format(e.returncode))
+
+
+if __name__ == '__main__':
+    run_main(main)
@@ -0,0 +1,438 @@
+/*
+ * This software is licensed under the terms of the MIT-License
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2019, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2019, Andrei Alexeyev <akari@alienslab.net>.
+ */
+
+#include "taisei.h"
+
+#include "bench.h"
+#include "global.h"
+#include "replay.h"
+#include "stage.h"
+#include "stages/stress.h"
+#include "stages/stage6.h"
+#include "util/sse42.h"
+#include "version.h"
+#include "vfs/public.h"
+#include "vfs/syspath_public.h"
+
+#define BENCH_MOUNTPOINT "bench-replays"
+#define BENCH_MICRO_ITERATIONS 500
+
+typedef struct BenchFrame {
+	hrtime_t zones[NUM_BENCH_ZONES];
+} BenchFrame;
+
+typedef struct BenchScenario {
+	char *name;
+
+	// Either a stage to play, or a replay to load from replay_path
+	StageInfo *stage;
+	char *replay_path;
+
+	BenchFrame *frames;
+	uint num_frames;
+	uint frames_capacity;
+	hrtime_t wall_time;
+	bool failed;
+} BenchScenario;
+
+typedef struct BenchMicro {
+	const char *name;
+	uint bullets;
+	hrtime_t samples[BENCH_MICRO_ITERATIONS];
+} BenchMicro;
+
+static struct {
+	char *replay_dir;
+	char *output;
+
+	BenchScenario *scenarios;
+	uint num_scenarios;
+	uint current;
+
+	BenchMicro *micros;
+	uint num_micros;
+
+	hrtime_t frame_start;
+	hrtime_t scenario_start;
+
+	CallChain cc;
+} bench;
+
+bool _bench_recording;
+
+static const char *const zone_names[NUM_BENCH_ZONES] = {
+	[BENCH_ZONE_PLAYER]      = "player_logic",
+	[BENCH_ZONE_BOSS]        = "process_boss",
+	[BENCH_ZONE_ENEMIES]     = "process_enemies",
+	[BENCH_ZONE_PROJECTILES] = "process_projectiles",
+	[BENCH_ZONE_ITEMS]       = "process_items",
+	[BENCH_ZONE_LASERS]      = "process_lasers",
+	[BENCH_ZONE_PARTICLES]   = "process_particles",
+	[BENCH_ZONE_TOTAL]       = "stage_logic",
+};
+
+static void bench_next(void);
+
+void bench_setup(const char *replay_dir, const char *output) {
+	memset(&bench, 0, sizeof(bench));
+	bench.replay_dir = replay_dir ? strdup(replay_dir) : NULL;
+	bench.output = output ? strdup(output) : NULL;
+}
+
+hrtime_t _bench_frame_begin(void) {
+	BenchScenario *sc = bench.scenarios + bench.current;
+
+	if(sc->num_frames == sc->frames_capacity) {
+		sc->frames_capacity = sc->frames_capacity ? sc->frames_capacity * 2 : STRESS_DURATION;
+		sc->frames = realloc(sc->frames, sc->frames_capacity * sizeof(*sc->frames));
+	}
+
+	memset(sc->frames + sc->num_frames++, 0, sizeof(*sc->frames));
+	return bench.frame_start = time_get();
+}
+
+void _bench_lap(BenchZone zone, hrtime_t *lap) {
+	BenchScenario *sc = bench.scenarios + bench.current;
+	hrtime_t now = time_get();
+	sc->frames[sc->num_frames - 1].zones[zone] += now - *lap;
+	*lap = now;
+}
+
+void _bench_frame_end(void) {
+	BenchScenario *sc = bench.scenarios + bench.current;
+	sc->frames[sc->num_frames - 1].zones[BENCH_ZONE_TOTAL] = time_get() - bench.frame_start;
+}
+
+static BenchScenario *add_scenario(const char *name) {
+	bench.scenarios = realloc(bench.scenarios, (bench.num_scenarios + 1) * sizeof(*bench.scenarios));
+	BenchScenario *sc = bench.scenarios + bench.num_scenarios++;
+	memset(sc, 0, sizeof(*sc));
+	sc->name = strdup(name);
+	return sc;
+}
+
+static void add_stage_scenario(StageInfo *stg) {
+	if(!stg) {
+		return;
+	}
+
+	char *name = strfmt("%s: %s", stg->title, stg->subtitle);
+	add_scenario(name)->stage = stg;
+	free(name);
+}
+
+static StageInfo *find_stage(StageProcs *procs) {
+	for(StageInfo *stg = stages; stg->procs; ++stg) {
+		if(stg->procs == procs) {
+			return stg;
+		}
+	}
+
+	return NULL;
+}
+
+static bool is_replay_file(const char *name) {
+	return strendswith(name, "." REPLAY_EXTENSION);
+}
+
+static void add_replay_scenarios(void) {
+	if(!vfs_mount_syspath(BENCH_MOUNTPOINT, bench.replay_dir, VFS_SYSPATH_MOUNT_READONLY)) {
+		log_error("Failed to mount '%s': %s", bench.replay_dir, vfs_get_error());
+		return;
+	}
+
+	size_t num_files = 0;
+	char **files = vfs_dir_list_sorted(BENCH_MOUNTPOINT, &num_files, vfs_dir_list_order_ascending, is_replay_file);
+
+	if(!num_files) {
+		log_warn("No replays found in '%s'", bench.replay_dir);
+	}
+
+	for(size_t i = 0; i < num_files; ++i) {
+		BenchScenario *sc = add_scenario(files[i]);
+		sc->replay_path = strfmt("%s%c%s", bench.replay_dir, vfs_get_syspath_separator(), files[i]);
+	}
+
+	vfs_dir_list_free(files, num_files);
+	vfs_unmount(BENCH_MOUNTPOINT);
+}
+
+static int compare_hrtime(const void *a, const void *b) {
+	hrtime_t x = *(const hrtime_t*)a;
+	hrtime_t y = *(const hrtime_t*)b;
+	return (x > y) - (x < y);
+}
+
+static double to_usec(double t) {
+	return t * 1e6 / HRTIME_RESOLUTION;
+}
+
+// Sorts the samples in place.
+static void write_stats(SDL_RWops *out, const char *name, hrtime_t *samples, uint num_samples) {
+	double sum = 0;
+
+	for(uint i = 0; i < num_samples; ++i) {
+		sum += samples[i];
+	}
+
+	qsort(samples, num_samples, sizeof(*samples), compare_hrtime);
+
+	// nearest-rank percentiles
+	#define PERCENTILE(p) to_usec(samples[(uint)ceil((p) / 100.0 * num_samples) - 1])
+
+	SDL_RWprintf(out, "\"%s\":{\"mean\":%.3f,\"p50\":%.3f,\"p90\":%.3f,\"p99\":%.3f,\"max\":%.3f}",
+		name, to_usec(sum / num_samples),
+		PERCENTILE(50), PERCENTILE(90), PERCENTILE(99), PERCENTILE(100)
+	);
+
+	#undef PERCENTILE
+}
+
+static void write_zone_stats(SDL_RWops *out, BenchScenario *sc, BenchZone zone) {
+	hrtime_t *samples = calloc(sc->num_frames, sizeof(*samples));
+
+	for(uint i = 0; i < sc->num_frames; ++i) {
+		samples[i] = sc->frames[i].zones[zone];
+	}
+
+	write_stats(out, zone_names[zone], samples, sc->num_frames);
+	free(samples);
+}
+
+static void write_results(SDL_RWops *out) {
+	SDL_RWprintf(out, "{\"version\":\"%s\",\"scenarios\":[", TAISEI_VERSION);
+
+	for(uint i = 0; i < bench.num_scenarios; ++i) {
+		BenchScenario *sc = bench.scenarios + i;
+		char *name = json_escape(sc->name);
+
+		SDL_RWprintf(out, "%s\n{\"name\":\"%s\",\"status\":\"%s\",\"frames\":%u,\"wall_time\":%.3f,\"zones\":",
+			i ? "," : "", name, sc->failed ? "error" : "ok", sc->num_frames,
+			sc->wall_time / (double)HRTIME_RESOLUTION
+		);
+
+		free(name);
+
+		if(!sc->num_frames) {
+			SDL_RWprintf(out, "null}");
+			continue;
+		}
+
+		SDL_RWprintf(out, "{");
+
+		for(BenchZone z = 0; z < NUM_BENCH_ZONES; ++z) {
+			if(z) {
+				SDL_RWprintf(out, ",");
+			}
+
+			write_zone_stats(out, sc, z);
+		}
+
+		SDL_RWprintf(out, "}}");
+	}
+
+	SDL_RWprintf(out, "\n],\"micro\":[");
+
+	for(uint i = 0; i < bench.num_micros; ++i) {
+		BenchMicro *m = bench.micros + i;
+		SDL_RWprintf(out, "%s\n{\"name\":\"%s\",\"bullets\":%u,", i ? "," : "", m->name, m->bullets);
+		write_stats(out, "batch", m->samples, BENCH_MICRO_ITERATIONS);
+		SDL_RWprintf(out, "}");
+	}
+
+	SDL_RWprintf(out, "\n]}\n");
+}
+
+static int finish(void) {
+	SDL_RWops *out = bench.output ? SDL_RWFromFile(bench.output, "w") : SDL_RWFromFP(stdout, false);
+	int status = 0;
+
+	if(out) {
+		write_results(out);
+		SDL_RWclose(out);
+	} else {
+		log_error("Failed to open the output: %s", SDL_GetError());
+		status = 1;
+	}
+
+	for(uint i = 0; i < bench.num_scenarios; ++i) {
+		BenchScenario *sc = bench.scenarios + i;
+
+		if(sc->failed) {
+			status = 1;
+		}
+
+		free(sc->name);
+		free(sc->replay_path);
+		free(sc->frames);
+	}
+
+	free(bench.scenarios);
+	free(bench.micros);
+	free(bench.replay_dir);
+	free(bench.output);
+
+	return status;
+}
+
+static uint64_t micro_rand_u64(uint64_t *state) {
+	// xorshift64*; tsrand is left alone, so that it doesn't matter for the stage scenarios
+	*state ^= *state >> 12;
+	*state ^= *state << 25;
+	*state ^= *state >> 27;
+	return *state * 0x2545f4914f6cdd1dULL;
+}
+
+static double micro_rand(uint64_t *state) {
+	return (micro_rand_u64(state) >> 11) * (1.0 / (UINT64_C(1) << 53));
+}
+
+typedef void (*CollisionBatchFunc)(uint num, const LineSegment *segs, const Ellipse *ellipses, bool *out);
+
+static void bench_collision_batch(const char *name, CollisionBatchFunc func, uint bullets) {
+	// Two tests per bullet, hitbox and graze area, set up like in process_projectiles.
+	uint num = bullets * 2;
+	LineSegment *segs = calloc(num, sizeof(*segs));
+	Ellipse *ellipses = calloc(num, sizeof(*ellipses));
+	bool *results = calloc(num, sizeof(*results));
+	uint64_t rng = BENCH_RNG_SEED;
+	complex plrpos = VIEWPORT_W * 0.5 + VIEWPORT_H * 0.8 * I;
+	complex plrvel = 2.5;
+
+	for(uint i = 0; i < bullets; ++i) {
+		complex pos = VIEWPORT_W * micro_rand(&rng) + VIEWPORT_H * micro_rand(&rng) * I;
+		complex vel = cexp(I * M_PI * 2 * micro_rand(&rng)) * (1 + 3 * micro_rand(&rng));
+		double angle = carg(vel) + M_PI/2;
+		double size = 4 + 12 * micro_rand(&rng);
+
+		segs[i * 2] = segs[i * 2 + 1] = (LineSegment) {
+			.a = plrpos - plrvel - (pos - vel),
+			.b = plrpos - pos,
+		};
+
+		ellipses[i * 2] = (Ellipse) { .axes = size * (1 + I), .angle = angle };
+		ellipses[i * 2 + 1] = (Ellipse) { .axes = 3 * size * (1 + I), .angle = angle };
+	}
+
+	bench.micros = realloc(bench.micros, (bench.num_micros + 1) * sizeof(*bench.micros));
+	BenchMicro *m = bench.micros + bench.num_micros++;
+	m->name = name;
+	m->bullets = bullets;
+
+	hrtime_t total = 0;
+
+	for(uint i = 0; i < BENCH_MICRO_ITERATIONS; ++i) {
+		hrtime_t start = time_get();
+		func(num, segs, ellipses, results);
+		total += m->samples[i] = time_get() - start;
+	}
+
+	log_info("%s, %u bullets: %.3f us per batch", name, bullets, to_usec(total / (double)BENCH_MICRO_ITERATIONS));
+
+	free(segs);
+	free(ellipses);
+	free(results);
+}
+
+static void run_micros(void) {
+	static const uint bullet_counts[] = { 2000, 10000 };
+
+	for(uint i = 0; i < ARRAY_SIZE(bullet_counts); ++i) {
+		bench_collision_batch("lineseg_ellipse_intersect_batch", lineseg_ellipse_intersect_batch, bullet_counts[i]);
+
+		if(SDL_HasSSE42()) {
+			bench_collision_batch("lineseg_ellipse_intersect_batch_sse42", lineseg_ellipse_intersect_batch_sse42, bullet_counts[i]);
+		}
+	}
+}
+
+static void scenario_done(CallChainResult ccr) {
+	BenchScenario *sc = bench.scenarios + bench.current;
+
+	_bench_recording = false;
+	sc->wall_time = time_get() - bench.scenario_start;
+
+	if(sc->stage) {
+		sc->failed = global.gameover != GAMEOVER_WIN;
+		global.replay_stage = NULL;
+		replay_destroy(&global.replay);
+	} else {
+		ReplayPlaybackResult *res = ccr.result;
+		sc->failed = !res || !res->stages;
+	}
+
+	log_info("%s: %u frames in %.3f s%s", sc->name, sc->num_frames,
+		sc->wall_time / (double)HRTIME_RESOLUTION, sc->failed ? " (failed)" : ""
+	);
+
+	++bench.current;
+	bench_next();
+}
+
+static bool start_scenario(BenchScenario *sc) {
+	log_info("Running %s", sc->name);
+	bench.scenario_start = time_get();
+
+	if(sc->stage) {
+		global.replay_stage = NULL;
+		replay_init(&global.replay);
+		global.gameover = 0;
+		global.diff = sc->stage->difficulty;
+		global.is_practice_mode = true;
+		player_init(&global.plr);
+
+		_bench_recording = true;
+		stage_enter(sc->stage, CALLCHAIN(scenario_done, NULL));
+		return true;
+	}
+
+	// replay_play takes it from here, and destroys it when done
+	if(replay_load_syspath(&global.replay, sc->replay_path, REPLAY_READ_ALL | REPLAY_READ_STREAM)) {
+		_bench_recording = true;
+		replay_play(&global.replay, 0, CALLCHAIN(scenario_done, NULL));
+		return true;
+	}
+
+	sc->failed = true;
+	return false;
+}
+
+static void bench_next(void) {
+	for(; bench.current < bench.num_scenarios && !taisei_quit_requested(); ++bench.current) {
+		if(start_scenario(bench.scenarios + bench.current)) {
+			return;
+		}
+	}
+
+	CallChain cc = bench.cc;
+	int status = finish();
+	memset(&bench, 0, sizeof(bench));
+	run_call_chain(&cc, &status);
+}
+
+void bench_run(CallChain next) {
+	bench.cc = next;
+
+	run_micros();
+
+	stage_add_stress_tests();
+	add_stage_scenario(find_stage(&stage_stress_bullets_procs));
+	add_stage_scenario(find_stage(&stage_stress_lasers_procs));
+	add_stage_scenario(find_stage(&stage_stress_items_procs));
+
+	// Laser-heavy spell cards
+	add_stage_scenario(stage_get_by_spellcard(&stage6_spells.scythe.wave_theory, D_Lunatic));
+	add_stage_scenario(stage_get_by_spellcard(&stage6_spells.baryon.wave_particle_duality, D_Lunatic));
+	add_stage_scenario(stage_get_by_spellcard(&stage6_spells.baryon.higgs_boson_uncovered, D_Lunatic));
+
+	if(bench.replay_dir) {
+		add_replay_scenarios();
+	}
+
+	bench_next();
+}
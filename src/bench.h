@@ -0,0 +1,84 @@
+/*
+ * This software is licensed under the terms of the MIT-License
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2019, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2019, Andrei Alexeyev <akari@alienslab.net>.
+ */
+
+#ifndef IGUARD_bench_h
+#define IGUARD_bench_h
+
+#include "taisei.h"
+
+#include "eventloop/eventloop.h"
+#include "hirestime.h"
+
+/*
+ * Deterministic simulation benchmark (--bench[=DIR]).
+ *
+ * Runs a fixed set of scenarios in logic-only headless mode: the synthetic stress stages
+ * (see stages/stress.h), some of the laser-heavy stage 6 spell cards, and every replay in
+ * DIR, if given. Stages are played with a fixed RNG seed and an invulnerable, idle player,
+ * so every run simulates exactly the same frames.
+ *
+ * Each logic frame, stage_logic reports how long every subsystem took. At the end, a JSON
+ * document is written to the output with the distribution of those times per scenario:
+ *
+ *   {"scenarios":[{"name":"Stress Test: Bullet spiral","frames":3600,"wall_time":1.523,
+ *     "zones":{"projectiles":{"mean":212.4,"p50":208.1,"p90":260.3,"p99":301.7,"max":412.0}, ...}}, ...]}
+ *
+ * All times except wall_time (seconds) are in microseconds per frame.
+ *
+ * Before the scenarios, some hot functions are timed in isolation on synthetic data, and
+ * reported under "micro" in microseconds per call, e.g. the batched bullet collision test:
+ *
+ *   "micro":[{"name":"lineseg_ellipse_intersect_batch","bullets":2000,"batch":{"mean":56.1, ...}}, ...]
+ */
+
+#define BENCH_RNG_SEED 0x7a15e1bec4a4c4ULL
+
+typedef enum BenchZone {
+	BENCH_ZONE_PLAYER,
+	BENCH_ZONE_BOSS,
+	BENCH_ZONE_ENEMIES,
+	BENCH_ZONE_PROJECTILES,
+	BENCH_ZONE_ITEMS,
+	BENCH_ZONE_LASERS,
+	BENCH_ZONE_PARTICLES,
+	BENCH_ZONE_TOTAL,
+	NUM_BENCH_ZONES,
+} BenchZone;
+
+// Called right after the command line is parsed.
+void bench_setup(const char *replay_dir, const char *output);
+
+// Runs all the scenarios, then calls next with a pointer to the exit status (int).
+void bench_run(CallChain next);
+
+// Don't touch these directly; use the functions below.
+extern bool _bench_recording;
+hrtime_t _bench_frame_begin(void);
+void _bench_frame_end(void);
+void _bench_lap(BenchZone zone, hrtime_t *lap);
+
+// Starts timing a logic frame. Returns the time for the first bench_lap.
+static inline attr_must_inline hrtime_t bench_frame_begin(void) {
+	return _bench_recording ? _bench_frame_begin() : 0;
+}
+
+// Adds the time since *lap to the current frame's sample for zone, and restarts the lap.
+static inline attr_must_inline void bench_lap(BenchZone zone, hrtime_t *lap) {
+	if(_bench_recording) {
+		_bench_lap(zone, lap);
+	}
+}
+
+// Finishes the frame; the time since bench_frame_begin goes to BENCH_ZONE_TOTAL.
+static inline attr_must_inline void bench_frame_end(void) {
+	if(_bench_recording) {
+		_bench_frame_end();
+	}
+}
+
+#endif // IGUARD_bench_h
@@ -13,6 +13,7 @@
 #include "stage.h"
 #include "stagetext.h"
 #include "stagedraw.h"
+#include "stageobjects.h"
 #include "entity.h"
 
 static void ent_draw_boss(EntityInterface *ent);
@@ -332,6 +333,25 @@ static void update_hud(Boss *boss) {
 	fapproach_asymptotic_p(&boss->hud.plrproximity_opacity, target_plrproximity_opacity, update_speed, 1e-2);
 }
 
+static void healthbar_uniforms(Boss *boss, float opacity) {
+	// Shared by the radial and linear healthbar shaders.
+	static UniformCache u_border_color    = UNIFORM_CACHE("borderColor");
+	static UniformCache u_glow_color      = UNIFORM_CACHE("glowColor");
+	static UniformCache u_fill_color      = UNIFORM_CACHE("fillColor");
+	static UniformCache u_alt_fill_color  = UNIFORM_CACHE("altFillColor");
+	static UniformCache u_core_fill_color = UNIFORM_CACHE("coreFillColor");
+	static UniformCache u_fill            = UNIFORM_CACHE("fill");
+	static UniformCache u_opacity         = UNIFORM_CACHE("opacity");
+
+	r_uniform_vec4_rgba(r_uniform_cached(&u_border_color),    RGBA(0.75, 0.75, 0.75, 0.75));
+	r_uniform_vec4_rgba(r_uniform_cached(&u_glow_color),      RGBA(0.5, 0.5, 1.0, 0.75));
+	r_uniform_vec4_rgba(r_uniform_cached(&u_fill_color),      &boss->healthbar.fill_color);
+	r_uniform_vec4_rgba(r_uniform_cached(&u_alt_fill_color),  &boss->healthbar.fill_altcolor);
+	r_uniform_vec4_rgba(r_uniform_cached(&u_core_fill_color), RGBA(0.8, 0.8, 0.8, 0.5));
+	r_uniform_vec2(r_uniform_cached(&u_fill), boss->healthbar.fill_total, boss->healthbar.fill_alt);
+	r_uniform_float(r_uniform_cached(&u_opacity), opacity);
+}
+
 static void draw_radial_healthbar(Boss *boss) {
 	if(boss->healthbar.opacity == 0) {
 		return;
@@ -342,13 +362,7 @@ static void draw_radial_healthbar(Boss *boss) {
 	r_mat_translate(creal(boss->pos), cimag(boss->pos), 0);
 	r_mat_scale(220, 220, 0);
 	r_shader("healthbar_radial");
-	r_uniform_vec4_rgba("borderColor",   RGBA(0.75, 0.75, 0.75, 0.75));
-	r_uniform_vec4_rgba("glowColor",     RGBA(0.5, 0.5, 1.0, 0.75));
-	r_uniform_vec4_rgba("fillColor",     &boss->healthbar.fill_color);
-	r_uniform_vec4_rgba("altFillColor",  &boss->healthbar.fill_altcolor);
-	r_uniform_vec4_rgba("coreFillColor", RGBA(0.8, 0.8, 0.8, 0.5));
-	r_uniform_vec2("fill", boss->healthbar.fill_total, boss->healthbar.fill_alt);
-	r_uniform_float("opacity", boss->healthbar.opacity);
+	healthbar_uniforms(boss, boss->healthbar.opacity);
 	r_draw_quad();
 	r_mat_pop();
 	r_state_pop();
@@ -369,13 +383,7 @@ static void draw_linear_healthbar(Boss *boss) {
 	r_mat_translate(1 + width/2, height/2 - 3, 0);
 	r_mat_scale(width, height, 0);
 	r_shader("healthbar_linear");
-	r_uniform_vec4_rgba("borderColor",   RGBA(0.75, 0.75, 0.75, 0.75));
-	r_uniform_vec4_rgba("glowColor",     RGBA(0.5, 0.5, 1.0, 0.75));
-	r_uniform_vec4_rgba("fillColor",     &boss->healthbar.fill_color);
-	r_uniform_vec4_rgba("altFillColor",  &boss->healthbar.fill_altcolor);
-	r_uniform_vec4_rgba("coreFillColor", RGBA(0.8, 0.8, 0.8, 0.5));
-	r_uniform_vec2("fill", boss->healthbar.fill_total, boss->healthbar.fill_alt);
-	r_uniform_float("opacity", opacity);
+	healthbar_uniforms(boss, opacity);
 	r_draw_quad();
 	r_mat_pop();
 	r_state_pop();
@@ -1175,9 +1183,7 @@ static void free_attack(Attack *a) {
 	free(a->name);
 }
 
-void free_boss(Boss *boss) {
-	ent_unregister(&boss->ent);
-
+static void free_boss_data(Boss *boss) {
 	for(int i = 0; i < boss->acount; i++)
 		free_attack(&boss->attacks[i]);
 
@@ -1187,9 +1193,42 @@ void free_boss(Boss *boss) {
 	free(boss);
 }
 
+void free_boss(Boss *boss) {
+	ent_unregister(&boss->ent);
+	free_boss_data(boss);
+}
+
+Boss* copy_boss(Boss *boss) {
+	Boss *copy = memdup(boss, sizeof(*boss));
+	copy->name = strdup(boss->name);
+	copy->attacks = NULL;
+
+	if(boss->acount > 0) {
+		copy->attacks = memdup(boss->attacks, boss->acount * sizeof(*boss->attacks));
+
+		for(int i = 0; i < boss->acount; i++) {
+			copy->attacks[i].name = strdup(boss->attacks[i].name);
+		}
+	}
+
+	if(boss->current) {
+		copy->current = copy->attacks + (boss->current - boss->attacks);
+	}
+
+	aniplayer_copy(&copy->ani, &boss->ani);
+	return copy;
+}
+
+void free_boss_copy(Boss *copy) {
+	free_boss_data(copy);
+}
+
 void boss_start_attack(Boss *b, Attack *a) {
 	log_debug("%s", a->name);
 
+	// Whatever the previous attack needed is likely gone by now.
+	stage_objpools_reclaim();
+
 	StageInfo *i;
 	StageProgress *p = get_spellstage_progress(a, &i, true);
 
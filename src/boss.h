@@ -151,6 +151,11 @@ typedef struct Boss {
 
 Boss* create_boss(char *name, char *ani, char *dialog, complex pos) attr_nonnull(1, 2) attr_returns_nonnull;
 void free_boss(Boss *boss) attr_nonnull(1);
+
+// Deep copy that is not registered as an entity, for game state snapshots. To bring it back,
+// copy it again and ent_relocate the original's registration to the new copy.
+Boss* copy_boss(Boss *boss) attr_nonnull(1) attr_returns_nonnull;
+void free_boss_copy(Boss *copy) attr_nonnull(1);
 void process_boss(Boss **boss) attr_nonnull(1);
 
 void draw_extraspell_bg(Boss *boss, int time) attr_nonnull(1);
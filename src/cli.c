@@ -43,6 +43,10 @@ int cli_args(int argc, char **argv, CLIAction *a) {
 	struct TsOption taisei_opts[] = {
 		{{"replay", required_argument, 0, 'r'}, "Play a replay from %s", "FILE"},
 		{{"verify-replay", required_argument, 0, 'R'}, "Play a replay from %s in headless mode, crash as soon as it desyncs", "FILE"},
+		{{"verify-replays", required_argument, 0, 'V'}, "Verify all replays in directory %s, print a summary", "DIR"},
+		{{"jobs", required_argument, 0, 'j'}, "Use %s worker processes for --verify-replays (default: CPU count)", "N"},
+		{{"bench", optional_argument, 0, 'b'}, "Run the simulation benchmark, plus the replays in %s if given", "DIR"},
+		{{"output", required_argument, 0, 'o'}, "Write the --verify-replays or --bench results to %s instead of stdout", "FILE"},
 #ifdef DEBUG
 		{{"play", no_argument, 0, 'p'}, "Play a specific stage", 0},
 		{{"sid", required_argument, 0, 'i'}, "Select stage by %s", "ID"},
@@ -109,6 +113,24 @@ int cli_args(int argc, char **argv, CLIAction *a) {
 			a->type = CLI_VerifyReplay;
 			a->filename = strdup(optarg);
 			break;
+		case 'V':
+			a->type = CLI_VerifyReplays;
+			a->filename = strdup(optarg);
+			break;
+		case 'b':
+			a->type = CLI_Bench;
+			free(a->filename);
+			a->filename = optarg ? strdup(optarg) : NULL;
+			break;
+		case 'j':
+			a->jobs = strtol(optarg, &endptr, 10);
+			if(!*optarg || *endptr || a->jobs < 1)
+				log_fatal("Invalid number of jobs '%s'", optarg);
+			break;
+		case 'o':
+			free(a->output);
+			a->output = strdup(optarg);
+			break;
 		case 'p':
 			a->type = CLI_SelectStage;
 			break;
@@ -194,10 +216,20 @@ int cli_args(int argc, char **argv, CLIAction *a) {
 	if(a->type == CLI_SelectStage && !stageid)
 		log_fatal("StageSelect mode, but no stage id was given");
 
+	if(a->jobs && a->type != CLI_VerifyReplays) {
+		log_warn("--jobs only applies to --verify-replays; ignored");
+	}
+
+	if(a->output && a->type != CLI_VerifyReplays && a->type != CLI_Bench) {
+		log_warn("--output only applies to --verify-replays and --bench; ignored");
+	}
+
 	return 0;
 }
 
 void free_cli_action(CLIAction *a) {
 	free(a->filename);
 	a->filename = NULL;
+	free(a->output);
+	a->output = NULL;
 }
@@ -17,6 +17,8 @@ typedef enum {
 	CLI_RunNormally = 0,
 	CLI_PlayReplay,
 	CLI_VerifyReplay,
+	CLI_VerifyReplays,
+	CLI_Bench,
 	CLI_SelectStage,
 	CLI_DumpStages,
 	CLI_DumpVFSTree,
@@ -31,6 +33,8 @@ struct CLIAction {
 	int stageid;
 	int diff;
 	int frameskip;
+	int jobs;
+	char *output;
 	PlayerMode *plrmode;
 };
 
@@ -41,6 +41,21 @@ DialogMessage* dadd_msg(Dialog *d, Side side, const char *msg) {
 	return &d->messages[d->count-1];
 }
 
+Dialog *copy_dialog(Dialog *d) {
+	Dialog *copy = memdup(d, sizeof(Dialog));
+	copy->messages = NULL;
+
+	if(d->count > 0) {
+		copy->messages = memdup(d->messages, d->count * sizeof(DialogMessage));
+
+		for(int i = 0; i < d->count; i++) {
+			copy->messages[i].msg = strdup(d->messages[i].msg);
+		}
+	}
+
+	return copy;
+}
+
 void delete_dialog(Dialog *d) {
 	int i;
 	for(i = 0; i < d->count; i++)
@@ -49,6 +49,9 @@ void dset_image(Dialog *d, Side side, const char *name)
 DialogMessage* dadd_msg(Dialog *d, Side side, const char *msg)
 	attr_nonnull(1, 3);
 
+Dialog *copy_dialog(Dialog *d)
+	attr_nonnull(1) attr_returns_nonnull attr_nodiscard;
+
 void delete_dialog(Dialog *d)
 	attr_nonnull(1);
 
@@ -17,6 +17,7 @@
 #include "stageobjects.h"
 #include "util/glm.h"
 #include "entity.h"
+#include "entity_grid.h"
 
 #ifdef create_enemy_p
 #undef create_enemy_p
@@ -92,6 +93,7 @@ Enemy *create_enemy_p(EnemyList *enemies, complex pos, float hp, EnemyVisualRule
 
 	fix_pos0_visual(e);
 	ent_register(&e->ent, ENT_ENEMY);
+	ent_grid_invalidate();
 
 	e->logic_rule(e, EVENT_BIRTH);
 	return e;
@@ -129,6 +131,7 @@ static void* _delete_enemy(ListAnchor *enemies, List* enemy, void *arg) {
 
 	e->logic_rule(e, EVENT_DEATH);
 	ent_unregister(&e->ent);
+	ent_grid_invalidate();
 	objpool_release(stage_object_pools.enemies, alist_unlink(enemies, enemy));
 
 	return NULL;
@@ -186,11 +189,11 @@ static void ent_draw_enemy(EntityInterface *ent) {
 
 int enemy_flare(Projectile *p, int t) { // a[0] velocity, a[1] ref to enemy
 	if(t == EVENT_DEATH) {
-		free_ref(p->args[1]);
+		ref_release(p->args[1]);
 		return ACTION_ACK;
 	}
 
-	Enemy *owner = REF(p->args[1]);
+	Enemy *owner = ref_resolve(p->args[1]);
 
 	/*
 	if(REF(p->args[1]) == NULL) {
@@ -225,7 +228,7 @@ void BigFairy(Enemy *e, int t, bool render) {
 				.rule = enemy_flare,
 				.draw_rule = Shrink,
 				.timeout = 50,
-				.args = { (-50.0*I-offset)/50.0, add_ref(e) },
+				.args = { (-50.0*I-offset)/50.0, ref_acquire(e) },
 			);
 		}
 
@@ -9,9 +9,11 @@
 #include "taisei.h"
 
 #include "entity.h"
+#include "entity_grid.h"
 #include "util.h"
 #include "renderer/api.h"
 #include "global.h"
+#include "profiler.h"
 
 typedef struct EntityDrawHook EntityDrawHook;
 typedef LIST_ANCHOR(EntityDrawHook) EntityDrawHookList;
@@ -23,8 +25,16 @@ struct EntityDrawHook {
 };
 
 static struct {
+	// Entities in draw order. ent_unregister leaves NULL holes behind, and new entities are
+	// appended to the end; both are dealt with lazily by ent_update_draw_order.
 	EntityInterface **array;
+	// draw_layer of each entity in the sorted part of the array, as of the last update.
+	drawlayer_t *sorted_layers;
+	// Entities that need to be (re)inserted into the sorted part.
+	EntityInterface **pending;
 	uint num;
+	uint num_sorted;
+	uint num_live;
 	uint capacity;
 	uint32_t total_spawns;
 
@@ -59,17 +69,27 @@ static void call_hooks(EntityDrawHookList *list, EntityInterface *ent) {
 	}
 }
 
-#define FOR_EACH_ENT(ent) for(EntityInterface **_ent = entities.array, *ent = *entities.array; _ent < entities.array + entities.num; ent = *(++_ent))
+// Entities may be unregistered during iteration; their slots are skipped.
+#define FOR_EACH_ENT(ent) \
+	for(uint _i = 0; _i < entities.num; ++_i) \
+		for(EntityInterface *ent = entities.array[_i]; ent; ent = NULL)
+
+static void ent_alloc_arrays(uint capacity) {
+	entities.capacity = capacity;
+	entities.array = realloc(entities.array, capacity * sizeof(*entities.array));
+	entities.sorted_layers = realloc(entities.sorted_layers, capacity * sizeof(*entities.sorted_layers));
+	entities.pending = realloc(entities.pending, capacity * sizeof(*entities.pending));
+}
 
 void ent_init(void) {
 	memset(&entities, 0, sizeof(entities));
-	entities.capacity = 4096;
-	entities.array = calloc(entities.capacity, sizeof(EntityInterface*));
+	ent_alloc_arrays(4096);
+	ent_grid_init();
 }
 
 void ent_shutdown(void) {
-	if(entities.num) {
-		log_warn("%u entities were not properly unregistered", entities.num);
+	if(entities.num_live) {
+		log_warn("%u entities were not properly unregistered", entities.num_live);
 	}
 
 	FOR_EACH_ENT(ent) {
@@ -77,15 +97,93 @@ void ent_shutdown(void) {
 	}
 
 	free(entities.array);
+	free(entities.sorted_layers);
+	free(entities.pending);
+	ent_grid_shutdown();
 
 	assert(entities.hooks.post_draw.first == NULL);
 	assert(entities.hooks.pre_draw.first == NULL);
 }
 
+static int ent_cmp(const void *ptr1, const void *ptr2) {
+	const EntityInterface *ent1 = *(const EntityInterface**)ptr1;
+	const EntityInterface *ent2 = *(const EntityInterface**)ptr2;
+
+	int r = (ent1->draw_layer > ent2->draw_layer) - (ent1->draw_layer < ent2->draw_layer);
+
+	if(r == 0) {
+		// Same layer? Put whatever spawned later on top, then.
+		r = (ent1->spawn_id > ent2->spawn_id) - (ent1->spawn_id < ent2->spawn_id);
+	}
+
+	return r;
+}
+
+static inline void ent_place(uint index, EntityInterface *ent) {
+	entities.array[index] = ent;
+	entities.sorted_layers[index] = ent->draw_layer;
+	ent->index = index;
+}
+
+/*
+ * Brings the array back into draw order. Between frames, only a few entities spawn,
+ * despawn or change layers, so instead of sorting everything from scratch:
+ *
+ *   1. Compact the sorted part, pulling out every entity whose layer has changed
+ *      since it was sorted. What's left is still in order.
+ *   2. Sort those together with the newly registered entities.
+ *   3. Merge the two runs, back to front, in place.
+ *
+ * This is O(n + k log k) for k changes, rather than O(n log n).
+ */
+static void ent_update_draw_order(void) {
+	uint num_kept = 0;
+	uint num_pending = 0;
+
+	for(uint i = 0; i < entities.num_sorted; ++i) {
+		EntityInterface *ent = entities.array[i];
+
+		if(ent == NULL) {
+			continue;
+		}
+
+		if(ent->draw_layer == entities.sorted_layers[i]) {
+			ent_place(num_kept++, ent);
+		} else {
+			entities.pending[num_pending++] = ent;
+		}
+	}
+
+	for(uint i = entities.num_sorted; i < entities.num; ++i) {
+		if(entities.array[i] != NULL) {
+			entities.pending[num_pending++] = entities.array[i];
+		}
+	}
+
+	assert(num_kept + num_pending == entities.num_live);
+
+	if(num_pending > 1) {
+		qsort(entities.pending, num_pending, sizeof(*entities.pending), ent_cmp);
+	}
+
+	uint dst = entities.num_live;
+	uint src = num_kept;
+
+	while(num_pending > 0) {
+		if(src > 0 && ent_cmp(entities.array + src - 1, entities.pending + num_pending - 1) > 0) {
+			--src;
+			ent_place(--dst, entities.array[src]);
+		} else {
+			ent_place(--dst, entities.pending[--num_pending]);
+		}
+	}
+
+	entities.num = entities.num_sorted = entities.num_live;
+}
+
 void ent_register(EntityInterface *ent, EntityType type) {
 	assert(type > _ENT_TYPE_ENUM_BEGIN && type < _ENT_TYPE_ENUM_END);
 	ent->type = type;
-	ent->index = entities.num++;
 	ent->spawn_id = ++entities.total_spawns;
 
 	if(ent->spawn_id == 0) {
@@ -95,69 +193,118 @@ void ent_register(EntityInterface *ent, EntityType type) {
 		log_debug("spawn_id just overflowed. You might be spawning stuff waaaay too often");
 	}
 
-	if(entities.capacity < entities.num) {
-		entities.capacity *= 2;
-		entities.array = realloc(entities.array, entities.capacity * sizeof(EntityInterface*));
+	if(entities.num == entities.capacity) {
+		// Squeeze out the holes if there are enough of them, otherwise grow.
+		if(entities.num - entities.num_live >= entities.capacity / 4) {
+			ent_update_draw_order();
+		} else {
+			ent_alloc_arrays(entities.capacity * 2);
+		}
 	}
 
+	ent->index = entities.num++;
 	entities.array[ent->index] = ent;
+	entities.num_live++;
 
 	assert(ent->index < entities.num);
 	assert(entities.array[ent->index] == ent);
 }
 
 void ent_unregister(EntityInterface *ent) {
-	EntityInterface *sub = entities.array[--entities.num];
-	assert(ent->index <= entities.num);
+	assert(ent->index < entities.num);
 	assert(entities.array[ent->index] == ent);
-	del_ref(ent);
-	entities.array[sub->index = ent->index] = sub;
+	ref_invalidate(ent);
+	entities.array[ent->index] = NULL;
+	entities.num_live--;
 }
 
-static int ent_cmp(const void *ptr1, const void *ptr2) {
-	const EntityInterface *ent1 = *(const EntityInterface**)ptr1;
-	const EntityInterface *ent2 = *(const EntityInterface**)ptr2;
+void ent_relocate(EntityInterface *old_ent, EntityInterface *ent) {
+	assert(ent->index < entities.num);
+	assert(entities.array[ent->index] == old_ent);
+	entities.array[ent->index] = ent;
+	ref_relocate(old_ent, ent);
+}
 
-	int r = (ent1->draw_layer > ent2->draw_layer) - (ent1->draw_layer < ent2->draw_layer);
+struct EntitySnapshot {
+	EntityInterface **array;
+	drawlayer_t *sorted_layers;
+	uint num;
+	uint num_sorted;
+	uint num_live;
+	uint32_t total_spawns;
+};
 
-	if(r == 0) {
-		// Same layer? Put whatever spawned later on top, then.
-		r = (ent1->spawn_id > ent2->spawn_id) - (ent1->spawn_id < ent2->spawn_id);
+EntitySnapshot *ent_snapshot(void) {
+	EntitySnapshot *snap = calloc(1, sizeof(*snap));
+	snap->array = memdup(entities.array, entities.num * sizeof(*entities.array));
+	snap->sorted_layers = memdup(entities.sorted_layers, entities.num * sizeof(*entities.sorted_layers));
+	snap->num = entities.num;
+	snap->num_sorted = entities.num_sorted;
+	snap->num_live = entities.num_live;
+	snap->total_spawns = entities.total_spawns;
+	return snap;
+}
+
+void ent_snapshot_restore(EntitySnapshot *snap) {
+	if(entities.capacity < snap->num) {
+		ent_alloc_arrays(topow2_u32(snap->num));
 	}
 
-	return r;
+	memcpy(entities.array, snap->array, snap->num * sizeof(*entities.array));
+	memcpy(entities.sorted_layers, snap->sorted_layers, snap->num * sizeof(*entities.sorted_layers));
+	entities.num = snap->num;
+	entities.num_sorted = snap->num_sorted;
+	entities.num_live = snap->num_live;
+	entities.total_spawns = snap->total_spawns;
+	ent_grid_invalidate();
+}
+
+void ent_snapshot_free(EntitySnapshot *snap) {
+	free(snap->array);
+	free(snap->sorted_layers);
+	free(snap);
+}
+
+static inline bool ent_layer_reorderable(drawlayer_t layer) {
+	// Clear effects are short-lived and rarely overlap, so their relative order isn't noticeable,
+	// but there can be thousands of them spread across several atlas pages.
+	return (layer >> LAYER_LOW_BITS) == LAYER_ID_PARTICLE_BULLET_CLEAR;
 }
 
 void ent_draw(EntityPredicate predicate) {
+	PROFILE_ZONE("ent_draw");
 	call_hooks(&entities.hooks.pre_draw, NULL);
-	qsort(entities.array, entities.num, sizeof(EntityInterface*), ent_cmp);
-
-	if(predicate) {
-		FOR_EACH_ENT(ent) {
-			ent->index = _ent - entities.array;
-			assert(entities.array[ent->index] == ent);
-
-			if(ent->draw_func && predicate(ent)) {
-				call_hooks(&entities.hooks.pre_draw, ent);
-				r_state_push();
-				ent->draw_func(ent);
-				r_state_pop();
-				call_hooks(&entities.hooks.post_draw, ent);
-			}
+	ent_update_draw_order();
+
+	bool reordering = false;
+	drawlayer_t reorder_layer = 0;
+
+	FOR_EACH_ENT(ent) {
+		if(!ent->draw_func || (predicate && !predicate(ent))) {
+			continue;
+		}
+
+		if(reordering && ent->draw_layer != reorder_layer) {
+			// Each exact layer gets its own scope, so that sub-layer ordering is kept.
+			r_sprite_reorder_end();
+			reordering = false;
 		}
-	} else {
-		FOR_EACH_ENT(ent) {
-			ent->index = _ent - entities.array;
-			assert(entities.array[ent->index] == ent);
-
-			if(ent->draw_func) {
-				call_hooks(&entities.hooks.pre_draw, ent);
-				r_state_push();
-				ent->draw_func(ent);
-				r_state_pop();
-				call_hooks(&entities.hooks.post_draw, ent);
-			}
+
+		if(!reordering && ent_layer_reorderable(ent->draw_layer)) {
+			r_sprite_reorder_begin();
+			reordering = true;
+			reorder_layer = ent->draw_layer;
 		}
+
+		call_hooks(&entities.hooks.pre_draw, ent);
+		r_state_push();
+		ent->draw_func(ent);
+		r_state_pop();
+		call_hooks(&entities.hooks.post_draw, ent);
+	}
+
+	if(reordering) {
+		r_sprite_reorder_end();
 	}
 
 	call_hooks(&entities.hooks.post_draw, NULL);
@@ -185,16 +332,41 @@ DamageResult ent_damage(EntityInterface *ent, const DamageInfo *damage) {
 	return res;
 }
 
-void ent_area_damage(complex origin, float radius, const DamageInfo *damage, EntityAreaDamageCallback callback, void *callback_arg) {
-	for(Enemy *e = global.enemies.first; e; e = e->next) {
-		if(
-			cabs(origin - e->pos) < radius &&
-			ent_damage(&e->ent, damage) == DMG_RESULT_OK &&
-			callback != NULL
-		) {
-			callback(&e->entity_interface, e->pos, callback_arg);
-		}
+typedef struct AreaDamageParams {
+	const DamageInfo *damage;
+	EntityAreaDamageCallback callback;
+	void *callback_arg;
+} AreaDamageParams;
+
+static void area_damage_enemy(Enemy *e, void *arg) {
+	AreaDamageParams *params = arg;
+
+	if(ent_damage(&e->ent, params->damage) == DMG_RESULT_OK && params->callback != NULL) {
+		params->callback(&e->entity_interface, e->pos, params->callback_arg);
 	}
+}
+
+static bool enemy_in_circle(Enemy *e, void *arg) {
+	Circle *c = arg;
+	return cabs(c->origin - e->pos) < c->radius;
+}
+
+static bool enemy_in_ellipse(Enemy *e, void *arg) {
+	return point_in_ellipse(e->pos, *(Ellipse*)arg);
+}
+
+void ent_area_damage(complex origin, float radius, const DamageInfo *damage, EntityAreaDamageCallback callback, void *callback_arg) {
+	Circle area = { .origin = origin, .radius = radius };
+	Rect bbox = {
+		.top_left = origin - radius * (1 + I),
+		.bottom_right = origin + radius * (1 + I),
+	};
+
+	ent_grid_foreach_enemy(bbox, enemy_in_circle, &area, area_damage_enemy, &(AreaDamageParams) {
+		.damage = damage,
+		.callback = callback,
+		.callback_arg = callback_arg,
+	});
 
 	if(
 		global.boss != NULL &&
@@ -207,15 +379,17 @@ void ent_area_damage(complex origin, float radius, const DamageInfo *damage, Ent
 }
 
 void ent_area_damage_ellipse(Ellipse ellipse, const DamageInfo *damage, EntityAreaDamageCallback callback, void *callback_arg) {
-	for(Enemy *e = global.enemies.first; e; e = e->next) {
-		if(
-			point_in_ellipse(e->pos, ellipse) &&
-			ent_damage(&e->ent, damage) == DMG_RESULT_OK &&
-			callback != NULL
-		) {
-			callback(&e->entity_interface, e->pos, callback_arg);
-		}
-	}
+	double largest_radius = fmax(creal(ellipse.axes), cimag(ellipse.axes)) * 0.5;
+	Rect bbox = {
+		.top_left = ellipse.origin - largest_radius * (1 + I),
+		.bottom_right = ellipse.origin + largest_radius * (1 + I),
+	};
+
+	ent_grid_foreach_enemy(bbox, enemy_in_ellipse, &ellipse, area_damage_enemy, &(AreaDamageParams) {
+		.damage = damage,
+		.callback = callback,
+		.callback_arg = callback_arg,
+	});
 
 	if(
 		global.boss != NULL &&
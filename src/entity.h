@@ -142,6 +142,17 @@ void ent_init(void);
 void ent_shutdown(void);
 void ent_register(EntityInterface *ent, EntityType type) attr_nonnull(1);
 void ent_unregister(EntityInterface *ent) attr_nonnull(1);
+
+// Updates the registry after a registered entity has been moved to a new address, contents intact.
+void ent_relocate(EntityInterface *old_ent, EntityInterface *ent) attr_nonnull(1, 2);
+
+// Saves the registry, but not the entities themselves. Restoring it registers exactly the entities
+// that were registered at the time, at their old addresses; it's up to the caller to put them there.
+typedef struct EntitySnapshot EntitySnapshot;
+EntitySnapshot *ent_snapshot(void) attr_returns_nonnull attr_nodiscard;
+void ent_snapshot_restore(EntitySnapshot *snap) attr_nonnull(1);
+void ent_snapshot_free(EntitySnapshot *snap) attr_nonnull(1);
+
 void ent_draw(EntityPredicate predicate);
 DamageResult ent_damage(EntityInterface *ent, const DamageInfo *damage) attr_nonnull(1, 2);
 void ent_area_damage(complex origin, float radius, const DamageInfo *damage, EntityAreaDamageCallback callback, void *callback_arg) attr_nonnull(3);
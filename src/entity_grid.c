@@ -0,0 +1,245 @@
+/*
+ * This software is licensed under the terms of the MIT-License
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2019, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2019, Andrei Alexeyev <akari@alienslab.net>.
+ */
+
+#include "taisei.h"
+
+#include "entity_grid.h"
+#include "global.h"
+
+// Enemies may linger off-screen for a while, so cover a margin around the viewport as well.
+// Anything that falls outside of the grid goes into the overflow cell, which every query that
+// reaches beyond the grid bounds also checks.
+#define GRID_CELL_SIZE 64
+#define GRID_MARGIN 64
+#define GRID_COLS ((VIEWPORT_W + 2 * GRID_MARGIN + GRID_CELL_SIZE - 1) / GRID_CELL_SIZE)
+#define GRID_ROWS ((VIEWPORT_H + 2 * GRID_MARGIN + GRID_CELL_SIZE - 1) / GRID_CELL_SIZE)
+#define GRID_NUM_CELLS (GRID_COLS * GRID_ROWS)
+#define GRID_OVERFLOW_CELL GRID_NUM_CELLS
+
+// Query areas are padded by this much to absorb rounding errors at cell boundaries.
+#define GRID_QUERY_SLACK 1
+
+typedef struct GridEntry {
+	Enemy *enemy;
+	uint order; // position in global.enemies at the time of binning
+} GridEntry;
+
+typedef struct GridArray {
+	GridEntry *entries;
+	uint num;
+	uint capacity;
+} GridArray;
+
+static struct {
+	// Entries grouped by cell; within a cell they're sorted by order.
+	GridArray binned;
+	// Matches collected by ent_grid_foreach_enemy. Used as a stack to stay reentrant.
+	GridArray matches;
+	// Index of the first entry of each cell (including overflow), plus an end sentinel.
+	uint cell_start[GRID_NUM_CELLS + 2];
+	bool valid;
+} grid;
+
+static void grid_array_reserve(GridArray *a, uint num) {
+	if(a->capacity < num) {
+		a->capacity = topow2_u32(num);
+		a->entries = realloc(a->entries, a->capacity * sizeof(*a->entries));
+	}
+}
+
+static uint grid_cell_index(complex pos) {
+	double x = (creal(pos) + GRID_MARGIN) / GRID_CELL_SIZE;
+	double y = (cimag(pos) + GRID_MARGIN) / GRID_CELL_SIZE;
+
+	// NOTE: written this way to catch NaNs
+	if(!(x >= 0 && x < GRID_COLS && y >= 0 && y < GRID_ROWS)) {
+		return GRID_OVERFLOW_CELL;
+	}
+
+	return (uint)y * GRID_COLS + (uint)x;
+}
+
+void ent_grid_init(void) {
+	memset(&grid, 0, sizeof(grid));
+	grid_array_reserve(&grid.binned, 64);
+	grid_array_reserve(&grid.matches, 64);
+}
+
+void ent_grid_shutdown(void) {
+	free(grid.binned.entries);
+	free(grid.matches.entries);
+	memset(&grid, 0, sizeof(grid));
+}
+
+void ent_grid_rebuild(void) {
+	uint num_enemies = 0;
+	uint *cell_start = grid.cell_start;
+
+	memset(cell_start, 0, sizeof(grid.cell_start));
+
+	// Counting sort: count the entries in each cell first...
+	for(Enemy *e = global.enemies.first; e; e = e->next) {
+		++cell_start[grid_cell_index(e->pos) + 1];
+		++num_enemies;
+	}
+
+	for(uint i = 1; i < ARRAY_SIZE(grid.cell_start); ++i) {
+		cell_start[i] += cell_start[i - 1];
+	}
+
+	grid_array_reserve(&grid.binned, num_enemies);
+	grid.binned.num = num_enemies;
+
+	// ...then scatter them in list order, so every cell ends up sorted by order.
+	// cell_start[i] is used as the insertion cursor for cell i here, which leaves
+	// it pointing at the end of the cell when done; shift everything back by one.
+	uint order = 0;
+
+	for(Enemy *e = global.enemies.first; e; e = e->next) {
+		uint cursor = cell_start[grid_cell_index(e->pos)]++;
+		grid.binned.entries[cursor] = (GridEntry) { .enemy = e, .order = order++ };
+	}
+
+	memmove(cell_start + 1, cell_start, (ARRAY_SIZE(grid.cell_start) - 1) * sizeof(*cell_start));
+	cell_start[0] = 0;
+
+	grid.valid = true;
+}
+
+void ent_grid_invalidate(void) {
+	grid.valid = false;
+}
+
+typedef struct GridCellRange {
+	int col0, col1;
+	int row0, row1;
+	bool overflow;
+} GridCellRange;
+
+static void grid_cell_range(Rect area, GridCellRange *r) {
+	double x0 = (rect_left(area)   - GRID_QUERY_SLACK + GRID_MARGIN) / GRID_CELL_SIZE;
+	double x1 = (rect_right(area)  + GRID_QUERY_SLACK + GRID_MARGIN) / GRID_CELL_SIZE;
+	double y0 = (rect_top(area)    - GRID_QUERY_SLACK + GRID_MARGIN) / GRID_CELL_SIZE;
+	double y1 = (rect_bottom(area) + GRID_QUERY_SLACK + GRID_MARGIN) / GRID_CELL_SIZE;
+
+	r->overflow = !(x0 >= 0 && x1 < GRID_COLS && y0 >= 0 && y1 < GRID_ROWS);
+
+	if(isnan(x0) || isnan(x1) || isnan(y0) || isnan(y1)) {
+		*r = (GridCellRange) { 0, -1, 0, -1, true };
+		return;
+	}
+
+	r->col0 = clamp(floor(x0), 0, GRID_COLS);
+	r->col1 = clamp(floor(x1), -1, GRID_COLS - 1);
+	r->row0 = clamp(floor(y0), 0, GRID_ROWS);
+	r->row1 = clamp(floor(y1), -1, GRID_ROWS - 1);
+}
+
+static inline void grid_cell_entries(uint cell, GridEntry **first, GridEntry **end) {
+	*first = grid.binned.entries + grid.cell_start[cell];
+	*end = grid.binned.entries + grid.cell_start[cell + 1];
+}
+
+Enemy *ent_grid_find_enemy(Rect area, EntGridEnemyPredicate predicate, void *arg) {
+	if(!grid.valid) {
+		for(Enemy *e = global.enemies.first; e; e = e->next) {
+			if(predicate(e, arg)) {
+				return e;
+			}
+		}
+
+		return NULL;
+	}
+
+	GridCellRange r;
+	grid_cell_range(area, &r);
+	GridEntry *best = NULL, *entry, *end;
+
+	for(int row = r.row0; row <= r.row1; ++row) {
+		for(int col = r.col0; col <= r.col1; ++col) {
+			grid_cell_entries(row * GRID_COLS + col, &entry, &end);
+
+			for(; entry < end && (!best || entry->order < best->order); ++entry) {
+				if(predicate(entry->enemy, arg)) {
+					best = entry;
+					break;
+				}
+			}
+		}
+	}
+
+	if(r.overflow) {
+		grid_cell_entries(GRID_OVERFLOW_CELL, &entry, &end);
+
+		for(; entry < end && (!best || entry->order < best->order); ++entry) {
+			if(predicate(entry->enemy, arg)) {
+				best = entry;
+				break;
+			}
+		}
+	}
+
+	return best ? best->enemy : NULL;
+}
+
+static void grid_collect_matches(uint cell, EntGridEnemyPredicate predicate, void *arg) {
+	GridEntry *entry, *end;
+	grid_cell_entries(cell, &entry, &end);
+
+	for(; entry < end; ++entry) {
+		if(predicate(entry->enemy, arg)) {
+			grid_array_reserve(&grid.matches, grid.matches.num + 1);
+			grid.matches.entries[grid.matches.num++] = *entry;
+		}
+	}
+}
+
+static int grid_entry_cmp(const void *a, const void *b) {
+	const GridEntry *e1 = a;
+	const GridEntry *e2 = b;
+	return (e1->order > e2->order) - (e1->order < e2->order);
+}
+
+void ent_grid_foreach_enemy(Rect area, EntGridEnemyPredicate predicate, void *pred_arg, EntGridEnemyCallback callback, void *callback_arg) {
+	if(!grid.valid) {
+		for(Enemy *e = global.enemies.first; e; e = e->next) {
+			if(predicate(e, pred_arg)) {
+				callback(e, callback_arg);
+			}
+		}
+
+		return;
+	}
+
+	GridCellRange r;
+	grid_cell_range(area, &r);
+	uint base = grid.matches.num;
+
+	for(int row = r.row0; row <= r.row1; ++row) {
+		for(int col = r.col0; col <= r.col1; ++col) {
+			grid_collect_matches(row * GRID_COLS + col, predicate, pred_arg);
+		}
+	}
+
+	if(r.overflow) {
+		grid_collect_matches(GRID_OVERFLOW_CELL, predicate, pred_arg);
+	}
+
+	uint num_matches = grid.matches.num - base;
+
+	if(num_matches > 1) {
+		qsort(grid.matches.entries + base, num_matches, sizeof(GridEntry), grid_entry_cmp);
+	}
+
+	// NOTE: the callback may recurse into here and grow the array, so don't hold on to pointers.
+	for(uint i = base; i < base + num_matches; ++i) {
+		callback(grid.matches.entries[i].enemy, callback_arg);
+	}
+
+	grid.matches.num = base;
+}
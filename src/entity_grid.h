@@ -0,0 +1,48 @@
+/*
+ * This software is licensed under the terms of the MIT-License
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2019, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2019, Andrei Alexeyev <akari@alienslab.net>.
+ */
+
+#ifndef IGUARD_entity_grid_h
+#define IGUARD_entity_grid_h
+
+#include "taisei.h"
+
+#include "util/geometry.h"
+
+/*
+ * Uniform grid over the viewport, used as a collision broadphase for player
+ * attacks against enemies.
+ *
+ * The grid is rebuilt once per logic frame by stage_logic, after enemies have
+ * been processed, and stays valid until ent_grid_invalidate() is called.
+ * Spawning or deleting an enemy also invalidates it. While the grid is not
+ * valid, the queries simply walk global.enemies. Enemies must not be moved
+ * while the grid is valid.
+ *
+ * Queries always report enemies in global.enemies order, just like a linear
+ * walk would, so results are identical with or without the grid.
+ */
+
+typedef struct Enemy Enemy;
+
+typedef bool (*EntGridEnemyPredicate)(Enemy *enemy, void *arg);
+typedef void (*EntGridEnemyCallback)(Enemy *enemy, void *arg);
+
+void ent_grid_init(void);
+void ent_grid_shutdown(void);
+void ent_grid_rebuild(void);
+void ent_grid_invalidate(void);
+
+// Returns the first enemy overlapping area for which predicate returns true, or NULL.
+Enemy *ent_grid_find_enemy(Rect area, EntGridEnemyPredicate predicate, void *arg)
+	attr_nonnull(2);
+
+// Calls callback for every enemy overlapping area for which predicate returns true.
+void ent_grid_foreach_enemy(Rect area, EntGridEnemyPredicate predicate, void *pred_arg, EntGridEnemyCallback callback, void *callback_arg)
+	attr_nonnull(2, 4);
+
+#endif // IGUARD_entity_grid_h
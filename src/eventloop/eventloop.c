@@ -12,6 +12,7 @@
 #include "util.h"
 #include "global.h"
 #include "video.h"
+#include "profiler.h"
 
 struct evloop_s evloop;
 
@@ -53,6 +54,7 @@ void eventloop_leave(void) {
 }
 
 LogicFrameAction run_logic_frame(LoopFrame *frame) {
+	PROFILE_ZONE("logic_frame");
 	assert(frame == evloop.stack_ptr);
 
 	if(frame->prev_logic_action == LFRAME_STOP) {
@@ -100,6 +102,7 @@ LogicFrameAction handle_logic(LoopFrame **pframe, const FrameTimes *ftimes) {
 }
 
 RenderFrameAction run_render_frame(LoopFrame *frame) {
+	PROFILE_ZONE("render_frame");
 	attr_unused LoopFrame *stack_prev = evloop.stack_ptr;
 	r_framebuffer_clear(NULL, CLEAR_ALL, RGBA(0, 0, 0, 1), 1);
 	RenderFrameAction a = frame->render(frame->context);
@@ -29,7 +29,10 @@ void eventloop_run(void) {
 	bool compensate = env_get("TAISEI_FRAMELIMITER_COMPENSATE", 1);
 	bool uncapped_rendering_env, uncapped_rendering;
 
-	if(global.is_replay_verification) {
+	// Nobody's watching: don't render, and run the logic as fast as possible.
+	bool logic_only = global.is_replay_verification || global.is_logic_only;
+
+	if(logic_only) {
 		uncapped_rendering_env = false;
 	} else {
 		uncapped_rendering_env = env_get("TAISEI_FRAMELIMITER_LOGIC_ONLY", 0);
@@ -93,13 +96,13 @@ begin_frame:
 			}
 		}
 
-		if((uncapped_rendering || !(frame_num % get_effective_frameskip())) && !global.is_replay_verification) {
+		if((uncapped_rendering || !(frame_num % get_effective_frameskip())) && !logic_only) {
 			run_render_frame(frame);
 		}
 
 		fpscounter_update(&global.fps.busy);
 
-		if(uncapped_rendering || global.frameskip > 0 || global.is_replay_verification) {
+		if(uncapped_rendering || global.frameskip > 0 || logic_only) {
 			continue;
 		}
 
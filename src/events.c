@@ -13,6 +13,7 @@
 #include "global.h"
 #include "video.h"
 #include "gamepad.h"
+#include "profiler.h"
 
 typedef struct EventHandlerContainer {
 	LIST_INTERFACE(struct EventHandlerContainer);
@@ -579,5 +580,12 @@ static bool events_handler_hotkeys(SDL_Event *event, void *arg) {
 		return true;
 	}
 
+#ifdef TAISEI_BUILDCONF_PROFILER
+	if(scan == SDL_SCANCODE_F9) {
+		profiler_dump();
+		return true;
+	}
+#endif
+
 	return false;
 }
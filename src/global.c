@@ -24,14 +24,23 @@ void init_global(CLIAction *cli) {
 	global.replaymode = REPLAY_RECORD;
 	global.frameskip = cli->frameskip;
 
-	if(cli->type == CLI_VerifyReplay) {
+	if(cli->type == CLI_VerifyReplay || cli->type == CLI_VerifyReplays) {
 		global.is_headless = true;
 		global.is_replay_verification = true;
 		global.frameskip = 1;
+	} else if(cli->type == CLI_Bench) {
+		global.is_headless = true;
+		global.is_benchmark = true;
+		global.frameskip = 1;
 	} else if(global.frameskip) {
 		log_warn("FPS limiter disabled. Gotta go fast! (frameskip = %i)", global.frameskip);
 	}
 
+	if(global.is_headless && env_get("TAISEI_LOGIC_ONLY", true)) {
+		log_info("Logic-only mode: nothing will be rendered or played");
+		global.is_logic_only = true;
+	}
+
 	fpscounter_reset(&global.fps.logic);
 	fpscounter_reset(&global.fps.render);
 	fpscounter_reset(&global.fps.busy);
@@ -57,6 +66,11 @@ bool taisei_quit_requested(void) {
 }
 
 void taisei_commit_persistent_data(void) {
+	if(global.is_headless) {
+		// nothing worth saving happens in headless runs, and parallel verifiers would race on the files
+		return;
+	}
+
 	config_save();
 	progress_save();
 	vfs_sync(VFS_SYNC_STORE, NO_CALLCHAIN);
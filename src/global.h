@@ -105,8 +105,6 @@ typedef struct {
 	Boss *boss;
 	Dialog *dialog;
 
-	RefArray refs;
-
 	GameoverType gameover;
 	int gameover_time;
 
@@ -133,6 +131,8 @@ typedef struct {
 	uint is_practice_mode : 1;
 	uint is_headless : 1;
 	uint is_replay_verification : 1;
+	uint is_logic_only : 1; // headless, and resources that are only good for presentation are stubbed out
+	uint is_benchmark : 1;
 } Global;
 
 extern Global global;
@@ -20,6 +20,7 @@ static struct {
 	VertexArray *varr;
 	VertexBuffer *vbuf;
 	ShaderProgram *shader_generic;
+	Texture *tex;
 	Model quad_generic;
 	Framebuffer *saved_fb;
 	Framebuffer *render_fb;
@@ -30,6 +31,25 @@ typedef struct LaserInstancedAttribs {
 	float delta[2];
 } LaserInstancedAttribs;
 
+// Shared between the generic and all the specialized laser shaders.
+static struct {
+	UniformCache tex;
+	UniformCache origin;
+	UniformCache args;
+	UniformCache timeshift;
+	UniformCache width;
+	UniformCache width_exponent;
+	UniformCache span;
+} laser_uniforms = {
+	.tex            = UNIFORM_CACHE("tex"),
+	.origin         = UNIFORM_CACHE("origin"),
+	.args           = UNIFORM_CACHE("args[0]"),
+	.timeshift      = UNIFORM_CACHE("timeshift"),
+	.width          = UNIFORM_CACHE("width"),
+	.width_exponent = UNIFORM_CACHE("width_exponent"),
+	.span           = UNIFORM_CACHE("span"),
+};
+
 static void lasers_ent_predraw_hook(EntityInterface *ent, void *arg);
 static void lasers_ent_postdraw_hook(EntityInterface *ent, void *arg);
 
@@ -90,6 +110,7 @@ void lasers_preload(void) {
 	lasers.quad_generic.vertex_array = lasers.varr;
 
 	lasers.shader_generic = r_shader_get("laser_generic");
+	lasers.tex = get_tex("part/lasercurve");
 }
 
 void lasers_free(void) {
@@ -192,13 +213,13 @@ static void draw_laser_curve_specialized(Laser *l) {
 
 	r_shader_ptr(l->shader);
 	r_color(&l->color);
-	r_uniform_sampler("tex", "part/lasercurve");
-	r_uniform_vec2_complex("origin", l->pos);
-	r_uniform_vec2_array_complex("args[0]", 0, 4, l->args);
-	r_uniform_float("timeshift", timeshift);
-	r_uniform_float("width", l->width);
-	r_uniform_float("width_exponent", l->width_exponent);
-	r_uniform_int("span", instances);
+	r_uniform_sampler(r_uniform_cached(&laser_uniforms.tex), lasers.tex);
+	r_uniform_vec2_complex(r_uniform_cached(&laser_uniforms.origin), l->pos);
+	r_uniform_vec2_array_complex(r_uniform_cached(&laser_uniforms.args), 0, 4, l->args);
+	r_uniform_float(r_uniform_cached(&laser_uniforms.timeshift), timeshift);
+	r_uniform_float(r_uniform_cached(&laser_uniforms.width), l->width);
+	r_uniform_float(r_uniform_cached(&laser_uniforms.width_exponent), l->width_exponent);
+	r_uniform_int(r_uniform_cached(&laser_uniforms.span), instances);
 
 #if 1
 	r_draw_quad_instanced(instances);
@@ -229,11 +250,11 @@ static void draw_laser_curve_generic(Laser *l) {
 
 	r_shader_ptr(lasers.shader_generic);
 	r_color(&l->color);
-	r_uniform_sampler("tex", "part/lasercurve");
-	r_uniform_float("timeshift", timeshift);
-	r_uniform_float("width", l->width);
-	r_uniform_float("width_exponent", l->width_exponent);
-	r_uniform_int("span", instances);
+	r_uniform_sampler(r_uniform_cached(&laser_uniforms.tex), lasers.tex);
+	r_uniform_float(r_uniform_cached(&laser_uniforms.timeshift), timeshift);
+	r_uniform_float(r_uniform_cached(&laser_uniforms.width), l->width);
+	r_uniform_float(r_uniform_cached(&laser_uniforms.width_exponent), l->width_exponent);
+	r_uniform_int(r_uniform_cached(&laser_uniforms.span), instances);
 
 	SDL_RWops *stream = r_vertex_buffer_get_stream(lasers.vbuf);
 	r_vertex_buffer_invalidate(lasers.vbuf);
@@ -275,6 +296,7 @@ static void lasers_ent_predraw_hook(EntityInterface *ent, void *arg) {
 			return;
 		}
 
+		r_gpu_timer_begin("lasers");
 		lasers.saved_fb = r_framebuffer_current();
 		r_framebuffer(lasers.render_fb);
 		r_clear(CLEAR_COLOR, RGBA(0, 0, 0, 0), 1);
@@ -331,6 +353,7 @@ static void lasers_ent_predraw_hook(EntityInterface *ent, void *arg) {
 		r_state_pop();
 		stage_draw_end_noshake();
 		lasers.saved_fb = NULL;
+		r_gpu_timer_end();
 	}
 }
 
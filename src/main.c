@@ -25,14 +25,18 @@
 #include "version.h"
 #include "credits.h"
 #include "taskmanager.h"
+#include "replay_verify.h"
+#include "bench.h"
+#include "profiler.h"
 
 attr_unused
 static void taisei_shutdown(void) {
 	log_info("Shutting down");
 
 	taskmgr_global_shutdown();
+	profiler_shutdown();
 
-	if(!global.is_replay_verification) {
+	if(!global.is_headless) {
 		config_save();
 		progress_save();
 	}
@@ -158,6 +162,8 @@ typedef struct MainContext {
 static void main_post_vfsinit(CallChainResult ccr);
 static void main_singlestg(MainContext *mctx) attr_unused;
 static void main_replay(MainContext *mctx);
+static void main_verify_replays(MainContext *mctx);
+static void main_bench(MainContext *mctx);
 static noreturn void main_vfstree(CallChainResult ccr);
 
 static noreturn void main_quit(MainContext *ctx, int status) {
@@ -203,7 +209,7 @@ int main(int argc, char **argv) {
 	}
 
 	if(ctx->cli.type == CLI_PlayReplay || ctx->cli.type == CLI_VerifyReplay) {
-		if(!replay_load_syspath(&ctx->replay, ctx->cli.filename, REPLAY_READ_ALL)) {
+		if(!replay_load_syspath(&ctx->replay, ctx->cli.filename, REPLAY_READ_ALL | REPLAY_READ_STREAM)) {
 			main_quit(ctx, 1);
 		}
 
@@ -216,6 +222,18 @@ int main(int argc, char **argv) {
 		if(ctx->cli.type == CLI_VerifyReplay) {
 			ctx->headless = true;
 		}
+	} else if(ctx->cli.type == CLI_VerifyReplays) {
+		int status;
+
+		// may fork, so this has to happen before anything else is initialized
+		if(!replay_verify_setup(ctx->cli.filename, ctx->cli.jobs, ctx->cli.output, &status)) {
+			main_quit(ctx, status);
+		}
+
+		ctx->headless = true;
+	} else if(ctx->cli.type == CLI_Bench) {
+		bench_setup(ctx->cli.filename, ctx->cli.output);
+		ctx->headless = true;
 	} else if(ctx->cli.type == CLI_DumpVFSTree) {
 		vfs_setup(CALLCHAIN(main_vfstree, ctx));
 		return 0; // NO main_quit here! vfs_setup may be asynchronous.
@@ -236,7 +254,12 @@ static void main_post_vfsinit(CallChainResult ccr) {
 		env_set("SDL_VIDEODRIVER", "dummy", true);
 		env_set("TAISEI_AUDIO_BACKEND", "null", true);
 		env_set("TAISEI_RENDERER", "null", true);
-		env_set("TAISEI_NOPRELOAD", true, false);
+
+		if(!env_get("TAISEI_LOGIC_ONLY", true)) {
+			// Without logic-only mode, preloading would pull in a lot of useless stuff.
+			env_set("TAISEI_NOPRELOAD", true, false);
+		}
+
 		env_set("TAISEI_PRELOAD_REQUIRED", false, false);
 	} else {
 		init_log_file();
@@ -249,8 +272,9 @@ static void main_post_vfsinit(CallChainResult ccr) {
 	config_load();
 
 	init_sdl();
-	taskmgr_global_init();
 	time_init();
+	profiler_init(); // before any threads are started
+	taskmgr_global_init();
 	init_global(&ctx->cli);
 	events_init();
 	video_init();
@@ -276,6 +300,16 @@ static void main_post_vfsinit(CallChainResult ccr) {
 		return;
 	}
 
+	if(ctx->cli.type == CLI_VerifyReplays) {
+		main_verify_replays(ctx);
+		return;
+	}
+
+	if(ctx->cli.type == CLI_Bench) {
+		main_bench(ctx);
+		return;
+	}
+
 	if(ctx->cli.type == CLI_Credits) {
 		credits_enter(CALLCHAIN(main_cleanup, ctx));
 		eventloop_run();
@@ -365,12 +399,41 @@ static void main_singlestg(MainContext *mctx) {
 	eventloop_run();
 }
 
+static void main_replay_cleanup(CallChainResult ccr) {
+	ReplayPlaybackResult *res = ccr.result;
+	int status = 0;
+
+	if(global.is_replay_verification && (!res || res->desync_stage >= 0)) {
+		status = 1;
+	}
+
+	main_quit(ccr.ctx, status);
+}
+
 static void main_replay(MainContext *mctx) {
-	replay_play(&mctx->replay, mctx->replay_idx, CALLCHAIN(main_cleanup, mctx));
+	replay_play(&mctx->replay, mctx->replay_idx, CALLCHAIN(main_replay_cleanup, mctx));
 	replay_destroy(&mctx->replay); // replay_play makes a copy
 	eventloop_run();
 }
 
+static void main_verify_replays_cleanup(CallChainResult ccr) {
+	main_quit(ccr.ctx, *(int*)ccr.result);
+}
+
+static void main_verify_replays(MainContext *mctx) {
+	replay_verify_run(CALLCHAIN(main_verify_replays_cleanup, mctx));
+	eventloop_run();
+}
+
+static void main_bench_cleanup(CallChainResult ccr) {
+	main_quit(ccr.ctx, *(int*)ccr.result);
+}
+
+static void main_bench(MainContext *mctx) {
+	bench_run(CALLCHAIN(main_bench_cleanup, mctx));
+	eventloop_run();
+}
+
 static void main_vfstree(CallChainResult ccr) {
 	MainContext *mctx = ccr.ctx;
 	SDL_RWops *rwops = SDL_RWFromFP(stdout, false);
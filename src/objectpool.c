@@ -16,6 +16,15 @@ typedef struct ObjHeader {
 	alignas(alignof(max_align_t)) struct ObjHeader *next;
 } ObjHeader;
 
+// A contiguous block of objects: either the pool's main storage, or an extent added later.
+typedef struct ObjExtent {
+	char *objects;
+	uint64_t *free_bits; // bit i is set if object i is free
+	size_t num_objects;
+	size_t live; // number of acquired objects in this extent
+	size_t first_free_word; // no free objects before this word of free_bits; OBJPOOL_LOWEST_FIRST only
+} ObjExtent;
+
 struct ObjectPool {
 	char *tag;
 	size_t size_of_object;
@@ -24,22 +33,56 @@ struct ObjectPool {
 	size_t usage;
 	size_t peak_usage;
 #endif
+	size_t reclaimed_bytes;
+	size_t chunk_size;
+	ObjPoolGrowth growth;
+	ObjPoolOrder order;
+	ObjExtent main;
 	size_t num_extents;
-	char **extents;
-	ObjHeader *free_objects;
-	char objects[];
+	ObjExtent *extents;
+	ObjHeader *free_objects; // OBJPOOL_LIFO only
+	alignas(alignof(max_align_t)) char objects[];
 };
 
+#define BITS_PER_WORD 64
+#define NUM_WORDS(num_objects) (((num_objects) + BITS_PER_WORD - 1) / BITS_PER_WORD)
+
 inline attr_must_inline attr_returns_max_aligned
 static ObjHeader *obj_ptr(ObjectPool *pool, char *objects, size_t idx) {
 	return CASTPTR_ASSUME_ALIGNED(objects + idx * pool->size_of_object, ObjHeader);
 }
 
-static void objpool_register_objects(ObjectPool *pool, char *objects) {
-	for(size_t i = 0; i < pool->max_objects; ++i) {
-		ObjHeader *o = obj_ptr(pool, objects, i);
-		o->next = pool->free_objects;
-		pool->free_objects = o;
+static inline size_t obj_index(ObjectPool *pool, ObjExtent *extent, void *object) {
+	return ((char*)object - extent->objects) / pool->size_of_object;
+}
+
+static inline void obj_mark_free(ObjExtent *extent, size_t idx) {
+	extent->free_bits[idx / BITS_PER_WORD] |= UINT64_C(1) << (idx % BITS_PER_WORD);
+}
+
+static inline void obj_mark_used(ObjExtent *extent, size_t idx) {
+	extent->free_bits[idx / BITS_PER_WORD] &= ~(UINT64_C(1) << (idx % BITS_PER_WORD));
+}
+
+static void objpool_init_extent(ObjectPool *pool, ObjExtent *extent, char *objects, size_t num_objects) {
+	size_t num_words = NUM_WORDS(num_objects);
+
+	extent->objects = objects;
+	extent->num_objects = num_objects;
+	extent->live = 0;
+	extent->first_free_word = 0;
+	extent->free_bits = calloc(num_words, sizeof(*extent->free_bits));
+
+	for(size_t i = 0; i < num_objects; ++i) {
+		obj_mark_free(extent, i);
+	}
+
+	if(pool->order == OBJPOOL_LIFO) {
+		for(size_t i = 0; i < num_objects; ++i) {
+			ObjHeader *o = obj_ptr(pool, objects, i);
+			o->next = pool->free_objects;
+			pool->free_objects = o;
+		}
 	}
 }
 
@@ -49,9 +92,12 @@ ObjectPool *objpool_alloc(size_t obj_size, size_t max_objects, const char *tag)
 	ObjectPool *pool = calloc(1, sizeof(ObjectPool) + (obj_size * max_objects));
 	pool->size_of_object = obj_size;
 	pool->max_objects = max_objects;
+	pool->chunk_size = max_objects;
+	pool->growth = OBJPOOL_GROW_FIXED;
+	pool->order = OBJPOOL_LIFO;
 	pool->tag = strdup(tag);
 
-	objpool_register_objects(pool, pool->objects);
+	objpool_init_extent(pool, &pool->main, pool->objects, pool->max_objects);
 
 	log_debug("[%s] Allocated pool for %zu objects, %zu bytes each",
 		pool->tag,
@@ -62,13 +108,141 @@ ObjectPool *objpool_alloc(size_t obj_size, size_t max_objects, const char *tag)
 	return pool;
 }
 
-static char *objpool_add_extent(ObjectPool *pool) {
+void objpool_set_growth(ObjectPool *pool, ObjPoolGrowth growth, size_t chunk_size) {
+	assert(chunk_size > 0);
+	pool->growth = growth;
+	pool->chunk_size = chunk_size;
+}
+
+static size_t objpool_capacity(ObjectPool *pool) {
+	size_t capacity = pool->main.num_objects;
+
+	for(size_t i = 0; i < pool->num_extents; ++i) {
+		capacity += pool->extents[i].num_objects;
+	}
+
+	return capacity;
+}
+
+static size_t objpool_live_objects(ObjectPool *pool) {
+	size_t live = pool->main.live;
+
+	for(size_t i = 0; i < pool->num_extents; ++i) {
+		live += pool->extents[i].live;
+	}
+
+	return live;
+}
+
+void objpool_set_order(ObjectPool *pool, ObjPoolOrder order) {
+	if(pool->order == order) {
+		return;
+	}
+
+	if(objpool_live_objects(pool) != 0) {
+		log_fatal("[%s] Can't change allocation order of a pool that is in use", pool->tag);
+	}
+
+	pool->order = order;
+	pool->free_objects = NULL;
+
+	if(order == OBJPOOL_LIFO) {
+		// Rebuild the free list in the same order objpool_alloc would have.
+		for(size_t e = 0; e <= pool->num_extents; ++e) {
+			ObjExtent *extent = e ? pool->extents + e - 1 : &pool->main;
+
+			for(size_t i = 0; i < extent->num_objects; ++i) {
+				ObjHeader *o = obj_ptr(pool, extent->objects, i);
+				o->next = pool->free_objects;
+				pool->free_objects = o;
+			}
+		}
+	}
+}
+
+static size_t objpool_next_extent_size(ObjectPool *pool) {
+	switch(pool->growth) {
+		case OBJPOOL_GROW_FIXED:
+			return pool->chunk_size;
+
+		case OBJPOOL_GROW_GEOMETRIC:
+			// Double the total capacity, but never grow by less than a chunk.
+			return max(pool->chunk_size, objpool_capacity(pool));
+
+		default: UNREACHABLE;
+	}
+}
+
+static ObjExtent *objpool_add_extent(ObjectPool *pool) {
+	size_t num_objects = objpool_next_extent_size(pool);
 	pool->extents = realloc(pool->extents, (++pool->num_extents) * sizeof(*pool->extents));
-	char *extent = pool->extents[pool->num_extents - 1] = calloc(pool->max_objects, pool->size_of_object);
-	objpool_register_objects(pool, extent);
+	ObjExtent *extent = pool->extents + pool->num_extents - 1;
+	objpool_init_extent(pool, extent, calloc(num_objects, pool->size_of_object), num_objects);
 	return extent;
 }
 
+static inline bool objpool_extent_contains(ObjectPool *pool, ObjExtent *extent, void *object) {
+	char *ofs = object;
+	return ofs >= extent->objects && ofs < extent->objects + extent->num_objects * pool->size_of_object;
+}
+
+static ObjExtent *objpool_object_extent(ObjectPool *pool, void *object) {
+	// Fast path for objects in the main storage
+	if(pool->num_extents == 0 || objpool_extent_contains(pool, &pool->main, object)) {
+		return &pool->main;
+	}
+
+	for(size_t i = 0; i < pool->num_extents; ++i) {
+		if(objpool_extent_contains(pool, pool->extents + i, object)) {
+			return pool->extents + i;
+		}
+	}
+
+	UNREACHABLE;
+}
+
+// Returns the lowest free object of the extent, or NULL if it's full.
+static ObjHeader *objpool_extent_lowest_free(ObjectPool *pool, ObjExtent *extent) {
+	if(extent->live == extent->num_objects) {
+		return NULL;
+	}
+
+	size_t num_words = NUM_WORDS(extent->num_objects);
+
+	for(size_t w = extent->first_free_word; w < num_words; ++w) {
+		if(extent->free_bits[w]) {
+			extent->first_free_word = w;
+			return obj_ptr(pool, extent->objects, w * BITS_PER_WORD + __builtin_ctzll(extent->free_bits[w]));
+		}
+	}
+
+	UNREACHABLE;
+}
+
+static ObjHeader *objpool_take_lowest_free(ObjectPool *pool) {
+	ObjHeader *obj = objpool_extent_lowest_free(pool, &pool->main);
+
+	for(size_t i = 0; !obj && i < pool->num_extents; ++i) {
+		obj = objpool_extent_lowest_free(pool, pool->extents + i);
+	}
+
+	return obj;
+}
+
+static ObjHeader *objpool_take_free(ObjectPool *pool) {
+	if(pool->order == OBJPOOL_LOWEST_FIRST) {
+		return objpool_take_lowest_free(pool);
+	}
+
+	ObjHeader *obj = pool->free_objects;
+
+	if(obj) {
+		pool->free_objects = obj->next;
+	}
+
+	return obj;
+}
+
 static char* objpool_fmt_size(ObjectPool *pool) {
 	switch(pool->num_extents) {
 		case 0:
@@ -79,13 +253,13 @@ static char* objpool_fmt_size(ObjectPool *pool) {
 
 		case 1:
 			return strfmt("%zu objects, %zu bytes each, with 1 extent",
-				pool->max_objects * 2,
+				objpool_capacity(pool),
 				pool->size_of_object
 			);
 
 		default:
 			return strfmt("%zu objects, %zu bytes each, with %zu extents",
-				pool->max_objects * (1 + pool->num_extents),
+				objpool_capacity(pool),
 				pool->size_of_object,
 				pool->num_extents
 			);
@@ -93,40 +267,53 @@ static char* objpool_fmt_size(ObjectPool *pool) {
 }
 
 void *objpool_acquire(ObjectPool *pool) {
-	ObjHeader *obj = pool->free_objects;
-
-	if(obj) {
-acquired:
-		pool->free_objects = obj->next;
-		memset(obj, 0, pool->size_of_object);
+	ObjHeader *obj = objpool_take_free(pool);
 
-#ifdef OBJPOOL_TRACK_STATS
-		if(++pool->usage > pool->peak_usage) {
-			pool->peak_usage = pool->usage;
-		}
-#endif
+	if(!obj) {
+		char *tmp = objpool_fmt_size(pool);
+		log_warn("[%s] Object pool exhausted (%s), extending",
+			pool->tag,
+			tmp
+		);
+		free(tmp);
 
-		return obj;
+		objpool_add_extent(pool);
+		obj = objpool_take_free(pool);
+		assert(obj != NULL);
 	}
 
-	char *tmp = objpool_fmt_size(pool);
-	log_warn("[%s] Object pool exhausted (%s), extending",
-		pool->tag,
-		tmp
-	);
-	free(tmp);
+	ObjExtent *extent = objpool_object_extent(pool, obj);
+	obj_mark_used(extent, obj_index(pool, extent, obj));
+	extent->live++;
+
+	memset(obj, 0, pool->size_of_object);
 
-	objpool_add_extent(pool);
-	obj = pool->free_objects;
-	assert(obj != NULL);
-	goto acquired;
+#ifdef OBJPOOL_TRACK_STATS
+	if(++pool->usage > pool->peak_usage) {
+		pool->peak_usage = pool->usage;
+	}
+#endif
+
+	return obj;
 }
 
 void objpool_release(ObjectPool *pool, void *object) {
 	objpool_memtest(pool, object);
 	ObjHeader *obj = object;
-	obj->next = pool->free_objects;
-	pool->free_objects = obj;
+
+	ObjExtent *extent = objpool_object_extent(pool, obj);
+	size_t idx = obj_index(pool, extent, obj);
+	assert(extent->live > 0);
+	extent->live--;
+	obj_mark_free(extent, idx);
+
+	if(pool->order == OBJPOOL_LIFO) {
+		obj->next = pool->free_objects;
+		pool->free_objects = obj;
+	} else if(idx / BITS_PER_WORD < extent->first_free_word) {
+		extent->first_free_word = idx / BITS_PER_WORD;
+	}
+
 #ifdef OBJPOOL_TRACK_STATS
 	pool->usage--;
 #endif
@@ -140,9 +327,11 @@ void objpool_free(ObjectPool *pool) {
 #endif
 
 	for(size_t i = 0; i < pool->num_extents; ++i) {
-		free(pool->extents[i]);
+		free(pool->extents[i].objects);
+		free(pool->extents[i].free_bits);
 	}
 
+	free(pool->main.free_bits);
 	free(pool->extents);
 	free(pool->tag);
 	free(pool);
@@ -152,9 +341,295 @@ size_t objpool_object_size(ObjectPool *pool) {
 	return pool->size_of_object;
 }
 
+size_t objpool_reclaim(ObjectPool *pool) {
+	size_t num_empty = 0;
+
+	for(size_t i = 0; i < pool->num_extents; ++i) {
+		num_empty += (pool->extents[i].live == 0);
+	}
+
+	if(num_empty == 0) {
+		return 0;
+	}
+
+	// Drop objects of the empty extents from the free list, preserving the order of the rest.
+	for(ObjHeader **link = &pool->free_objects; *link;) {
+		ObjExtent *extent = objpool_object_extent(pool, *link);
+
+		if(extent != &pool->main && extent->live == 0) {
+			*link = (*link)->next;
+		} else {
+			link = &(*link)->next;
+		}
+	}
+
+	size_t freed_bytes = 0;
+	size_t num_kept = 0;
+
+	for(size_t i = 0; i < pool->num_extents; ++i) {
+		ObjExtent *extent = pool->extents + i;
+
+		if(extent->live == 0) {
+			freed_bytes += extent->num_objects * pool->size_of_object;
+			free(extent->objects);
+			free(extent->free_bits);
+		} else {
+			pool->extents[num_kept++] = *extent;
+		}
+	}
+
+	pool->num_extents = num_kept;
+	pool->reclaimed_bytes += freed_bytes;
+
+	log_debug("[%s] Released %zu empty extents (%zu bytes)",
+		pool->tag,
+		num_empty,
+		freed_bytes
+	);
+
+	return freed_bytes;
+}
+
+static ObjExtent *objpool_iter_extent(ObjectPoolIter *iter) {
+	ObjectPool *pool = iter->pool;
+	return iter->extent ? pool->extents + iter->extent - 1 : &pool->main;
+}
+
+// Finds the first live object at or after iter->index, moving on to the following extents as needed.
+static void objpool_iter_seek(ObjectPoolIter *iter) {
+	ObjectPool *pool = iter->pool;
+
+	for(; iter->extent <= pool->num_extents; ++iter->extent, iter->index = 0) {
+		ObjExtent *extent = objpool_iter_extent(iter);
+
+		if(extent->live == 0) {
+			continue;
+		}
+
+		size_t num_words = NUM_WORDS(extent->num_objects);
+
+		for(size_t w = iter->index / BITS_PER_WORD; w < num_words; ++w) {
+			uint64_t live_bits = ~extent->free_bits[w];
+
+			if(w == iter->index / BITS_PER_WORD) {
+				live_bits &= UINT64_MAX << (iter->index % BITS_PER_WORD);
+			}
+
+			if(live_bits) {
+				size_t idx = w * BITS_PER_WORD + __builtin_ctzll(live_bits);
+
+				if(idx >= extent->num_objects) {
+					// padding bits of the last word
+					break;
+				}
+
+				iter->index = idx;
+				iter->object = obj_ptr(pool, extent->objects, idx);
+				return;
+			}
+		}
+	}
+
+	iter->object = NULL;
+}
+
+void objpool_iter_begin(ObjectPool *pool, ObjectPoolIter *iter) {
+	iter->pool = pool;
+	iter->extent = 0;
+	iter->index = 0;
+	objpool_iter_seek(iter);
+}
+
+void objpool_iter_next(ObjectPoolIter *iter) {
+	assert(iter->object != NULL);
+	iter->index++;
+	objpool_iter_seek(iter);
+}
+
+typedef struct ObjExtentSnapshot {
+	char *objects; // to verify that the extent still exists at restore time
+	uint64_t *free_bits;
+	size_t num_objects;
+	size_t live;
+} ObjExtentSnapshot;
+
+struct ObjectPoolSnapshot {
+	ObjExtentSnapshot *extents; // [0] is the main storage
+	size_t num_extents;
+	ObjHeader **free_list; // OBJPOOL_LIFO only
+	size_t free_list_len;
+	char *data; // contents of the live objects, in memory order
+	size_t data_size;
+};
+
+static inline ObjExtent *objpool_extent(ObjectPool *pool, size_t e) {
+	return e ? pool->extents + e - 1 : &pool->main;
+}
+
+static inline uint64_t extent_live_bits(ObjExtent *extent, size_t w) {
+	uint64_t live_bits = ~extent->free_bits[w];
+
+	if(w == extent->num_objects / BITS_PER_WORD) {
+		// padding bits of the last word
+		live_bits &= (UINT64_C(1) << (extent->num_objects % BITS_PER_WORD)) - 1;
+	}
+
+	return live_bits;
+}
+
+// Copies the live objects of the extent to (or, if restore is set, from) buf; returns the end of the copied data.
+static char *objpool_extent_copy_live(ObjectPool *pool, ObjExtent *extent, char *buf, bool restore) {
+	size_t num_words = NUM_WORDS(extent->num_objects);
+
+	for(size_t w = 0; w < num_words; ++w) {
+		for(uint64_t live_bits = extent_live_bits(extent, w); live_bits; live_bits &= live_bits - 1) {
+			ObjHeader *obj = obj_ptr(pool, extent->objects, w * BITS_PER_WORD + __builtin_ctzll(live_bits));
+
+			if(restore) {
+				memcpy(obj, buf, pool->size_of_object);
+			} else {
+				memcpy(buf, obj, pool->size_of_object);
+			}
+
+			buf += pool->size_of_object;
+		}
+	}
+
+	return buf;
+}
+
+ObjectPoolSnapshot *objpool_snapshot(ObjectPool *pool) {
+	ObjectPoolSnapshot *snap = calloc(1, sizeof(*snap));
+	snap->num_extents = pool->num_extents + 1;
+	snap->extents = calloc(snap->num_extents, sizeof(*snap->extents));
+	snap->data_size = objpool_live_objects(pool) * pool->size_of_object;
+	snap->data = malloc(snap->data_size);
+
+	char *buf = snap->data;
+
+	for(size_t e = 0; e < snap->num_extents; ++e) {
+		ObjExtent *extent = objpool_extent(pool, e);
+		ObjExtentSnapshot *s = snap->extents + e;
+		size_t num_words = NUM_WORDS(extent->num_objects);
+
+		s->objects = extent->objects;
+		s->num_objects = extent->num_objects;
+		s->live = extent->live;
+		s->free_bits = memdup(extent->free_bits, num_words * sizeof(*extent->free_bits));
+		buf = objpool_extent_copy_live(pool, extent, buf, false);
+	}
+
+	assert(buf == snap->data + snap->data_size);
+
+	if(pool->order == OBJPOOL_LIFO) {
+		for(ObjHeader *o = pool->free_objects; o; o = o->next) {
+			++snap->free_list_len;
+		}
+
+		snap->free_list = calloc(snap->free_list_len, sizeof(*snap->free_list));
+		size_t i = 0;
+
+		for(ObjHeader *o = pool->free_objects; o; o = o->next) {
+			snap->free_list[i++] = o;
+		}
+	}
+
+	return snap;
+}
+
+bool objpool_restore(ObjectPool *pool, ObjectPoolSnapshot *snap) {
+	if(snap->num_extents > pool->num_extents + 1) {
+		log_error("[%s] Pool has fewer extents than the snapshot", pool->tag);
+		return false;
+	}
+
+	for(size_t e = 0; e < snap->num_extents; ++e) {
+		ObjExtent *extent = objpool_extent(pool, e);
+
+		if(extent->objects != snap->extents[e].objects || extent->num_objects != snap->extents[e].num_objects) {
+			log_error("[%s] Extent %zu of the snapshot no longer exists", pool->tag, e);
+			return false;
+		}
+	}
+
+	char *buf = snap->data;
+	pool->free_objects = NULL;
+
+	for(size_t e = 0; e <= pool->num_extents; ++e) {
+		ObjExtent *extent = objpool_extent(pool, e);
+		size_t num_words = NUM_WORDS(extent->num_objects);
+		extent->first_free_word = 0;
+
+		if(e < snap->num_extents) {
+			memcpy(extent->free_bits, snap->extents[e].free_bits, num_words * sizeof(*extent->free_bits));
+			extent->live = snap->extents[e].live;
+			buf = objpool_extent_copy_live(pool, extent, buf, true);
+		} else {
+			// Added after the snapshot was taken; the state we're going back to didn't need it yet.
+			for(size_t i = 0; i < extent->num_objects; ++i) {
+				obj_mark_free(extent, i);
+			}
+
+			extent->live = 0;
+		}
+	}
+
+	assert(buf == snap->data + snap->data_size);
+
+	if(pool->order == OBJPOOL_LIFO) {
+		// Newer extents go to the end of the free list, in the order objpool_init_extent would have put them in.
+		ObjHeader **link = &pool->free_objects;
+
+		for(size_t i = 0; i < snap->free_list_len; ++i) {
+			*link = snap->free_list[i];
+			link = &(*link)->next;
+		}
+
+		for(size_t e = snap->num_extents; e <= pool->num_extents; ++e) {
+			ObjExtent *extent = objpool_extent(pool, e);
+
+			for(size_t i = extent->num_objects; i > 0; --i) {
+				*link = obj_ptr(pool, extent->objects, i - 1);
+				link = &(*link)->next;
+			}
+		}
+
+		*link = NULL;
+	}
+
+#ifdef OBJPOOL_TRACK_STATS
+	pool->usage = objpool_live_objects(pool);
+#endif
+
+	return true;
+}
+
+void objpool_snapshot_free(ObjectPoolSnapshot *snap) {
+	for(size_t e = 0; e < snap->num_extents; ++e) {
+		free(snap->extents[e].free_bits);
+	}
+
+	free(snap->extents);
+	free(snap->free_list);
+	free(snap->data);
+	free(snap);
+}
+
+size_t objpool_snapshot_size(ObjectPoolSnapshot *snap) {
+	size_t size = sizeof(*snap) + snap->data_size + snap->free_list_len * sizeof(*snap->free_list);
+
+	for(size_t e = 0; e < snap->num_extents; ++e) {
+		size += sizeof(snap->extents[e]) + NUM_WORDS(snap->extents[e].num_objects) * sizeof(uint64_t);
+	}
+
+	return size;
+}
+
 void objpool_get_stats(ObjectPool *pool, ObjectPoolStats *stats) {
 	stats->tag = pool->tag;
-	stats->capacity = pool->max_objects * (1 + pool->num_extents);
+	stats->capacity = objpool_capacity(pool);
+	stats->num_extents = pool->num_extents;
+	stats->reclaimed_bytes = pool->reclaimed_bytes;
 #ifdef OBJPOOL_TRACK_STATS
 	stats->usage = pool->usage;
 	stats->peak_usage = pool->peak_usage;
@@ -165,10 +640,10 @@ void objpool_get_stats(ObjectPool *pool, ObjectPoolStats *stats) {
 }
 
 attr_unused
-static bool objpool_object_in_subpool(ObjectPool *pool, ObjHeader *object, char *objects) {
+static bool objpool_object_in_subpool(ObjectPool *pool, ObjHeader *object, char *objects, size_t num_objects) {
 	char *objofs = (char*)object;
 	char *minofs = objects;
-	char *maxofs = objects + (pool->max_objects - 1) * pool->size_of_object;
+	char *maxofs = objects + (num_objects - 1) * pool->size_of_object;
 
 	if(objofs < minofs || objofs > maxofs) {
 		return false;
@@ -189,12 +664,12 @@ static bool objpool_object_in_subpool(ObjectPool *pool, ObjHeader *object, char
 
 attr_unused
 static bool objpool_object_in_pool(ObjectPool *pool, ObjHeader *object) {
-	if(objpool_object_in_subpool(pool, object, pool->objects)) {
+	if(objpool_object_in_subpool(pool, object, pool->objects, pool->max_objects)) {
 		return true;
 	}
 
 	for(size_t i = 0; i < pool->num_extents; ++i) {
-		if(objpool_object_in_subpool(pool, object, pool->extents[i])) {
+		if(objpool_object_in_subpool(pool, object, pool->extents[i].objects, pool->extents[i].num_objects)) {
 			return true;
 		}
 	}
@@ -26,14 +26,34 @@
 
 typedef struct ObjectPool ObjectPool;
 typedef struct ObjectPoolStats ObjectPoolStats;
+typedef struct ObjectPoolSnapshot ObjectPoolSnapshot;
 
 struct ObjectPoolStats {
 	const char *tag;
 	size_t capacity;
 	size_t usage;
 	size_t peak_usage;
+	size_t num_extents;
+	size_t reclaimed_bytes;
 };
 
+typedef enum ObjPoolGrowth {
+	OBJPOOL_GROW_FIXED,      // every extent holds chunk_size objects
+	OBJPOOL_GROW_GEOMETRIC,  // every extent doubles the total capacity (but holds at least chunk_size objects)
+} ObjPoolGrowth;
+
+typedef enum ObjPoolOrder {
+	OBJPOOL_LIFO,          // reuse the most recently released object first
+	OBJPOOL_LOWEST_FIRST,  // always hand out the free object with the lowest address, keeping live objects packed
+} ObjPoolOrder;
+
+typedef struct ObjectPoolIter {
+	ObjectPool *pool;
+	void *object;  // current live object; NULL once iteration is over
+	size_t extent;
+	size_t index;
+} ObjectPoolIter;
+
 #define OBJPOOL_ALLOC(typename,max_objects) objpool_alloc(sizeof(typename), max_objects, #typename)
 #define OBJPOOL_ACQUIRE(pool, type) CASTPTR_ASSUME_ALIGNED(objpool_acquire(pool), type)
 
@@ -42,8 +62,33 @@ void objpool_free(ObjectPool *pool) attr_nonnull(1);
 void *objpool_acquire(ObjectPool *pool) attr_returns_max_aligned attr_returns_nonnull attr_nodiscard attr_hot attr_nonnull(1);
 void objpool_release(ObjectPool *pool, void *object) attr_hot attr_nonnull(1, 2);
 void objpool_get_stats(ObjectPool *pool, ObjectPoolStats *stats) attr_nonnull(1, 2);
+
+// Controls how the pool grows once its initial capacity is exhausted.
+// The default is OBJPOOL_GROW_FIXED with a chunk of max_objects.
+void objpool_set_growth(ObjectPool *pool, ObjPoolGrowth growth, size_t chunk_size) attr_nonnull(1);
+
+// Selects the order in which free objects are handed out. The default is OBJPOOL_LIFO.
+// The pool must not have any objects in use.
+void objpool_set_order(ObjectPool *pool, ObjPoolOrder order) attr_nonnull(1);
+
+// Visits all live objects in memory order. The current object may be released during iteration;
+// objects acquired during iteration may or may not be visited. Don't reclaim while iterating.
+void objpool_iter_begin(ObjectPool *pool, ObjectPoolIter *iter) attr_nonnull(1, 2);
+void objpool_iter_next(ObjectPoolIter *iter) attr_nonnull(1);
+
+// Frees all extents with no objects in use. Returns the number of bytes released.
+size_t objpool_reclaim(ObjectPool *pool) attr_nonnull(1);
 size_t objpool_object_size(ObjectPool *pool) attr_nonnull(1);
 
+// Saves the allocation state of the pool along with a copy of every live object. Restoring it puts
+// each object back at the address it was taken from, so pointers between objects stay valid; this
+// only works as long as none of the pool's extents have been reclaimed since. Extents added since
+// are kept, but become empty. objpool_snapshot returns NULL if the pool implementation can't do this.
+ObjectPoolSnapshot *objpool_snapshot(ObjectPool *pool) attr_nodiscard attr_nonnull(1);
+bool objpool_restore(ObjectPool *pool, ObjectPoolSnapshot *snap) attr_nonnull(1, 2);
+void objpool_snapshot_free(ObjectPoolSnapshot *snap) attr_nonnull(1);
+size_t objpool_snapshot_size(ObjectPoolSnapshot *snap) attr_nonnull(1);
+
 #ifdef OBJPOOL_DEBUG
 void objpool_memtest(ObjectPool *pool, void *object) attr_nonnull(1, 2);
 #else
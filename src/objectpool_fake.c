@@ -38,10 +38,45 @@ void objpool_get_stats(ObjectPool *pool, ObjectPoolStats *stats) {
 	stats->tag = "<N/A>";
 }
 
+void objpool_set_growth(ObjectPool *pool, ObjPoolGrowth growth, size_t chunk_size) {
+}
+
+void objpool_set_order(ObjectPool *pool, ObjPoolOrder order) {
+}
+
+// Objects aren't tracked here, so there is nothing to iterate over.
+void objpool_iter_begin(ObjectPool *pool, ObjectPoolIter *iter) {
+	memset(iter, 0, sizeof(*iter));
+	iter->pool = pool;
+}
+
+void objpool_iter_next(ObjectPoolIter *iter) {
+}
+
+size_t objpool_reclaim(ObjectPool *pool) {
+	return 0;
+}
+
 size_t objpool_object_size(ObjectPool *pool) {
 	return pool->size_of_object;
 }
 
+// Objects are scattered all over the heap, so they can't be put back where they were.
+ObjectPoolSnapshot *objpool_snapshot(ObjectPool *pool) {
+	return NULL;
+}
+
+bool objpool_restore(ObjectPool *pool, ObjectPoolSnapshot *snap) {
+	return false;
+}
+
+void objpool_snapshot_free(ObjectPoolSnapshot *snap) {
+}
+
+size_t objpool_snapshot_size(ObjectPoolSnapshot *snap) {
+	return 0;
+}
+
 #ifdef OBJPOOL_DEBUG
 void objpool_memtest(ObjectPool *pool, void *object) {
 }
@@ -11,6 +11,7 @@
 #include "global.h"
 #include "plrmodes.h"
 #include "reimu.h"
+#include "snapshot.h"
 
 // FIXME: We probably need a better way to store shot-specific state.
 //        See also MarisaA.
@@ -607,10 +608,15 @@ static void reimu_spirit_respawn_slaves(Player *plr, short npow, complex param)
 static void reimu_spirit_init(Player *plr) {
 	memset(&reimu_spirit_state, 0, sizeof(reimu_spirit_state));
 	reimu_spirit_state.prev_inputflags = plr->inputflags;
+	snapshot_register_section("reimu spirit", &reimu_spirit_state, sizeof(reimu_spirit_state));
 	reimu_spirit_respawn_slaves(plr, plr->power, 0);
 	reimu_common_bomb_buffer_init();
 }
 
+static void reimu_spirit_free(Player *plr) {
+	snapshot_unregister_section(&reimu_spirit_state);
+}
+
 static void reimu_spirit_think(Player *plr) {
 	if((bool)(reimu_spirit_state.prev_inputflags & INFLAG_FOCUS) ^ (bool)(plr->inputflags & INFLAG_FOCUS)) {
 		reimu_spirit_state.respawn_slaves = true;
@@ -661,6 +667,7 @@ PlayerMode plrmode_reimu_a = {
 	.procs = {
 		.property = reimu_spirit_property,
 		.init = reimu_spirit_init,
+		.free = reimu_spirit_free,
 		.think = reimu_spirit_think,
 		.bomb = reimu_spirit_bomb,
 		.bombbg = reimu_spirit_bomb_bg,
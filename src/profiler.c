@@ -0,0 +1,212 @@
+/*
+ * This software is licensed under the terms of the MIT-License
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2019, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2019, Andrei Alexeyev <akari@alienslab.net>.
+ */
+
+#include "taisei.h"
+
+#include "profiler.h"
+#include "util.h"
+#include "vfs/public.h"
+
+// Per thread. At 60 FPS and a few dozen zones per frame, that's a good half a minute.
+#define PROFILER_BUFFER_SIZE (1 << 16)
+
+typedef struct ProfilerEvent {
+	const char *name;
+	hrtime_t start;
+	hrtime_t end;
+} ProfilerEvent;
+
+typedef struct ProfilerThread {
+	SDL_threadID tid;
+	char *name;
+
+	// Taken by the owning thread for every event, and by profiler_dump; so, practically uncontended.
+	SDL_SpinLock lock;
+	uint64_t num_written;
+	ProfilerEvent events[PROFILER_BUFFER_SIZE];
+} ProfilerThread;
+
+static struct {
+	SDL_TLSID tls;
+	SDL_mutex *mutex;
+	hrtime_t epoch;
+
+	// Buffers outlive their threads, so that whatever the TaskManager workers recorded
+	// before shutting down still makes it into the final dump.
+	ProfilerThread **threads;
+	uint num_threads;
+
+	bool initialized;
+} profiler;
+
+void profiler_init(void) {
+	profiler.mutex = SDL_CreateMutex();
+	profiler.tls = SDL_TLSCreate();
+
+	if(!profiler.mutex || !profiler.tls) {
+		log_sdl_error(LOG_ERROR, "Profiler initialization");
+		return;
+	}
+
+	profiler.epoch = time_get();
+	profiler.initialized = true;
+	profiler_set_thread_name("main");
+
+	log_info("Profiler enabled; press F9 to save a trace");
+}
+
+static ProfilerThread *get_thread(void) {
+	ProfilerThread *t = SDL_TLSGet(profiler.tls);
+
+	if(t) {
+		return t;
+	}
+
+	t = calloc(1, sizeof(*t));
+	t->tid = SDL_ThreadID();
+	SDL_TLSSet(profiler.tls, t, NULL);
+
+	SDL_LockMutex(profiler.mutex);
+	profiler.threads = realloc(profiler.threads, (profiler.num_threads + 1) * sizeof(*profiler.threads));
+	profiler.threads[profiler.num_threads++] = t;
+	SDL_UnlockMutex(profiler.mutex);
+
+	return t;
+}
+
+void profiler_set_thread_name(const char *name) {
+	if(!profiler.initialized) {
+		return;
+	}
+
+	ProfilerThread *t = get_thread();
+	char *newname = strdup(name);
+
+	SDL_LockMutex(profiler.mutex);
+	free(t->name);
+	t->name = newname;
+	SDL_UnlockMutex(profiler.mutex);
+}
+
+ProfilerZone _profiler_zone_begin(const char *name) {
+	if(!profiler.initialized) {
+		return (ProfilerZone) { 0 };
+	}
+
+	return (ProfilerZone) { name, time_get() };
+}
+
+void _profiler_zone_end(ProfilerZone *zone) {
+	if(!zone->name || !profiler.initialized) {
+		return;
+	}
+
+	hrtime_t end = time_get();
+	ProfilerThread *t = get_thread();
+
+	SDL_AtomicLock(&t->lock);
+	t->events[t->num_written++ % PROFILER_BUFFER_SIZE] = (ProfilerEvent) { zone->name, zone->start, end };
+	SDL_AtomicUnlock(&t->lock);
+}
+
+static double to_usec(hrtime_t t) {
+	return (shrtime_t)(t - profiler.epoch) / (HRTIME_RESOLUTION / 1000000.0);
+}
+
+static void dump_thread(SDL_RWops *out, ProfilerThread *t, bool *first) {
+	// Copy the events out first, to not keep the thread waiting while they're written.
+	SDL_AtomicLock(&t->lock);
+	uint64_t end = t->num_written;
+	uint64_t begin = end > PROFILER_BUFFER_SIZE ? end - PROFILER_BUFFER_SIZE : 0;
+	uint num_events = end - begin;
+	ProfilerEvent *events = malloc(sizeof(*events) * imax(1, num_events));
+
+	for(uint64_t i = begin; i < end; ++i) {
+		events[i - begin] = t->events[i % PROFILER_BUFFER_SIZE];
+	}
+
+	SDL_AtomicUnlock(&t->lock);
+
+	char *name = json_escape(t->name ? t->name : "thread");
+	SDL_RWprintf(out, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%lu,\"args\":{\"name\":\"%s\"}}",
+		*first ? "" : ",", t->tid, name
+	);
+	free(name);
+	*first = false;
+
+	for(uint i = 0; i < num_events; ++i) {
+		ProfilerEvent *e = events + i;
+		SDL_RWprintf(out, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%lu,\"ts\":%.3f,\"dur\":%.3f}",
+			e->name, t->tid, to_usec(e->start), (e->end - e->start) / (HRTIME_RESOLUTION / 1000000.0)
+		);
+	}
+
+	free(events);
+}
+
+void profiler_dump(void) {
+	if(!profiler.initialized) {
+		return;
+	}
+
+	SystemTime systime;
+	char timestamp[FILENAME_TIMESTAMP_MIN_BUF_SIZE];
+	get_system_time(&systime);
+	filename_timestamp(timestamp, sizeof(timestamp), systime);
+	char *path = strfmt("storage/profiles/taisei_%s.json", timestamp);
+
+	vfs_mkdir("storage/profiles");
+	SDL_RWops *out = vfs_open(path, VFS_MODE_WRITE);
+
+	if(!out) {
+		log_error("VFS error: %s", vfs_get_error());
+		free(path);
+		return;
+	}
+
+	bool first = true;
+	SDL_RWprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+
+	SDL_LockMutex(profiler.mutex);
+
+	for(uint i = 0; i < profiler.num_threads; ++i) {
+		dump_thread(out, profiler.threads[i], &first);
+	}
+
+	SDL_UnlockMutex(profiler.mutex);
+
+	SDL_RWprintf(out, "\n]}\n");
+	SDL_RWclose(out);
+
+	char *syspath = vfs_repr(path, true);
+	log_info("Saved a trace as %s", syspath);
+	free(syspath);
+	free(path);
+}
+
+void profiler_shutdown(void) {
+	if(!profiler.initialized) {
+		return;
+	}
+
+	if(env_get("TAISEI_PROFILER_DUMP_AT_EXIT", true)) {
+		profiler_dump();
+	}
+
+	profiler.initialized = false;
+
+	// Nothing can be recording anymore at this point.
+	for(uint i = 0; i < profiler.num_threads; ++i) {
+		free(profiler.threads[i]->name);
+		free(profiler.threads[i]);
+	}
+
+	free(profiler.threads);
+	SDL_DestroyMutex(profiler.mutex);
+	memset(&profiler, 0, sizeof(profiler));
+}
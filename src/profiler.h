@@ -0,0 +1,83 @@
+/*
+ * This software is licensed under the terms of the MIT-License
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2019, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2019, Andrei Alexeyev <akari@alienslab.net>.
+ */
+
+#ifndef IGUARD_profiler_h
+#define IGUARD_profiler_h
+
+#include "taisei.h"
+
+#include "hirestime.h"
+
+/*
+ * A simple scoped-zone CPU profiler. Only compiled in with -Dprofiler=true; otherwise,
+ * everything here expands to nothing.
+ *
+ * Every thread records the zones it leaves into its own ring buffer, which keeps only the
+ * most recent ones. The buffers can be dumped in the Chrome trace format (open it in
+ * chrome://tracing or https://ui.perfetto.dev) with profiler_dump, which happens on F9
+ * and at exit.
+ *
+ * Usage:
+ *
+ *   void stage_logic(void) {
+ *       PROFILE_ZONE("stage_logic");  // lasts until the end of the enclosing block
+ *       ...
+ *       PROFILE_BEGIN(pz, "process_lasers");
+ *       process_lasers();
+ *       PROFILE_END(pz);
+ *   }
+ *
+ * Zone names must be string literals, or otherwise live forever.
+ */
+
+#ifdef TAISEI_BUILDCONF_PROFILER
+
+typedef struct ProfilerZone {
+	const char *name;
+	hrtime_t start;
+} ProfilerZone;
+
+void profiler_init(void);
+void profiler_shutdown(void);
+
+// Names the calling thread in the dumps.
+void profiler_set_thread_name(const char *name) attr_nonnull(1);
+
+// Writes everything recorded so far to storage/profiles/.
+void profiler_dump(void);
+
+ProfilerZone _profiler_zone_begin(const char *name);
+void _profiler_zone_end(ProfilerZone *zone);
+
+#define _PROFILER_CONCAT(a, b) a##b
+#define _PROFILER_ZONE_VAR(line) _PROFILER_CONCAT(_profiler_zone_, line)
+
+#define PROFILE_ZONE(name) \
+	attr_cleanup(_profiler_zone_end) attr_unused \
+	ProfilerZone _PROFILER_ZONE_VAR(__LINE__) = _profiler_zone_begin(name)
+
+#define PROFILE_BEGIN(var, name) \
+	ProfilerZone var = _profiler_zone_begin(name)
+
+#define PROFILE_END(var) \
+	_profiler_zone_end(&(var))
+
+#else
+
+static inline attr_must_inline void profiler_init(void) { }
+static inline attr_must_inline void profiler_shutdown(void) { }
+static inline attr_must_inline void profiler_set_thread_name(const char *name) { }
+static inline attr_must_inline void profiler_dump(void) { }
+
+#define PROFILE_ZONE(name)
+#define PROFILE_BEGIN(var, name)
+#define PROFILE_END(var)
+
+#endif
+
+#endif // IGUARD_profiler_h
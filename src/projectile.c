@@ -13,6 +13,8 @@
 #include "global.h"
 #include "list.h"
 #include "stageobjects.h"
+#include "entity_grid.h"
+#include "projectile_motion.h"
 
 ht_ptr2int_t shader_sublayer_map;
 
@@ -103,7 +105,7 @@ static void process_projectile_args(ProjArgs *args, ProjArgs *defaults) {
 	assert(args->type <= PROJ_PLAYER);
 }
 
-static void projectile_size(Projectile *p, double *w, double *h) {
+void projectile_size(Projectile *p, double *w, double *h) {
 	if(p->type == PROJ_PARTICLE && p->sprite != NULL) {
 		*w = p->sprite->w;
 		*h = p->sprite->h;
@@ -134,7 +136,13 @@ static inline int proj_call_rule(Projectile *p, int t) {
 	if(p->timeout > 0 && t >= p->timeout) {
 		result = ACTION_DESTROY;
 	} else if(p->rule != NULL) {
-		result = p->rule(p, t);
+		if(t < 0 || !proj_motion_apply(p, t, &result)) {
+			result = p->rule(p, t);
+
+			if(t >= 0) {
+				proj_motion_update(p);
+			}
+		}
 
 		if(t < 0 && result != ACTION_ACK) {
 			set_debug_info(&p->debug);
@@ -268,6 +276,7 @@ static Projectile* _create_projectile(ProjArgs *args) {
 	// But in that case, code that uses this function's return value must be careful to not dereference a NULL pointer.
 	proj_call_rule(p, EVENT_BIRTH);
 	alist_append(args->dest, p);
+	proj_motion_attach(p, args->dest);
 
 	return p;
 }
@@ -294,6 +303,7 @@ Projectile* _proj_attach_dbginfo(Projectile *p, DebugInfo *dbg, const char *call
 static void* _delete_projectile(ListAnchor *projlist, List *proj, void *arg) {
 	Projectile *p = (Projectile*)proj;
 	proj_call_rule(p, EVENT_DEATH);
+	proj_motion_detach(p);
 	ent_unregister(&p->ent);
 	objpool_release(stage_object_pools.projectiles, alist_unlink(projlist, proj));
 	return NULL;
@@ -307,6 +317,119 @@ void delete_projectiles(ProjectileList *projlist) {
 	alist_foreach(projlist, _delete_projectile, NULL);
 }
 
+#define PLAYER_SHOT_ENEMY_RADIUS 30
+
+static bool player_shot_hits_enemy(Enemy *e, void *arg) {
+	Projectile *p = arg;
+	return e->hp != ENEMY_IMMUNE && cabs(e->pos - p->pos) < PLAYER_SHOT_ENEMY_RADIUS;
+}
+
+/*
+ * Enemy bullets are tested against the player in blocks before the main loop of
+ * process_projectiles, using the positions predicted by the motion lane (see
+ * projectile_motion.h). A result is only used if the inputs of the test turn out
+ * to be exactly the same when calc_projectile_collision gets to the projectile,
+ * so it's always equivalent to testing on the spot.
+ *
+ * Each candidate occupies two consecutive entries: the hitbox and the graze area.
+ */
+
+#define COLLISION_BLOCK_SIZE 256
+
+static struct {
+	LineSegment *segs;
+	Ellipse *ellipses;
+	bool *results;
+	uint num;
+	uint capacity;
+	bool active;
+	void (*batch_func)(uint num, const LineSegment *segs, const Ellipse *ellipses, bool *out);
+} collision_candidates;
+
+static void reserve_collision_candidates(uint num) {
+	if(collision_candidates.capacity < num) {
+		collision_candidates.capacity = topow2_u32(num);
+		collision_candidates.segs = realloc(collision_candidates.segs, collision_candidates.capacity * sizeof(*collision_candidates.segs));
+		collision_candidates.ellipses = realloc(collision_candidates.ellipses, collision_candidates.capacity * sizeof(*collision_candidates.ellipses));
+		collision_candidates.results = realloc(collision_candidates.results, collision_candidates.capacity * sizeof(*collision_candidates.results));
+	}
+}
+
+static void gather_collision_candidates(void) {
+	uint num = 0, tested = 0;
+	ObjectPoolIter iter;
+
+	// Walk the pool rather than the list: it's in memory order, and the order doesn't matter here.
+	// Enemy bullets that are not in global.projs are gathered for nothing, but never looked up.
+	for(objpool_iter_begin(stage_object_pools.projectiles, &iter); iter.object; objpool_iter_next(&iter)) {
+		Projectile *p = iter.object;
+		complex pos;
+		float angle;
+
+		if(
+			p->type != PROJ_ENEMY ||
+			(p->flags & PFLAG_NOCOLLISION) ||
+			!proj_motion_predict(p, &pos, &angle)
+		) {
+			continue;
+		}
+
+		reserve_collision_candidates(num + 2);
+
+		// Same as in calc_projectile_collision, with prevpos being the current position.
+		LineSegment seg = {
+			.a = global.plr.pos - global.plr.velocity - p->pos,
+			.b = global.plr.pos - pos,
+		};
+
+		collision_candidates.segs[num] = seg;
+		collision_candidates.segs[num + 1] = seg;
+
+		collision_candidates.ellipses[num] = (Ellipse) {
+			.axes = p->collision_size,
+			.angle = angle + M_PI/2,
+		};
+
+		collision_candidates.ellipses[num + 1] = (Ellipse) {
+			.axes = projectile_graze_size(p),
+			.angle = angle + M_PI/2,
+		};
+
+		p->collision_candidate = num;
+		num += 2;
+
+		if(num - tested >= COLLISION_BLOCK_SIZE) {
+			collision_candidates.batch_func(num - tested, collision_candidates.segs + tested, collision_candidates.ellipses + tested, collision_candidates.results + tested);
+			tested = num;
+		}
+	}
+
+	if(num > tested) {
+		collision_candidates.batch_func(num - tested, collision_candidates.segs + tested, collision_candidates.ellipses + tested, collision_candidates.results + tested);
+	}
+
+	collision_candidates.num = num;
+	collision_candidates.active = true;
+}
+
+static bool lookup_collision_candidate(Projectile *p, LineSegment *seg, Ellipse *hitbox, complex graze_size, bool *out_hit, bool *out_graze) {
+	uint i = p->collision_candidate;
+
+	if(
+		!collision_candidates.active ||
+		i + 1 >= collision_candidates.num ||
+		memcmp(seg, collision_candidates.segs + i, sizeof(*seg)) ||
+		memcmp(hitbox, collision_candidates.ellipses + i, sizeof(*hitbox)) ||
+		memcmp(&graze_size, &collision_candidates.ellipses[i + 1].axes, sizeof(graze_size))
+	) {
+		return false;
+	}
+
+	*out_hit = collision_candidates.results[i];
+	*out_graze = !*out_hit && creal(graze_size) > 1 && collision_candidates.results[i + 1];
+	return true;
+}
+
 void calc_projectile_collision(Projectile *p, ProjCollisionResult *out_col) {
 	assert(out_col != NULL);
 
@@ -347,28 +470,40 @@ void calc_projectile_collision(Projectile *p, ProjCollisionResult *out_col) {
 			);
 		}
 
-		if(lineseg_ellipse_intersect(seg, e_proj)) {
+		complex graze_size = projectile_graze_size(p);
+		bool hit, graze;
+
+		if(!lookup_collision_candidate(p, &seg, &e_proj, graze_size, &hit, &graze)) {
+			hit = lineseg_ellipse_intersect(seg, e_proj);
+			graze = !hit && creal(graze_size) > 1 && lineseg_ellipse_intersect(seg, (Ellipse) {
+				.axes = graze_size,
+				.angle = e_proj.angle,
+			});
+		}
+
+		if(hit) {
 			out_col->type = PCOL_ENTITY;
 			out_col->entity = &global.plr.ent;
 			out_col->fatal = true;
-		} else {
-			e_proj.axes = projectile_graze_size(p);
-
-			if(creal(e_proj.axes) > 1 && lineseg_ellipse_intersect(seg, e_proj)) {
-				out_col->type = PCOL_PLAYER_GRAZE;
-				out_col->entity = &global.plr.ent;
-				out_col->location = p->pos;
-			}
+		} else if(graze) {
+			out_col->type = PCOL_PLAYER_GRAZE;
+			out_col->entity = &global.plr.ent;
+			out_col->location = p->pos;
 		}
 	} else if(p->type == PROJ_PLAYER) {
-		for(Enemy *e = global.enemies.first; e; e = e->next) {
-			if(e->hp != ENEMY_IMMUNE && cabs(e->pos - p->pos) < 30) {
-				out_col->type = PCOL_ENTITY;
-				out_col->entity = &e->ent;
-				out_col->fatal = true;
+		Rect area = {
+			.top_left = p->pos - PLAYER_SHOT_ENEMY_RADIUS * (1 + I),
+			.bottom_right = p->pos + PLAYER_SHOT_ENEMY_RADIUS * (1 + I),
+		};
 
-				return;
-			}
+		Enemy *e = ent_grid_find_enemy(area, player_shot_hits_enemy, p);
+
+		if(e != NULL) {
+			out_col->type = PCOL_ENTITY;
+			out_col->entity = &e->ent;
+			out_col->fatal = true;
+
+			return;
 		}
 
 		if(global.boss && cabs(global.boss->pos - p->pos) < 42) {
@@ -482,7 +617,7 @@ static void really_clear_projectile(ProjectileList *projlist, Projectile *proj)
 	}
 
 	if(clear_item != NULL && effect != NULL) {
-		effect->args[0] = add_ref(clear_item);
+		effect->args[0] = ref_acquire(clear_item);
 	}
 
 	delete_projectile(projlist, proj);
@@ -514,6 +649,12 @@ void process_projectiles(ProjectileList *projlist, bool collision) {
 	int action;
 	bool stage_cleared = stage_is_cleared();
 
+	proj_motion_begin_frame(projlist);
+
+	if(collision) {
+		gather_collision_candidates();
+	}
+
 	for(Projectile *proj = projlist->first, *next; proj; proj = next) {
 		next = proj->next;
 		proj->prevpos = proj->pos;
@@ -545,8 +686,13 @@ void process_projectiles(ProjectileList *projlist, bool collision) {
 			}
 		} else {
 			memset(&col, 0, sizeof(col));
+			bool in_viewport;
 
-			if(!projectile_in_viewport(proj)) {
+			if(!proj_motion_in_viewport(proj, &in_viewport)) {
+				in_viewport = projectile_in_viewport(proj);
+			}
+
+			if(!in_viewport) {
 				col.fatal = true;
 			}
 		}
@@ -554,6 +700,9 @@ void process_projectiles(ProjectileList *projlist, bool collision) {
 		apply_projectile_collision(projlist, proj, &col);
 	}
 
+	proj_motion_end_frame(projlist);
+	collision_candidates.active = false;
+
 	for(Projectile *proj = projlist->first, *next; proj; proj = next) {
 		next = proj->next;
 
@@ -601,7 +750,7 @@ int linear(Projectile *p, int t) { // sure is physics in here; a[0]: velocity
 		return ACTION_ACK;
 	}
 
-	p->pos = p->pos0 + p->args[0]*t;
+	p->pos = proj_motion_linear_pos(p->pos0, p->args[0], t);
 
 	return ACTION_NONE;
 }
@@ -617,8 +766,7 @@ int accelerated(Projectile *p, int t) {
 		return ACTION_ACK;
 	}
 
-	p->pos += p->args[0];
-	p->args[0] += p->args[1];
+	proj_motion_accelerated_step(&p->pos, &p->args[0], p->args[1]);
 
 	return 1;
 }
@@ -634,8 +782,7 @@ int asymptotic(Projectile *p, int t) { // v = a[0]*(a[1] + 1); a[1] -> 0
 		return ACTION_ACK;
 	}
 
-	p->args[1] *= 0.8;
-	p->pos += p->args[0]*(p->args[1] + 1);
+	proj_motion_asymptotic_step(&p->pos, p->args[0], &p->args[1]);
 
 	return 1;
 }
@@ -795,7 +942,7 @@ static void projectile_clear_effect_draw(Projectile *p, int t) {
 
 static int projectile_clear_effect_logic(Projectile *p, int t) {
 	if(t == EVENT_DEATH) {
-		free_ref(p->args[0]);
+		ref_release(p->args[0]);
 		return ACTION_ACK;
 	}
 
@@ -807,7 +954,7 @@ static int projectile_clear_effect_logic(Projectile *p, int t) {
 		return ACTION_NONE;
 	}
 
-	Item *i = REF(p->args[0]);
+	Item *i = ref_resolve(p->args[0]);
 
 	if(i != NULL) {
 		p->pos = i->pos;
@@ -1032,6 +1179,14 @@ void projectiles_preload(void) {
 
 	const uint num_shaders = sizeof(shaders)/sizeof(*shaders);
 
+	proj_motion_init();
+
+	if(SDL_HasSSE42()) {
+		collision_candidates.batch_func = lineseg_ellipse_intersect_batch_sse42;
+	} else {
+		collision_candidates.batch_func = lineseg_ellipse_intersect_batch;
+	}
+
 	for(uint i = 0; i < num_shaders; ++i) {
 		preload_resource(RES_SHADER_PROGRAM, shaders[i], RESF_PERMANENT);
 	}
@@ -1082,4 +1237,10 @@ void projectiles_preload(void) {
 
 void projectiles_free(void) {
 	ht_destroy(&shader_sublayer_map);
+	proj_motion_shutdown();
+
+	free(collision_candidates.segs);
+	free(collision_candidates.ellipses);
+	free(collision_candidates.results);
+	memset(&collision_candidates, 0, sizeof(collision_candidates));
 }
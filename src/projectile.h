@@ -64,6 +64,13 @@ typedef enum ProjFlags {
 	PFLAG_NOSPAWNEFFECTS = PFLAG_NOSPAWNFADE | PFLAG_NOSPAWNFLARE,
 } ProjFlags;
 
+// Membership in the motion fast lane; see projectile_motion.h
+typedef struct ProjMotionSlot {
+	uint8_t lane;
+	uint8_t rule;
+	uint index;
+} ProjMotionSlot;
+
 // FIXME: prototype stuff awkwardly shoved in this header because of dependency cycles.
 typedef struct ProjPrototype ProjPrototype;
 
@@ -101,6 +108,9 @@ struct Projectile {
 	int graze_cooldown;
 	short graze_counter;
 
+	ProjMotionSlot motion;
+	uint collision_candidate; // see gather_collision_candidates in projectile.c
+
 #ifdef PROJ_DEBUG
 	DebugInfo debug;
 #endif
@@ -196,6 +206,7 @@ Projectile* spawn_projectile_clear_effect(Projectile *proj);
 Projectile* spawn_projectile_highlight_effect(Projectile *proj);
 
 void projectile_set_prototype(Projectile *p, ProjPrototype *proto);
+void projectile_size(Projectile *p, double *w, double *h);
 
 bool clear_projectile(Projectile *proj, uint flags);
 
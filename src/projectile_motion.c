@@ -0,0 +1,469 @@
+/*
+ * This software is licensed under the terms of the MIT-License
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2019, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2019, Andrei Alexeyev <akari@alienslab.net>.
+ */
+
+#include "taisei.h"
+
+#include "projectile_motion.h"
+#include "global.h"
+
+enum {
+	LANE_NONE,
+	LANE_PROJS,
+	LANE_PARTICLES,
+	NUM_LANES,
+};
+
+// Double-buffered part of the motion state: the kernel reads one buffer and writes the other.
+typedef struct MotionBuffer {
+	complex *pos;
+	complex *args0;
+	complex *args1;
+	bool *valid;
+} MotionBuffer;
+
+typedef struct MotionBatch {
+	Projectile **projs;
+	complex *pos0;
+	int *birthtime;
+
+	// For the viewport test; see projectile_in_viewport
+	double *half_w;
+	double *half_h;
+	double *margin;
+
+	// Kernel outputs that are not part of the state
+	float *angle;
+	bool *in_viewport;
+	bool *applied;
+
+	MotionBuffer buffers[2];
+	uint num;
+	uint capacity;
+	uint in_buffer;
+} MotionBatch;
+
+typedef struct MotionLane {
+	MotionBatch batches[NUM_PROJ_MOTION_RULES];
+	int frame;
+	bool in_frame;
+} MotionLane;
+
+static MotionLane lanes[NUM_LANES];
+
+#define BATCH_ARRAYS(X) \
+	X(projs) \
+	X(pos0) \
+	X(birthtime) \
+	X(half_w) \
+	X(half_h) \
+	X(margin) \
+	X(angle) \
+	X(in_viewport) \
+	X(applied) \
+
+#define BUFFER_ARRAYS(X) \
+	X(pos) \
+	X(args0) \
+	X(args1) \
+	X(valid) \
+
+static inline MotionBuffer *batch_input(MotionBatch *b) {
+	return b->buffers + b->in_buffer;
+}
+
+static inline MotionBuffer *batch_output(MotionBatch *b) {
+	return b->buffers + (b->in_buffer ^ 1);
+}
+
+static void batch_reserve(MotionBatch *b, uint num) {
+	if(b->capacity >= num) {
+		return;
+	}
+
+	b->capacity = topow2_u32(num);
+
+	#define REALLOC_ARRAY(a) b->a = realloc(b->a, b->capacity * sizeof(*b->a));
+	BATCH_ARRAYS(REALLOC_ARRAY)
+	#undef REALLOC_ARRAY
+
+	for(uint i = 0; i < ARRAY_SIZE(b->buffers); ++i) {
+		MotionBuffer *buf = b->buffers + i;
+		#define REALLOC_ARRAY(a) buf->a = realloc(buf->a, b->capacity * sizeof(*buf->a));
+		BUFFER_ARRAYS(REALLOC_ARRAY)
+		#undef REALLOC_ARRAY
+	}
+}
+
+static void batch_free(MotionBatch *b) {
+	#define FREE_ARRAY(a) free(b->a);
+	BATCH_ARRAYS(FREE_ARRAY)
+	#undef FREE_ARRAY
+
+	for(uint i = 0; i < ARRAY_SIZE(b->buffers); ++i) {
+		MotionBuffer *buf = b->buffers + i;
+		#define FREE_ARRAY(a) free(buf->a);
+		BUFFER_ARRAYS(FREE_ARRAY)
+		#undef FREE_ARRAY
+	}
+
+	memset(b, 0, sizeof(*b));
+}
+
+static ProjMotionRule motion_rule_id(ProjRule rule) {
+	if(rule == linear) {
+		return PROJ_MOTION_LINEAR;
+	}
+
+	if(rule == accelerated) {
+		return PROJ_MOTION_ACCELERATED;
+	}
+
+	if(rule == asymptotic) {
+		return PROJ_MOTION_ASYMPTOTIC;
+	}
+
+	return PROJ_MOTION_NONE;
+}
+
+static ProjRule motion_rule_func(ProjMotionRule id) {
+	switch(id) {
+		case PROJ_MOTION_LINEAR:      return linear;
+		case PROJ_MOTION_ACCELERATED: return accelerated;
+		case PROJ_MOTION_ASYMPTOTIC:  return asymptotic;
+		default: UNREACHABLE;
+	}
+}
+
+static uint8_t lane_id(ProjectileList *projlist) {
+	if(projlist == &global.projs) {
+		return LANE_PROJS;
+	}
+
+	if(projlist == &global.particles) {
+		return LANE_PARTICLES;
+	}
+
+	return LANE_NONE;
+}
+
+static inline bool cmplx_identical(complex a, complex b) {
+	// Bitwise comparison: must not treat e.g. 0.0 and -0.0 as equal.
+	return !memcmp(&a, &b, sizeof(a));
+}
+
+// Caches what the viewport test needs. Sizes can change at any time (e.g. through
+// projectile_set_prototype), so this is refreshed whenever the state is stored, and
+// checked again before the kernel's result is used; see proj_motion_in_viewport.
+static bool batch_store_extents(MotionBatch *b, uint i, Projectile *p) {
+	double w, h;
+	projectile_size(p, &w, &h);
+
+	bool changed = b->half_w[i] != w/2 || b->half_h[i] != h/2 || b->margin[i] != p->max_viewport_dist;
+
+	b->half_w[i] = w/2;
+	b->half_h[i] = h/2;
+	b->margin[i] = p->max_viewport_dist;
+
+	return changed;
+}
+
+static void batch_store(MotionLane *lane, MotionBatch *b, uint i, Projectile *p) {
+	// During a frame, the kernel has already consumed the input buffer;
+	// the state we store now is what the next frame should start from.
+	MotionBuffer *buf = lane->in_frame ? batch_output(b) : batch_input(b);
+
+	b->pos0[i] = p->pos0;
+	b->birthtime[i] = p->birthtime;
+	buf->pos[i] = p->pos;
+	buf->args0[i] = p->args[0];
+	buf->args1[i] = p->args[1];
+	buf->valid[i] = true;
+	batch_store_extents(b, i, p);
+}
+
+static void batch_add(MotionLane *lane, MotionBatch *b, Projectile *p) {
+	batch_reserve(b, b->num + 1);
+
+	uint i = b->num++;
+
+	b->projs[i] = p;
+	batch_store_extents(b, i, p);
+	b->applied[i] = false;
+	batch_input(b)->valid[i] = false;
+	batch_output(b)->valid[i] = false;
+	p->motion.index = i;
+}
+
+static void batch_remove(MotionBatch *b, uint i) {
+	assert(i < b->num);
+	uint last = --b->num;
+
+	if(i == last) {
+		return;
+	}
+
+	#define MOVE_ELEMENT(a) b->a[i] = b->a[last];
+	BATCH_ARRAYS(MOVE_ELEMENT)
+	#undef MOVE_ELEMENT
+
+	for(uint j = 0; j < ARRAY_SIZE(b->buffers); ++j) {
+		MotionBuffer *buf = b->buffers + j;
+		#define MOVE_ELEMENT(a) buf->a[i] = buf->a[last];
+		BUFFER_ARRAYS(MOVE_ELEMENT)
+		#undef MOVE_ELEMENT
+	}
+
+	b->projs[i]->motion.index = i;
+}
+
+static void batch_step(MotionBatch *b, ProjMotionRule rule, int frame) {
+	const uint num = b->num;
+	MotionBuffer *in = batch_input(b);
+	MotionBuffer *out = batch_output(b);
+
+	switch(rule) {
+		case PROJ_MOTION_LINEAR:
+			for(uint i = 0; i < num; ++i) {
+				out->pos[i] = proj_motion_linear_pos(b->pos0[i], in->args0[i], frame - b->birthtime[i]);
+				out->args0[i] = in->args0[i];
+				out->args1[i] = in->args1[i];
+			}
+			break;
+
+		case PROJ_MOTION_ACCELERATED:
+			for(uint i = 0; i < num; ++i) {
+				complex pos = in->pos[i], vel = in->args0[i];
+				proj_motion_accelerated_step(&pos, &vel, in->args1[i]);
+				out->pos[i] = pos;
+				out->args0[i] = vel;
+				out->args1[i] = in->args1[i];
+			}
+			break;
+
+		case PROJ_MOTION_ASYMPTOTIC:
+			for(uint i = 0; i < num; ++i) {
+				complex pos = in->pos[i], boost = in->args1[i];
+				proj_motion_asymptotic_step(&pos, in->args0[i], &boost);
+				out->pos[i] = pos;
+				out->args0[i] = in->args0[i];
+				out->args1[i] = boost;
+			}
+			break;
+
+		default: UNREACHABLE;
+	}
+
+	// All of the built-in rules orient the projectile along its initial velocity.
+	for(uint i = 0; i < num; ++i) {
+		b->angle[i] = carg(in->args0[i]);
+	}
+
+	for(uint i = 0; i < num; ++i) {
+		double x = creal(out->pos[i]);
+		double y = cimag(out->pos[i]);
+		double w = b->half_w[i];
+		double h = b->half_h[i];
+		double e = b->margin[i];
+
+		b->in_viewport[i] = !(
+			x + w + e < 0 || x - w - e > VIEWPORT_W ||
+			y + h + e < 0 || y - h - e > VIEWPORT_H
+		);
+	}
+
+	memcpy(out->valid, in->valid, num * sizeof(*out->valid));
+	memset(b->applied, 0, num * sizeof(*b->applied));
+}
+
+void proj_motion_init(void) {
+	memset(lanes, 0, sizeof(lanes));
+}
+
+void proj_motion_shutdown(void) {
+	for(uint l = 0; l < NUM_LANES; ++l) {
+		for(uint r = 0; r < NUM_PROJ_MOTION_RULES; ++r) {
+			if(lanes[l].batches[r].num) {
+				log_warn("%u projectiles were not removed from motion lane %u", lanes[l].batches[r].num, l);
+			}
+
+			batch_free(lanes[l].batches + r);
+		}
+	}
+}
+
+void proj_motion_rebuild(void) {
+	for(uint l = 0; l < NUM_LANES; ++l) {
+		for(uint r = 0; r < NUM_PROJ_MOTION_RULES; ++r) {
+			lanes[l].batches[r].num = 0;
+		}
+
+		lanes[l].in_frame = false;
+	}
+
+	ProjectileList *lists[] = { &global.projs, &global.particles };
+
+	for(uint i = 0; i < ARRAY_SIZE(lists); ++i) {
+		for(Projectile *p = lists[i]->first; p; p = p->next) {
+			p->motion = (ProjMotionSlot) { 0 };
+			proj_motion_attach(p, lists[i]);
+		}
+	}
+}
+
+void proj_motion_begin_frame(ProjectileList *projlist) {
+	uint8_t l = lane_id(projlist);
+
+	if(l == LANE_NONE) {
+		return;
+	}
+
+	MotionLane *lane = lanes + l;
+	assert(!lane->in_frame);
+
+	lane->frame = global.frames;
+	lane->in_frame = true;
+
+	for(ProjMotionRule r = PROJ_MOTION_NONE + 1; r < NUM_PROJ_MOTION_RULES; ++r) {
+		batch_step(lane->batches + r, r, lane->frame);
+	}
+}
+
+void proj_motion_end_frame(ProjectileList *projlist) {
+	uint8_t l = lane_id(projlist);
+
+	if(l == LANE_NONE) {
+		return;
+	}
+
+	MotionLane *lane = lanes + l;
+	assert(lane->in_frame);
+	lane->in_frame = false;
+
+	for(ProjMotionRule r = PROJ_MOTION_NONE + 1; r < NUM_PROJ_MOTION_RULES; ++r) {
+		lane->batches[r].in_buffer ^= 1;
+	}
+}
+
+void proj_motion_attach(Projectile *p, ProjectileList *projlist) {
+	assert(p->motion.lane == LANE_NONE);
+	p->motion.lane = lane_id(projlist);
+	proj_motion_update(p);
+}
+
+void proj_motion_detach(Projectile *p) {
+	if(p->motion.rule != PROJ_MOTION_NONE) {
+		batch_remove(lanes[p->motion.lane].batches + p->motion.rule, p->motion.index);
+	}
+
+	p->motion.lane = LANE_NONE;
+	p->motion.rule = PROJ_MOTION_NONE;
+}
+
+// Whether the kernel started from the current state of p, i.e. its output is what the rule would produce.
+static bool motion_input_matches(Projectile *p, int t) {
+	if(p->motion.rule == PROJ_MOTION_NONE) {
+		return false;
+	}
+
+	MotionLane *lane = lanes + p->motion.lane;
+	MotionBatch *b = lane->batches + p->motion.rule;
+	MotionBuffer *in = batch_input(b);
+	uint i = p->motion.index;
+
+	assert(b->projs[i] == p);
+
+	return
+		lane->in_frame &&
+		in->valid[i] &&
+		t == lane->frame - b->birthtime[i] &&
+		p->rule == motion_rule_func(p->motion.rule) &&
+		p->birthtime == b->birthtime[i] &&
+		cmplx_identical(p->pos, in->pos[i]) &&
+		cmplx_identical(p->pos0, b->pos0[i]) &&
+		cmplx_identical(p->args[0], in->args0[i]) &&
+		cmplx_identical(p->args[1], in->args1[i]);
+}
+
+bool proj_motion_apply(Projectile *p, int t, int *out_result) {
+	if(!motion_input_matches(p, t)) {
+		return false;
+	}
+
+	MotionLane *lane = lanes + p->motion.lane;
+	MotionBatch *b = lane->batches + p->motion.rule;
+	uint i = p->motion.index;
+	MotionBuffer *out = batch_output(b);
+	p->pos = out->pos[i];
+	p->args[0] = out->args0[i];
+	p->args[1] = out->args1[i];
+	p->angle = b->angle[i];
+	b->applied[i] = true;
+
+	// Same as what the rules themselves return
+	*out_result = p->motion.rule == PROJ_MOTION_LINEAR ? ACTION_NONE : 1;
+	return true;
+}
+
+bool proj_motion_predict(Projectile *p, complex *out_pos, float *out_angle) {
+	if(!motion_input_matches(p, global.frames - p->birthtime)) {
+		return false;
+	}
+
+	MotionBatch *b = lanes[p->motion.lane].batches + p->motion.rule;
+	*out_pos = batch_output(b)->pos[p->motion.index];
+	*out_angle = b->angle[p->motion.index];
+	return true;
+}
+
+void proj_motion_update(Projectile *p) {
+	if(p->motion.lane == LANE_NONE) {
+		return;
+	}
+
+	MotionLane *lane = lanes + p->motion.lane;
+	ProjMotionRule rule = motion_rule_id(p->rule);
+
+	if(rule != p->motion.rule) {
+		if(p->motion.rule != PROJ_MOTION_NONE) {
+			batch_remove(lane->batches + p->motion.rule, p->motion.index);
+		}
+
+		p->motion.rule = rule;
+
+		if(rule != PROJ_MOTION_NONE) {
+			batch_add(lane, lane->batches + rule, p);
+		}
+	}
+
+	if(rule != PROJ_MOTION_NONE) {
+		batch_store(lane, lane->batches + rule, p->motion.index, p);
+	}
+}
+
+bool proj_motion_in_viewport(Projectile *p, bool *out_in_viewport) {
+	if(p->motion.rule == PROJ_MOTION_NONE) {
+		return false;
+	}
+
+	MotionLane *lane = lanes + p->motion.lane;
+	MotionBatch *b = lane->batches + p->motion.rule;
+	uint i = p->motion.index;
+
+	// Only valid if the position was produced by the kernel and not touched since.
+	if(!lane->in_frame || !b->applied[i] || !cmplx_identical(p->pos, batch_output(b)->pos[i])) {
+		return false;
+	}
+
+	// Nor if the size has changed since the kernel ran.
+	if(batch_store_extents(b, i, p)) {
+		return false;
+	}
+
+	*out_in_viewport = b->in_viewport[i];
+	return true;
+}
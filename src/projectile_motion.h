@@ -0,0 +1,88 @@
+/*
+ * This software is licensed under the terms of the MIT-License
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2019, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2019, Andrei Alexeyev <akari@alienslab.net>.
+ */
+
+#ifndef IGUARD_projectile_motion_h
+#define IGUARD_projectile_motion_h
+
+#include "taisei.h"
+
+#include "projectile.h"
+
+/*
+ * Structure-of-arrays "fast lane" for projectiles driven by one of the built-in
+ * motion rules (linear, accelerated, asymptotic).
+ *
+ * At the start of process_projectiles, the whole lane is advanced by a batched
+ * kernel that only touches contiguous arrays. When the main loop reaches a laned
+ * projectile, the precomputed result is copied into it instead of calling the
+ * rule, but only if the projectile's motion state still matches what the kernel
+ * started from. If anything modified the projectile in the meantime, the rule is
+ * called as usual and the lane is resynchronized. Either way, the outcome is
+ * bit-identical to calling the rule directly.
+ *
+ * Projectiles with custom rules never enter the lane.
+ */
+
+typedef enum ProjMotionRule {
+	PROJ_MOTION_NONE,
+	PROJ_MOTION_LINEAR,
+	PROJ_MOTION_ACCELERATED,
+	PROJ_MOTION_ASYMPTOTIC,
+	NUM_PROJ_MOTION_RULES,
+} ProjMotionRule;
+
+/*
+ * The motion rules themselves are defined in terms of these, so that the batched
+ * kernel evaluates exactly the same expressions.
+ */
+
+static inline attr_must_inline
+complex proj_motion_linear_pos(complex pos0, complex velocity, int t) {
+	return pos0 + velocity * t;
+}
+
+static inline attr_must_inline
+void proj_motion_accelerated_step(complex *pos, complex *velocity, complex acceleration) {
+	*pos += *velocity;
+	*velocity += acceleration;
+}
+
+static inline attr_must_inline
+void proj_motion_asymptotic_step(complex *pos, complex velocity, complex *boost) {
+	*boost *= 0.8;
+	*pos += velocity * (*boost + 1);
+}
+
+void proj_motion_init(void);
+void proj_motion_shutdown(void);
+
+// Called around the main loop of process_projectiles.
+void proj_motion_begin_frame(ProjectileList *projlist);
+void proj_motion_end_frame(ProjectileList *projlist);
+
+// Called when a projectile is spawned into projlist / deleted.
+void proj_motion_attach(Projectile *p, ProjectileList *projlist);
+void proj_motion_detach(Projectile *p);
+
+// Repopulates the lanes from global.projs and global.particles, which may have been overwritten
+// wholesale, e.g. by a game state snapshot. Only call this between frames.
+void proj_motion_rebuild(void);
+
+// Tries to apply the precomputed step for frame t. Returns false if the rule must be called instead.
+bool proj_motion_apply(Projectile *p, int t, int *out_result);
+
+// Returns true and stores the position and angle that proj_motion_apply would produce for p at this point.
+bool proj_motion_predict(Projectile *p, complex *out_pos, float *out_angle);
+
+// Resynchronizes the lane after the rule of a projectile has been called directly.
+void proj_motion_update(Projectile *p);
+
+// Returns true and stores the viewport test result computed by the kernel, if it is known to be accurate.
+bool proj_motion_in_viewport(Projectile *p, bool *out_in_viewport);
+
+#endif // IGUARD_projectile_motion_h
@@ -8,14 +8,10 @@
 
 #include "taisei.h"
 
-#include "global.h"
 #include "refs.h"
-
-/*
- * NOTE: if you're here to attempt fixing any of this braindeath, better just delete the file and start over
- */
-
-void *_FREEREF;
+#include "hashtable.h"
+#include "log.h"
+#include "util.h"
 
 #ifdef DEBUG
 	// #define DEBUG_REFS
@@ -27,71 +23,252 @@ void *_FREEREF;
 	#define REFLOG(...)
 #endif
 
-int add_ref(void *ptr) {
-	int i, firstfree = -1;
+#define REF_INDEX_BITS 18
+#define REF_INDEX_MASK ((1u << REF_INDEX_BITS) - 1)
+#define REF_GENERATION_MASK ((1u << (31 - REF_INDEX_BITS)) - 1)
 
-	for(i = 0; i < global.refs.count; i++) {
-		if(global.refs.ptrs[i].ptr == ptr) {
-			global.refs.ptrs[i].refs++;
-			REFLOG("increased refcount for %p (ref %i): %i", ptr, i, global.refs.ptrs[i].refs);
-			return i;
-		} else if(firstfree < 0 && global.refs.ptrs[i].ptr == FREEREF) {
-			firstfree = i;
-		}
+typedef struct RefSlot {
+	void *ptr;
+	int refs;
+	uint generation;
+	uint next_free;
+} RefSlot;
+
+typedef struct RefTable {
+	RefSlot *slots;
+	uint num_slots;
+	uint capacity;
+	uint first_free;
+	uint in_use;
+	ht_ptr2int_t ptr_map;
+} RefTable;
+
+static RefTable ref_table;
+
+// Slot 0 is never handed out, so that REF_NULL (and zero-initialized arguments) never resolve to anything.
+#define REF_FIRST_SLOT 1
+#define REF_NO_SLOT 0
+
+static inline RefHandle make_handle(uint index, uint generation) {
+	return (RefHandle)((generation << REF_INDEX_BITS) | index);
+}
+
+static RefSlot *handle_slot(RefTable *t, RefHandle h) {
+	uint index = (uint)h & REF_INDEX_MASK;
+	uint generation = (uint)h >> REF_INDEX_BITS;
+
+	if(h <= 0 || index < REF_FIRST_SLOT || index >= t->num_slots || t->slots[index].generation != generation) {
+		return NULL;
 	}
 
-	if(firstfree >= 0) {
-		global.refs.ptrs[firstfree].ptr = ptr;
-		global.refs.ptrs[firstfree].refs = 1;
-		REFLOG("found free ref for %p: %i", ptr, firstfree);
-		return firstfree;
+	return t->slots + index;
+}
+
+static uint alloc_slot(RefTable *t) {
+	if(t->first_free != REF_NO_SLOT) {
+		uint index = t->first_free;
+		t->first_free = t->slots[index].next_free;
+		return index;
 	}
 
-	global.refs.ptrs = realloc(global.refs.ptrs, (++global.refs.count)*sizeof(Reference));
-	global.refs.ptrs[global.refs.count - 1].ptr = ptr;
-	global.refs.ptrs[global.refs.count - 1].refs = 1;
-	REFLOG("new ref for %p: %i", ptr, global.refs.count - 1);
+	if(t->slots == NULL) {
+		ht_create(&t->ptr_map);
+		t->capacity = 64;
+		t->slots = calloc(t->capacity, sizeof(*t->slots));
+		t->num_slots = REF_FIRST_SLOT;
+	}
+
+	if(t->num_slots > REF_INDEX_MASK) {
+		log_fatal("Too many references in use");
+	}
 
-	return global.refs.count - 1;
+	if(t->num_slots == t->capacity) {
+		t->capacity *= 2;
+		t->slots = realloc(t->slots, t->capacity * sizeof(*t->slots));
+	}
+
+	uint index = t->num_slots++;
+	t->slots[index] = (RefSlot) { 0 };
+	return index;
+}
+
+static void free_slot(RefTable *t, uint index) {
+	RefSlot *s = t->slots + index;
+	s->ptr = NULL;
+	s->refs = 0;
+	s->generation = (s->generation + 1) & REF_GENERATION_MASK;
+	s->next_free = t->first_free;
+	t->first_free = index;
+}
+
+void *ref_resolve(RefHandle h) {
+	RefSlot *s = handle_slot(&ref_table, h);
+	return s ? s->ptr : NULL;
 }
 
-void del_ref(void *ptr) {
-	int i;
+RefHandle ref_acquire(void *ptr) {
+	RefTable *t = &ref_table;
+	int64_t h;
+
+	if(t->slots != NULL && ht_lookup(&t->ptr_map, ptr, &h)) {
+		RefSlot *s = handle_slot(t, h);
+		assert(s != NULL);
+		s->refs++;
+		REFLOG("increased refcount for %p (ref %i): %i", ptr, (RefHandle)h, s->refs);
+		return h;
+	}
+
+	uint index = alloc_slot(t);
+	RefSlot *s = t->slots + index;
+	s->ptr = ptr;
+	s->refs = 1;
+	t->in_use++;
+
+	h = make_handle(index, s->generation);
+	ht_set(&t->ptr_map, ptr, h);
+	REFLOG("new ref for %p: %i", ptr, (RefHandle)h);
 
-	for(i = 0; i < global.refs.count; i++)
-		if(global.refs.ptrs[i].ptr == ptr)
-			global.refs.ptrs[i].ptr = NULL;
+	return h;
 }
 
-void free_ref(int i) {
-	if(i < 0)
+void ref_release(RefHandle h) {
+	RefTable *t = &ref_table;
+	RefSlot *s = handle_slot(t, h);
+
+	if(s == NULL) {
+		REFLOG("ref %i is not valid", h);
 		return;
+	}
 
-	global.refs.ptrs[i].refs--;
-	REFLOG("decreased refcount for %p (ref %i): %i", global.refs.ptrs[i].ptr, i, global.refs.ptrs[i].refs);
+	s->refs--;
+	REFLOG("decreased refcount for %p (ref %i): %i", s->ptr, h, s->refs);
+
+	if(s->refs <= 0) {
+		if(s->ptr != NULL) {
+			ht_unset(&t->ptr_map, s->ptr);
+		}
 
-	if(global.refs.ptrs[i].refs <= 0) {
-		global.refs.ptrs[i].ptr = FREEREF;
-		global.refs.ptrs[i].refs = 0;
-		REFLOG("ref %i is now free", i);
+		free_slot(t, s - t->slots);
+		t->in_use--;
+		REFLOG("ref %i is now free", h);
 	}
 }
 
-void free_all_refs(void) {
-	int inuse = 0;
-	int inuse_unique = 0;
+void ref_invalidate(void *ptr) {
+	RefTable *t = &ref_table;
+	int64_t h;
 
-	for(int i = 0; i < global.refs.count; i++) {
-		if(global.refs.ptrs[i].refs) {
-			inuse += global.refs.ptrs[i].refs;
-			inuse_unique += 1;
+	if(t->in_use == 0 || !ht_lookup(&t->ptr_map, ptr, &h)) {
+		return;
+	}
+
+	// Keep the slot around until all of its handles are released, but forget the object.
+	// If another object is allocated at the same address later, it will get a new slot.
+	RefSlot *s = handle_slot(t, h);
+	assert(s != NULL);
+	s->ptr = NULL;
+	ht_unset(&t->ptr_map, ptr);
+	REFLOG("invalidated ref %i for %p", (RefHandle)h, ptr);
+}
+
+void ref_release_all(void) {
+	RefTable *t = &ref_table;
+
+	if(t->slots == NULL) {
+		return;
+	}
+
+	if(t->in_use) {
+		int inuse = 0;
+
+		for(uint i = REF_FIRST_SLOT; i < t->num_slots; ++i) {
+			inuse += t->slots[i].refs;
+		}
+
+		log_warn("%i refs were still in use (%u unique, %u total allocated)", inuse, t->in_use, t->num_slots - REF_FIRST_SLOT);
+	}
+
+	ht_destroy(&t->ptr_map);
+	free(t->slots);
+	memset(t, 0, sizeof(*t));
+}
+
+void ref_relocate(void *old_ptr, void *new_ptr) {
+	RefTable *t = &ref_table;
+	int64_t h;
+
+	if(t->in_use == 0 || !ht_lookup(&t->ptr_map, old_ptr, &h)) {
+		return;
+	}
+
+	RefSlot *s = handle_slot(t, h);
+	assert(s != NULL);
+	s->ptr = new_ptr;
+	ht_unset(&t->ptr_map, old_ptr);
+	ht_set(&t->ptr_map, new_ptr, h);
+}
+
+struct RefSnapshot {
+	RefSlot *slots;
+	uint num_slots;
+	uint first_free;
+	uint in_use;
+};
+
+RefSnapshot *ref_snapshot(void) {
+	RefTable *t = &ref_table;
+	RefSnapshot *snap = calloc(1, sizeof(*snap));
+
+	if(t->slots != NULL) {
+		snap->slots = memdup(t->slots, t->num_slots * sizeof(*t->slots));
+		snap->num_slots = t->num_slots;
+		snap->first_free = t->first_free;
+		snap->in_use = t->in_use;
+	}
+
+	return snap;
+}
+
+void ref_snapshot_restore(RefSnapshot *snap) {
+	RefTable *t = &ref_table;
+
+	if(t->slots == NULL) {
+		if(snap->slots == NULL) {
+			return;
 		}
+
+		ht_create(&t->ptr_map);
+		t->capacity = 64;
+		t->slots = calloc(t->capacity, sizeof(*t->slots));
+	} else {
+		ht_unset_all(&t->ptr_map);
 	}
 
-	if(inuse) {
-		log_warn("%i refs were still in use (%i unique, %i total allocated)", inuse, inuse_unique, global.refs.count);
+	if(t->capacity < snap->num_slots) {
+		t->capacity = snap->num_slots;
+		t->slots = realloc(t->slots, t->capacity * sizeof(*t->slots));
 	}
 
-	free(global.refs.ptrs);
-	memset(&global.refs, 0, sizeof(RefArray));
+	if(snap->slots != NULL) {
+		memcpy(t->slots, snap->slots, snap->num_slots * sizeof(*t->slots));
+		t->num_slots = snap->num_slots;
+	} else {
+		t->num_slots = REF_FIRST_SLOT;
+	}
+
+	t->first_free = snap->first_free;
+	t->in_use = snap->in_use;
+
+	for(uint i = REF_FIRST_SLOT; i < t->num_slots; ++i) {
+		RefSlot *s = t->slots + i;
+
+		if(s->refs > 0 && s->ptr != NULL) {
+			ht_set(&t->ptr_map, s->ptr, make_handle(i, s->generation));
+		}
+	}
+}
+
+void ref_snapshot_free(RefSnapshot *snap) {
+	free(snap->slots);
+	free(snap);
 }
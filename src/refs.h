@@ -12,25 +12,55 @@
 #include "taisei.h"
 
 /*
- * NOTE: if you're here to attempt fixing any of this braindeath, better just delete the file and start over
+ * Generational handles to arbitrary objects, mostly entities.
+ *
+ * A handle is a slot index plus the generation of that slot at the time the handle
+ * was acquired, packed into a non-negative int so that it can be stored in rule
+ * arguments. A slot's generation changes whenever it's released and recycled, so a
+ * handle outliving its slot simply resolves to NULL instead of some other object.
+ *
+ * Handles are reference-counted: acquiring a handle to an object that already has
+ * one returns the same handle. Each ref_acquire must be paired with a ref_release.
+ * When the object itself dies, ref_invalidate must be called on it; existing handles
+ * then resolve to NULL, but stay valid for ref_release. For entities, ent_unregister
+ * takes care of that.
+ *
+ * Acquire, resolve, release and invalidate are all O(1).
  */
 
-typedef struct {
-	void *ptr;
-	int refs;
-} Reference;
-
-typedef struct {
-	Reference *ptrs;
-	int count;
-} RefArray;
-
-extern void *_FREEREF;
-#define FREEREF &_FREEREF
-#define REF(p) (global.refs.ptrs[(int)(p)].ptr)
-int add_ref(void *ptr);
-void del_ref(void *ptr);
-void free_ref(int i);
-void free_all_refs(void);
+typedef int RefHandle;
+
+#define REF_NULL 0
+
+RefHandle ref_acquire(void *ptr);
+void *ref_resolve(RefHandle h) attr_pure;
+void ref_release(RefHandle h);
+void ref_invalidate(void *ptr);
+void ref_release_all(void);
+
+// Points the handles of an object that has been moved in memory to its new address.
+void ref_relocate(void *old_ptr, void *new_ptr);
+
+/*
+ * Copies of the whole table, for game state snapshots. Handles stored anywhere in the
+ * snapshotted state resolve to the same objects again after a restore, as long as those
+ * objects are back at their old addresses (or have been ref_relocate'd).
+ */
+
+typedef struct RefSnapshot RefSnapshot;
+
+RefSnapshot *ref_snapshot(void) attr_returns_nonnull attr_nodiscard;
+void ref_snapshot_restore(RefSnapshot *snap) attr_nonnull(1);
+void ref_snapshot_free(RefSnapshot *snap) attr_nonnull(1);
+
+/*
+ * Compatibility layer for the old refs API.
+ */
+
+#define REF(p) ref_resolve((RefHandle)(p))
+#define add_ref(ptr) ref_acquire(ptr)
+#define del_ref(ptr) ref_invalidate(ptr)
+#define free_ref(h) ref_release(h)
+#define free_all_refs() ref_release_all()
 
 #endif // IGUARD_refs_h
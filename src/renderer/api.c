@@ -26,7 +26,12 @@ static struct {
 		ShaderProgram *standard;
 		ShaderProgram *standardnotex;
 	} progs;
-} R;
+
+	// Bumped whenever a program is linked or destroyed; see UniformCache.
+	uint32_t shader_generation;
+} R = {
+	.shader_generation = 1,
+};
 
 void r_init(void) {
 	_r_backend_init();
@@ -47,7 +52,6 @@ void r_post_init(void) {
 
 	preload_resources(RES_SHADER_PROGRAM, RESF_PERMANENT,
 		"sprite_default",
-		"texture_post_load",
 		"standard",
 		"standardnotex",
 	NULL);
@@ -265,7 +269,7 @@ void r_capability(RendererCapability cap, bool value) {
 		newcaps = caps & ~r_capability_bit(cap);
 	}
 
-	if(caps != newcaps) {
+	if(!_r_state_redundant(caps == newcaps)) {
 		_r_state_touch_capabilities();
 		B.capabilities(newcaps);
 	}
@@ -276,6 +280,12 @@ bool r_capability_current(RendererCapability cap) {
 }
 
 void r_color4(float r, float g, float b, float a) {
+	const Color *c = B.color_current();
+
+	if(_r_state_redundant(c->r == r && c->g == g && c->b == b && c->a == a)) {
+		return;
+	}
+
 	_r_state_touch_color();
 	B.color4(r, g, b, a);
 }
@@ -285,6 +295,10 @@ const Color* r_color_current(void) {
 }
 
 void r_blend(BlendMode mode) {
+	if(_r_state_redundant(mode == B.blend_current())) {
+		return;
+	}
+
 	_r_state_touch_blend_mode();
 	B.blend(mode);
 }
@@ -294,6 +308,10 @@ BlendMode r_blend_current(void) {
 }
 
 void r_cull(CullFaceMode mode) {
+	if(_r_state_redundant(mode == B.cull_current())) {
+		return;
+	}
+
 	_r_state_touch_cull_mode();
 	B.cull(mode);
 }
@@ -303,6 +321,10 @@ CullFaceMode r_cull_current(void) {
 }
 
 void r_depth_func(DepthTestFunc func) {
+	if(_r_state_redundant(func == B.depth_func_current())) {
+		return;
+	}
+
 	_r_state_touch_depth_func();
 	B.depth_func(func);
 }
@@ -332,10 +354,12 @@ const char* r_shader_object_get_debug_label(ShaderObject *shobj) {
 }
 
 ShaderProgram* r_shader_program_link(uint num_objects, ShaderObject *shobjs[num_objects]) {
+	++R.shader_generation;
 	return B.shader_program_link(num_objects, shobjs);
 }
 
 void r_shader_program_destroy(ShaderProgram *prog) {
+	++R.shader_generation;
 	B.shader_program_destroy(prog);
 }
 
@@ -348,6 +372,10 @@ const char* r_shader_program_get_debug_label(ShaderProgram *prog) {
 }
 
 void r_shader_ptr(ShaderProgram *prog) {
+	if(_r_state_redundant(prog == B.shader_current())) {
+		return;
+	}
+
 	_r_state_touch_shader();
 	B.shader(prog);
 }
@@ -356,6 +384,10 @@ ShaderProgram* r_shader_current(void) {
 	return B.shader_current();
 }
 
+void r_stage_time(float seconds) {
+	B.stage_time(seconds);
+}
+
 Uniform* r_shader_uniform(ShaderProgram *prog, const char *uniform_name) {
 	return B.shader_uniform(prog, uniform_name);
 }
@@ -364,6 +396,26 @@ UniformType r_uniform_type(Uniform *uniform) {
 	return B.uniform_type(uniform);
 }
 
+Uniform* r_shader_uniform_cached(ShaderProgram *prog, UniformCache *cache) {
+	if(cache->generation != R.shader_generation) {
+		memset(cache->entries, 0, sizeof(cache->entries));
+		cache->generation = R.shader_generation;
+	} else {
+		for(uint i = 0; i < ARRAY_SIZE(cache->entries); ++i) {
+			if(cache->entries[i].prog == prog) {
+				return cache->entries[i].uniform;
+			}
+		}
+	}
+
+	uint slot = cache->next_slot;
+	cache->next_slot = (slot + 1) % ARRAY_SIZE(cache->entries);
+	cache->entries[slot].prog = prog;
+	cache->entries[slot].uniform = r_shader_uniform(prog, cache->name);
+
+	return cache->entries[slot].uniform;
+}
+
 void r_draw(VertexArray *varr, Primitive prim, uint firstvert, uint count, uint instances, uint base_instance) {
 	B.draw(varr, prim, firstvert, count, instances, base_instance);
 }
@@ -420,6 +472,18 @@ void r_texture_fill_region(Texture *tex, uint mipmap, uint x, uint y, const Pixm
 	B.texture_fill_region(tex, mipmap, x, y, image_data);
 }
 
+void r_texture_fill_async(Texture *tex, uint mipmap, const Pixmap *image_data) {
+	B.texture_fill_async(tex, mipmap, image_data);
+}
+
+bool r_texture_is_resident(Texture *tex) {
+	return B.texture_is_resident(tex);
+}
+
+void r_texture_upload_stats(TextureUploadStats *stats) {
+	B.texture_upload_stats(stats);
+}
+
 void r_texture_invalidate(Texture *tex) {
 	B.texture_invalidate(tex);
 }
@@ -479,6 +543,10 @@ void r_framebuffer_destroy(Framebuffer *fb) {
 }
 
 void r_framebuffer(Framebuffer *fb) {
+	if(_r_state_redundant(fb == B.framebuffer_current())) {
+		return;
+	}
+
 	_r_state_touch_framebuffer();
 	B.framebuffer(fb);
 }
@@ -589,9 +657,22 @@ VsyncMode r_vsync_current(void) {
 
 void r_swap(SDL_Window *window) {
 	_r_sprite_batch_end_frame();
+	_r_state_end_frame();
 	B.swap(window);
 }
 
+void r_gpu_timer_begin(const char *name) {
+	B.gpu_timer_begin(name);
+}
+
+void r_gpu_timer_end(void) {
+	B.gpu_timer_end();
+}
+
+void r_gpu_timer_stats(GPUTimerStats *stats) {
+	B.gpu_timer_stats(stats);
+}
+
 bool r_screenshot(Pixmap *out) {
 	return B.screenshot(out);
 }
@@ -13,6 +13,7 @@
 
 #include "util.h"
 #include "util/pixmap.h"
+#include "hirestime.h"
 #include "color.h"
 #include "common/shaderlib/shaderlib.h"
 #include "resource/resource.h"
@@ -38,6 +39,7 @@ typedef enum RendererFeature {
 	RFEAT_DEPTH_TEXTURE,
 	RFEAT_FRAMEBUFFER_MULTIPLE_OUTPUTS,
 	RFEAT_TEXTURE_BOTTOMLEFT_ORIGIN,
+	RFEAT_UNIFORM_BUFFERS,
 
 	NUM_RFEATS,
 } RendererFeature;
@@ -393,6 +395,66 @@ typedef struct SpriteParams {
 	} flip;
 } attr_designated_init SpriteParams;
 
+#define UNIFORM_CACHE_ENTRIES 4
+
+/*
+ * Remembers where a uniform is in the last few shader programs it was looked up in,
+ * so that hot draw paths don't have to hash the name on every call. Meant to be used
+ * as a static variable at the call site:
+ *
+ *     static UniformCache u_width = UNIFORM_CACHE("width");
+ *     r_uniform_float(r_uniform_cached(&u_width), l->width);
+ *
+ * Entries are invalidated whenever a shader program is linked or destroyed.
+ */
+typedef struct UniformCache {
+	const char *name;
+	uint32_t generation;
+	uint8_t next_slot;
+
+	struct {
+		ShaderProgram *prog;
+		Uniform *uniform;
+	} entries[UNIFORM_CACHE_ENTRIES];
+} UniformCache;
+
+#define UNIFORM_CACHE(uniform_name) { .name = (uniform_name) }
+
+typedef struct RendererStateStats {
+	uint changes;  // state changes passed on to the backend
+	uint avoided;  // redundant ones that were dropped
+} RendererStateStats;
+
+typedef struct TextureUploadStats {
+	size_t frame_bytes;    // uploaded during the last frame
+	size_t pending_bytes;  // still queued
+	hrtime_t frame_time;   // time spent uploading during the last frame
+	uint pending;          // textures that are not resident yet
+	uint hitches;          // frames where uploads went over the time budget, or had to be forced
+} TextureUploadStats;
+
+typedef struct SpriteBatchStats {
+	uint sprites;
+	uint flushes;
+	uint reordered;  // sprites that went through a reorder scope
+	size_t bytes;    // instance data streamed to the GPU
+} SpriteBatchStats;
+
+enum {
+	R_GPU_TIMER_MAX_PASSES = 16,
+	R_GPU_TIMER_NAME_SIZE = 32,
+};
+
+typedef struct GPUTimerStats {
+	struct {
+		char name[R_GPU_TIMER_NAME_SIZE];
+		hrtime_t time;
+	} passes[R_GPU_TIMER_MAX_PASSES];
+	uint num_passes;
+	uint latency;    // how many frames ago these were recorded
+	bool available;  // false if the backend can't time the GPU, or it's disabled
+} GPUTimerStats;
+
 /*
  * Creates an SDL window with proper flags, and, if needed, sets up a rendering context associated with it.
  * Must be called before anything else.
@@ -441,8 +503,12 @@ const char* r_shader_program_get_debug_label(ShaderProgram *prog) attr_nonnull(1
 void r_shader_ptr(ShaderProgram *prog) attr_nonnull(1);
 ShaderProgram* r_shader_current(void) attr_returns_nonnull;
 
+// Exposed to all shaders as r_stageTime (seconds); set once per frame.
+void r_stage_time(float seconds);
+
 Uniform* r_shader_uniform(ShaderProgram *prog, const char *uniform_name) attr_nonnull(1, 2);
 UniformType r_uniform_type(Uniform *uniform);
+Uniform* r_shader_uniform_cached(ShaderProgram *prog, UniformCache *cache) attr_nonnull(1, 2);
 void r_uniform_ptr_unsafe(Uniform *uniform, uint offset, uint count, void *data);
 
 #define _R_UNIFORM_GENERIC(suffix, uniform, ...) (_Generic((uniform), \
@@ -626,6 +692,17 @@ void r_texture_set_filter(Texture *tex, TextureFilterMode fmin, TextureFilterMod
 void r_texture_set_wrap(Texture *tex, TextureWrapMode ws, TextureWrapMode wt) attr_nonnull(1);
 void r_texture_fill(Texture *tex, uint mipmap, const Pixmap *image_data) attr_nonnull(1, 3);
 void r_texture_fill_region(Texture *tex, uint mipmap, uint x, uint y, const Pixmap *image_data) attr_nonnull(1, 5);
+
+/*
+ * Like r_texture_fill, but the data is only queued up, and streamed to the GPU over the
+ * next few frames. The image is copied, so the caller may free it right away.
+ * Until the upload completes, the texture is not resident; drawing with it forces the
+ * remaining part through immediately.
+ */
+void r_texture_fill_async(Texture *tex, uint mipmap, const Pixmap *image_data) attr_nonnull(1, 3);
+bool r_texture_is_resident(Texture *tex) attr_nonnull(1);
+void r_texture_upload_stats(TextureUploadStats *stats) attr_nonnull(1);
+
 void r_texture_invalidate(Texture *tex) attr_nonnull(1);
 void r_texture_clear(Texture *tex, const Color *clr) attr_nonnull(1, 2);
 void r_texture_destroy(Texture *tex) attr_nonnull(1);
@@ -678,6 +755,20 @@ VsyncMode r_vsync_current(void);
 
 void r_swap(SDL_Window *window);
 
+/*
+ * GPU timing of render passes. Everything rendered between r_gpu_timer_begin and the matching
+ * r_gpu_timer_end counts towards the named pass; passes of the same name are summed up over the
+ * frame. Passes may nest, in which case the time of the inner one is not counted towards the
+ * outer one. The results are read back a few frames late, so that we never stall on the GPU.
+ * Does nothing if the backend can't do timer queries. While timing, the sprite batch is flushed
+ * at pass boundaries; otherwise passes don't affect batching.
+ */
+void r_gpu_timer_begin(const char *name) attr_nonnull(1);
+void r_gpu_timer_end(void);
+
+// Returns the timings of the most recent frame that has them ready.
+void r_gpu_timer_stats(GPUTimerStats *stats) attr_nonnull(1);
+
 bool r_screenshot(Pixmap *dest) attr_nodiscard attr_nonnull(1);
 
 void r_mat_mode(MatrixMode mode);
@@ -703,6 +794,7 @@ VertexArray* r_vertex_array_static_models(void) attr_returns_nonnull;
 
 void r_state_push(void);
 void r_state_pop(void);
+void r_state_stats(RendererStateStats *stats) attr_nonnull(1);
 
 void r_draw_quad(void);
 void r_draw_quad_instanced(uint instances);
@@ -711,6 +803,15 @@ void r_draw_sprite(const SpriteParams *params) attr_nonnull(1);
 
 void r_flush_sprites(void);
 
+// Sprites drawn between these calls may be drawn in any order, so that ones with the same
+// render state end up in the same batch. Only use this where the order doesn't matter visually.
+// Scopes may be nested; the sprites are drawn when the outermost one ends, or on r_flush_sprites.
+void r_sprite_reorder_begin(void);
+void r_sprite_reorder_end(void);
+
+// Returns the counters of the last complete frame.
+void r_sprite_batch_stats(SpriteBatchStats *stats) attr_nonnull(1);
+
 BlendMode r_blend_compose(
 	BlendFactor src_color, BlendFactor dst_color, BlendOp color_op,
 	BlendFactor src_alpha, BlendFactor dst_alpha, BlendOp alpha_op
@@ -809,6 +910,11 @@ Uniform* r_shader_current_uniform(const char *name) {
 	return r_shader_uniform(r_shader_current(), name);
 }
 
+static inline attr_must_inline attr_nonnull(1)
+Uniform* r_uniform_cached(UniformCache *cache) {
+	return r_shader_uniform_cached(r_shader_current(), cache);
+}
+
 static inline attr_must_inline
 void r_clear(ClearBufferFlags flags, const Color *colorval, float depthval) {
 	r_framebuffer_clear(r_framebuffer_current(), flags, colorval, depthval);
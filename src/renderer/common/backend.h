@@ -54,6 +54,7 @@ typedef struct RendererFuncs {
 
 	void (*shader)(ShaderProgram *prog);
 	ShaderProgram* (*shader_current)(void);
+	void (*stage_time)(float seconds);
 
 	Uniform* (*shader_uniform)(ShaderProgram *prog, const char *uniform_name);
 	void (*uniform)(Uniform *uniform, uint offset, uint count, const void *data);
@@ -70,6 +71,9 @@ typedef struct RendererFuncs {
 	void (*texture_invalidate)(Texture *tex);
 	void (*texture_fill)(Texture *tex, uint mipmap, const Pixmap *image_data);
 	void (*texture_fill_region)(Texture *tex, uint mipmap, uint x, uint y, const Pixmap *image_data);
+	void (*texture_fill_async)(Texture *tex, uint mipmap, const Pixmap *image_data);
+	bool (*texture_is_resident)(Texture *tex);
+	void (*texture_upload_stats)(TextureUploadStats *stats);
 	void (*texture_clear)(Texture *tex, const Color *clr);
 
 	Framebuffer* (*framebuffer_create)(void);
@@ -117,6 +121,10 @@ typedef struct RendererFuncs {
 
 	void (*swap)(SDL_Window *window);
 
+	void (*gpu_timer_begin)(const char *name);
+	void (*gpu_timer_end)(void);
+	void (*gpu_timer_stats)(GPUTimerStats *stats);
+
 	bool (*screenshot)(Pixmap *dst);
 } RendererFuncs;
 
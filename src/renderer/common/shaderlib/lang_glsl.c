@@ -61,6 +61,33 @@ static void glsl_write_version(GLSLFileParseState *fstate, GLSLVersion version)
 	fstate->need_lineno_marker = true;
 }
 
+// NOTE: keep in sync with the layout in gl33.c (std140)
+#define FRAME_UNIFORMS_MEMBERS(X) \
+	X(513, mat4,  r_projectionMatrix) \
+	X(516, vec2,  r_framebufferSize) \
+	X(517, float, r_time) \
+	X(518, float, r_stageTime) \
+
+static void glsl_write_frame_uniforms(GLSLFileParseState *fstate) {
+	SDL_RWops *dest = fstate->global->dest;
+
+	// This has to be a macro: we can't emit any declarations before the shader's #extension directives.
+	if(fstate->global->options->frame_uniform_block) {
+		SDL_RWprintf(dest, "#define R_FRAME_UNIFORMS layout(std140) uniform %s {", GLSL_FRAME_UNIFORMS_BLOCK);
+		#define X(loc, type, name) SDL_RWprintf(dest, " " #type " " #name ";");
+		FRAME_UNIFORMS_MEMBERS(X)
+		#undef X
+		SDL_RWprintf(dest, " }\n");
+	} else {
+		const char *sep = "";
+		SDL_RWprintf(dest, "#define R_FRAME_UNIFORMS");
+		#define X(loc, type, name) SDL_RWprintf(dest, "%s UNIFORM(" #loc ") " #type " " #name, sep); sep = ";";
+		FRAME_UNIFORMS_MEMBERS(X)
+		#undef X
+		SDL_RWprintf(dest, "\n");
+	}
+}
+
 static void glsl_write_header(GLSLFileParseState *fstate) {
 	SDL_RWprintf(
 		fstate->global->dest,
@@ -74,6 +101,8 @@ static void glsl_write_header(GLSLFileParseState *fstate) {
 		}
 	}
 
+	glsl_write_frame_uniforms(fstate);
+
 	fstate->need_lineno_marker = true;
 }
 
@@ -152,7 +181,7 @@ static bool glsl_process_file(GLSLFileParseState *fstate) {
 		return false;
 	}
 
-	SDL_RWops *stream = vfs_open(fstate->path, VFS_MODE_READ);
+	SDL_RWops *stream = vfs_open_mapped(fstate->path, VFS_MODE_READ);
 	SDL_RWops *dest = fstate->global->dest;
 
 	if(!stream) {
@@ -30,10 +30,16 @@ typedef struct GLSLMacro {
 	const char *value;
 } GLSLMacro;
 
+// Shared state that changes at most a few times per frame (projection, time, framebuffer size).
+// Declared by the R_FRAME_UNIFORMS macro, which glsl_load_source() defines for every shader.
+#define GLSL_FRAME_UNIFORMS_BLOCK "r_FrameUniforms"
+#define GLSL_FRAME_UNIFORMS_BINDING 0
+
 typedef struct GLSLSourceOptions {
 	GLSLVersion version;
 	ShaderStage stage;
 	bool force_version;
+	bool frame_uniform_block;  // declare the frame uniforms as a UBO, rather than as plain uniforms
 	GLSLMacro *macros;
 } GLSLSourceOptions;
 
@@ -102,6 +102,11 @@ bool _spirv_compile(const ShaderSource *in, ShaderSource *out, const SPIRVCompil
 	shaderc_compile_options_set_forced_version_profile(opts, in->lang.glsl.version.version, resolve_glsl_profile(&in->lang.glsl.version));
 	shaderc_compile_options_set_auto_map_locations(opts, true);
 
+	// glslang wants an explicit binding for every uniform block (e.g. R_FRAME_UNIFORMS), but
+	// the GLSL we feed it may target versions that can't declare one. The bindings don't
+	// survive translation to older GLSL anyway; the backend assigns them by block name.
+	shaderc_compile_options_set_auto_bind_uniforms(opts, true);
+
 	uint32_t env_version;
 	shaderc_target_env env = resolve_env(options->target, &env_version);
 	shaderc_compile_options_set_target_env(opts, env, env_version);
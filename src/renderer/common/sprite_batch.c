@@ -13,6 +13,7 @@
 #include "util/glm.h"
 #include "resource/sprite.h"
 #include "resource/model.h"
+#include "profiler.h"
 
 typedef struct SpriteAttribs {
 	mat4 transform;
@@ -28,31 +29,84 @@ typedef struct SpriteAttribs {
 
 #define SIZEOF_SPRITE_ATTRIBS (offsetof(SpriteAttribs, end_of_fields))
 
-static struct SpriteBatchState {
-	VertexArray *varr;
-	VertexBuffer *vbuf;
-	uint base_instance;
+// Used instead of SpriteAttribs for sprites with a 2D affine transform and an identity texture matrix,
+// which is almost all of them. See _r_sprite_attribs_compactable.
+typedef struct SpriteAttribsCompact {
+	float affine[6];  // first two columns of the 2x2 linear part, then the translation
+	float rgba[4];
+	FloatRect texrect;
+	float sprite_size[2];
+	float custom[4];
+
+	// offset of this == size without padding.
+	char end_of_fields;
+} SpriteAttribsCompact;
+
+#define SIZEOF_SPRITE_ATTRIBS_COMPACT (offsetof(SpriteAttribsCompact, end_of_fields))
+
+typedef enum SpriteLayout {
+	SPRITE_LAYOUT_FULL,
+	SPRITE_LAYOUT_COMPACT,
+	NUM_SPRITE_LAYOUTS,
+} SpriteLayout;
+
+// Everything that forces a flush when it changes between two sprites, except the projection matrix.
+typedef struct SpriteBatchKey {
 	Texture *primary_texture;
 	Texture *aux_textures[R_NUM_SPRITE_AUX_TEXTURES];
 	ShaderProgram *shader;
-	BlendMode blend;
 	Framebuffer *framebuffer;
+	BlendMode blend;
 	CullFaceMode cull_mode;
 	DepthTestFunc depth_func;
-	mat4 projection CGLM_ALIGN(32);
 	uint cull_enabled : 1;
 	uint depth_test_enabled : 1;
 	uint depth_write_enabled : 1;
+	uint layout : 1;
+} SpriteBatchKey;
+
+typedef struct DeferredSprite {
+	SpriteBatchKey key;
+	uint projection;
+	uint index;
+} DeferredSprite;
+
+static struct SpriteBatchState {
+	// One set per SpriteLayout; a batch only ever uses one of them.
+	struct SpriteBatchBuffers {
+		VertexArray *varr;
+		VertexBuffer *vbuf;
+		Model quad;
+		uint base_instance;
+		size_t attribs_size;
+	} buffers[NUM_SPRITE_LAYOUTS];
+
+	SpriteBatchKey state;
+	mat4 projection CGLM_ALIGN(32);
 	uint num_pending;
 
-	Model quad;
+	// Sprites submitted inside a reorder scope, waiting to be sorted by state.
+	struct SpriteReorderQueue {
+		DeferredSprite *sprites;
+		SpriteAttribs *attribs;
+		mat4 *projections;
+		uint num_sprites;
+		uint num_projections;
+		uint capacity;
+		uint projections_capacity;
+		uint depth;
+	} reorder;
 
 	struct {
 		uint flushes;
 		uint sprites;
+		uint reordered;
 		uint best_batch;
 		uint worst_batch;
+		size_t bytes;
 	} frame_stats;
+
+	SpriteBatchStats last_frame_stats;
 } _r_sprite_batch;
 
 void _r_sprite_batch_init(void) {
@@ -62,9 +116,11 @@ void _r_sprite_batch_init(void) {
 
 	size_t sz_vert = sizeof(GenericModelVertex);
 	size_t sz_attr = SIZEOF_SPRITE_ATTRIBS;
+	size_t sz_cattr = SIZEOF_SPRITE_ATTRIBS_COMPACT;
 
 	#define VERTEX_OFS(attr)   offsetof(GenericModelVertex,  attr)
 	#define INSTANCE_OFS(attr) offsetof(SpriteAttribs, attr)
+	#define COMPACT_OFS(attr)  offsetof(SpriteAttribsCompact, attr)
 
 	VertexAttribFormat fmt[] = {
 		// Per-vertex attributes (for the static models buffer, bound at 0)
@@ -87,8 +143,33 @@ void _r_sprite_batch_init(void) {
 		{ { 4, VA_FLOAT, VA_CONVERT_FLOAT, 1 }, sz_attr, INSTANCE_OFS(custom),           1 },
 	};
 
+	// Attribute indices are locations, so this has to mirror the above. The shader reads the
+	// affine transform from the first two columns of spriteVMTransform when spriteCompactLayout
+	// is set, and ignores the remaining matrix attributes, which just alias the start of the instance.
+	VertexAttribFormat fmt_compact[] = {
+		{ { 3, VA_FLOAT, VA_CONVERT_FLOAT, 0 }, sz_vert,  VERTEX_OFS(position),          0 },
+		{ { 3, VA_FLOAT, VA_CONVERT_FLOAT, 0 }, sz_vert,  VERTEX_OFS(normal),            0 },
+		{ { 2, VA_FLOAT, VA_CONVERT_FLOAT, 0 }, sz_vert,  VERTEX_OFS(uv),                0 },
+
+		{ { 4, VA_FLOAT, VA_CONVERT_FLOAT, 1 }, sz_cattr, COMPACT_OFS(affine[0]),        1 },
+		{ { 2, VA_FLOAT, VA_CONVERT_FLOAT, 1 }, sz_cattr, COMPACT_OFS(affine[4]),        1 },
+		{ { 1, VA_FLOAT, VA_CONVERT_FLOAT, 1 }, sz_cattr, 0,                             1 },
+		{ { 1, VA_FLOAT, VA_CONVERT_FLOAT, 1 }, sz_cattr, 0,                             1 },
+		{ { 1, VA_FLOAT, VA_CONVERT_FLOAT, 1 }, sz_cattr, 0,                             1 },
+		{ { 1, VA_FLOAT, VA_CONVERT_FLOAT, 1 }, sz_cattr, 0,                             1 },
+		{ { 1, VA_FLOAT, VA_CONVERT_FLOAT, 1 }, sz_cattr, 0,                             1 },
+		{ { 1, VA_FLOAT, VA_CONVERT_FLOAT, 1 }, sz_cattr, 0,                             1 },
+		{ { 4, VA_FLOAT, VA_CONVERT_FLOAT, 1 }, sz_cattr, COMPACT_OFS(rgba),             1 },
+		{ { 4, VA_FLOAT, VA_CONVERT_FLOAT, 1 }, sz_cattr, COMPACT_OFS(texrect),          1 },
+		{ { 2, VA_FLOAT, VA_CONVERT_FLOAT, 1 }, sz_cattr, COMPACT_OFS(sprite_size),      1 },
+		{ { 4, VA_FLOAT, VA_CONVERT_FLOAT, 1 }, sz_cattr, COMPACT_OFS(custom),           1 },
+	};
+
+	static_assert(ARRAY_SIZE(fmt) == ARRAY_SIZE(fmt_compact), "Sprite layouts must define the same attribute locations");
+
 	#undef VERTEX_OFS
 	#undef INSTANCE_OFS
+	#undef COMPACT_OFS
 
 	uint capacity;
 
@@ -98,29 +179,56 @@ void _r_sprite_batch_init(void) {
 		capacity = 1 << 11;
 	}
 
-	_r_sprite_batch.vbuf = r_vertex_buffer_create(sz_attr * capacity, NULL);
-	r_vertex_buffer_set_debug_label(_r_sprite_batch.vbuf, "Sprite batch vertex buffer");
-	r_vertex_buffer_invalidate(_r_sprite_batch.vbuf);
-
-	_r_sprite_batch.varr = r_vertex_array_create();
-	r_vertex_array_set_debug_label(_r_sprite_batch.varr, "Sprite batch vertex array");
-	r_vertex_array_layout(_r_sprite_batch.varr, sizeof(fmt)/sizeof(*fmt), fmt);
-	r_vertex_array_attach_vertex_buffer(_r_sprite_batch.varr, r_vertex_buffer_static_models(), 0);
-	r_vertex_array_attach_vertex_buffer(_r_sprite_batch.varr, _r_sprite_batch.vbuf, 1);
+	struct {
+		VertexAttribFormat *fmt;
+		size_t attribs_size;
+		const char *vbuf_label;
+		const char *varr_label;
+	} layouts[] = {
+		[SPRITE_LAYOUT_FULL] = { fmt, sz_attr, "Sprite batch vertex buffer", "Sprite batch vertex array" },
+		[SPRITE_LAYOUT_COMPACT] = { fmt_compact, sz_cattr, "Sprite batch vertex buffer (compact)", "Sprite batch vertex array (compact)" },
+	};
 
-	_r_sprite_batch.quad.indexed = false;
-	_r_sprite_batch.quad.num_vertices = 4;
-	_r_sprite_batch.quad.offset = 0;
-	_r_sprite_batch.quad.primitive = PRIM_TRIANGLE_STRIP;
-	_r_sprite_batch.quad.vertex_array = _r_sprite_batch.varr;
+	for(uint i = 0; i < NUM_SPRITE_LAYOUTS; ++i) {
+		struct SpriteBatchBuffers *b = _r_sprite_batch.buffers + i;
+
+		b->attribs_size = layouts[i].attribs_size;
+		b->vbuf = r_vertex_buffer_create(b->attribs_size * capacity, NULL);
+		r_vertex_buffer_set_debug_label(b->vbuf, layouts[i].vbuf_label);
+		r_vertex_buffer_invalidate(b->vbuf);
+
+		b->varr = r_vertex_array_create();
+		r_vertex_array_set_debug_label(b->varr, layouts[i].varr_label);
+		r_vertex_array_layout(b->varr, ARRAY_SIZE(fmt), layouts[i].fmt);
+		r_vertex_array_attach_vertex_buffer(b->varr, r_vertex_buffer_static_models(), 0);
+		r_vertex_array_attach_vertex_buffer(b->varr, b->vbuf, 1);
+
+		b->quad.indexed = false;
+		b->quad.num_vertices = 4;
+		b->quad.offset = 0;
+		b->quad.primitive = PRIM_TRIANGLE_STRIP;
+		b->quad.vertex_array = b->varr;
+	}
 }
 
 void _r_sprite_batch_shutdown(void) {
-	r_vertex_array_destroy(_r_sprite_batch.varr);
-	r_vertex_buffer_destroy(_r_sprite_batch.vbuf);
+	assert(_r_sprite_batch.reorder.depth == 0);
+	free(_r_sprite_batch.reorder.sprites);
+	free(_r_sprite_batch.reorder.attribs);
+	free(_r_sprite_batch.reorder.projections);
+
+	for(uint i = 0; i < NUM_SPRITE_LAYOUTS; ++i) {
+		r_vertex_array_destroy(_r_sprite_batch.buffers[i].varr);
+		r_vertex_buffer_destroy(_r_sprite_batch.buffers[i].vbuf);
+	}
 }
 
+static void _r_sprite_batch_emit_deferred(void);
+
 void r_flush_sprites(void) {
+	PROFILE_ZONE("r_flush_sprites");
+	_r_sprite_batch_emit_deferred();
+
 	if(_r_sprite_batch.num_pending == 0) {
 		return;
 	}
@@ -150,39 +258,42 @@ void r_flush_sprites(void) {
 	r_mat_push();
 	glm_mat4_copy(_r_sprite_batch.projection, *r_mat_current_ptr(MM_PROJECTION));
 
-	r_shader_ptr(_r_sprite_batch.shader);
-	r_uniform_sampler("tex", _r_sprite_batch.primary_texture);
-	r_uniform_sampler_array("tex_aux[0]", 0, R_NUM_SPRITE_AUX_TEXTURES, _r_sprite_batch.aux_textures);
-	r_framebuffer(_r_sprite_batch.framebuffer);
-	r_blend(_r_sprite_batch.blend);
-	r_capability(RCAP_DEPTH_TEST, _r_sprite_batch.depth_test_enabled);
-	r_capability(RCAP_DEPTH_WRITE, _r_sprite_batch.depth_write_enabled);
-	r_capability(RCAP_CULL_FACE, _r_sprite_batch.cull_enabled);
-	r_depth_func(_r_sprite_batch.depth_func);
-	r_cull(_r_sprite_batch.cull_mode);
+	r_shader_ptr(_r_sprite_batch.state.shader);
+	r_uniform_sampler("tex", _r_sprite_batch.state.primary_texture);
+	r_uniform_sampler_array("tex_aux[0]", 0, R_NUM_SPRITE_AUX_TEXTURES, _r_sprite_batch.state.aux_textures);
+	r_uniform_int("spriteCompactLayout", _r_sprite_batch.state.layout == SPRITE_LAYOUT_COMPACT);
+	r_framebuffer(_r_sprite_batch.state.framebuffer);
+	r_blend(_r_sprite_batch.state.blend);
+	r_capability(RCAP_DEPTH_TEST, _r_sprite_batch.state.depth_test_enabled);
+	r_capability(RCAP_DEPTH_WRITE, _r_sprite_batch.state.depth_write_enabled);
+	r_capability(RCAP_CULL_FACE, _r_sprite_batch.state.cull_enabled);
+	r_depth_func(_r_sprite_batch.state.depth_func);
+	r_cull(_r_sprite_batch.state.cull_mode);
+
+	struct SpriteBatchBuffers *b = _r_sprite_batch.buffers + _r_sprite_batch.state.layout;
 
 	if(r_supports(RFEAT_DRAW_INSTANCED_BASE_INSTANCE)) {
-		r_draw_model_ptr(&_r_sprite_batch.quad, pending, _r_sprite_batch.base_instance);
-		_r_sprite_batch.base_instance += pending;
+		r_draw_model_ptr(&b->quad, pending, b->base_instance);
+		b->base_instance += pending;
 
-		SDL_RWops *stream = r_vertex_buffer_get_stream(_r_sprite_batch.vbuf);
+		SDL_RWops *stream = r_vertex_buffer_get_stream(b->vbuf);
 		size_t remaining = SDL_RWsize(stream) - SDL_RWtell(stream);
 
-		if(remaining < SIZEOF_SPRITE_ATTRIBS) {
-			// log_debug("Invalidating after %u sprites", _r_sprite_batch.base_instance);
-			r_vertex_buffer_invalidate(_r_sprite_batch.vbuf);
-			_r_sprite_batch.base_instance = 0;
+		if(remaining < b->attribs_size) {
+			// log_debug("Invalidating after %u sprites", b->base_instance);
+			r_vertex_buffer_invalidate(b->vbuf);
+			b->base_instance = 0;
 		}
 	} else {
-		r_draw_model_ptr(&_r_sprite_batch.quad, pending, 0);
-		r_vertex_buffer_invalidate(_r_sprite_batch.vbuf);
+		r_draw_model_ptr(&b->quad, pending, 0);
+		r_vertex_buffer_invalidate(b->vbuf);
 	}
 
 	r_mat_pop();
 	r_state_pop();
 }
 
-static void _r_sprite_batch_add(Sprite *spr, const SpriteParams *params, SDL_RWops *stream) {
+static void _r_sprite_batch_compute_attribs(Sprite *spr, const SpriteParams *params, SpriteAttribs *out_attribs) {
 	SpriteAttribs attribs;
 	r_mat_current(MM_MODELVIEW, attribs.transform);
 	r_mat_current(MM_TEXTURE, attribs.tex_transform);
@@ -240,34 +351,33 @@ static void _r_sprite_batch_add(Sprite *spr, const SpriteParams *params, SDL_RWo
 		memset(attribs.custom, 0, sizeof(attribs.custom));
 	}
 
-	SDL_RWwrite(stream, &attribs, SIZEOF_SPRITE_ATTRIBS, 1);
-	_r_sprite_batch.frame_stats.sprites++;
+	*out_attribs = attribs;
 }
 
-void r_draw_sprite(const SpriteParams *params) {
-	assert(!(params->shader && params->shader_ptr));
-	assert(!(params->sprite && params->sprite_ptr));
+static bool _r_sprite_attribs_compactable(const SpriteAttribs *attribs) {
+	const vec4 *m = attribs->transform;
+
+	// The third column is irrelevant in practice, as sprites are flat, but it's checked anyway so that
+	// the matrix the shader reconstructs is exactly the same.
+	return
+		m[0][2] == 0 && m[0][3] == 0 &&
+		m[1][2] == 0 && m[1][3] == 0 &&
+		m[2][0] == 0 && m[2][1] == 0 && m[2][2] == 1 && m[2][3] == 0 &&
+		m[3][2] == 0 && m[3][3] == 1 &&
+		!memcmp(attribs->tex_transform, GLM_MAT4_IDENTITY, sizeof(mat4));
+}
 
-	Sprite *spr = params->sprite_ptr;
+static void _r_sprite_batch_compute_key(Sprite *spr, const SpriteParams *params, const SpriteAttribs *attribs, SpriteBatchKey *key) {
+	memset(key, 0, sizeof(*key));
 
-	if(spr == NULL) {
-		assert(params->sprite != NULL);
-		spr = get_sprite(params->sprite);
+	if(_r_sprite_attribs_compactable(attribs)) {
+		key->layout = SPRITE_LAYOUT_COMPACT;
+	} else {
+		key->layout = SPRITE_LAYOUT_FULL;
 	}
 
-	if(spr->tex != _r_sprite_batch.primary_texture) {
-		r_flush_sprites();
-		_r_sprite_batch.primary_texture = spr->tex;
-	}
-
-	for(uint i = 0; i < R_NUM_SPRITE_AUX_TEXTURES; ++i) {
-		Texture *aux_tex = params->aux_textures[i];
-
-		if(aux_tex != NULL && aux_tex != _r_sprite_batch.aux_textures[i]) {
-			r_flush_sprites();
-			_r_sprite_batch.aux_textures[i] = aux_tex;
-		}
-	}
+	key->primary_texture = spr->tex;
+	memcpy(key->aux_textures, params->aux_textures, sizeof(key->aux_textures));
 
 	ShaderProgram *prog = params->shader_ptr;
 
@@ -280,86 +390,246 @@ void r_draw_sprite(const SpriteParams *params) {
 	}
 
 	assert(prog != NULL);
+	key->shader = prog;
 
-	if(prog != _r_sprite_batch.shader) {
-		r_flush_sprites();
-		_r_sprite_batch.shader = prog;
+	key->framebuffer = r_framebuffer_current();
+	key->blend = params->blend;
+
+	if(key->blend == 0) {
+		key->blend = r_blend_current();
 	}
 
-	Framebuffer *fb = r_framebuffer_current();
+	key->depth_test_enabled = r_capability_current(RCAP_DEPTH_TEST);
+	key->depth_write_enabled = r_capability_current(RCAP_DEPTH_WRITE);
+	key->cull_enabled = r_capability_current(RCAP_CULL_FACE);
+	key->depth_func = r_depth_func_current();
+	key->cull_mode = r_cull_current();
+}
 
-	if(fb != _r_sprite_batch.framebuffer) {
+// Makes the batch state match key, flushing the pending sprites if anything changes.
+static void _r_sprite_batch_apply_key(const SpriteBatchKey *key, mat4 projection) {
+	SpriteBatchKey *state = &_r_sprite_batch.state;
+
+	if(key->primary_texture != state->primary_texture) {
 		r_flush_sprites();
-		_r_sprite_batch.framebuffer = fb;
+		state->primary_texture = key->primary_texture;
 	}
 
-	BlendMode blend = params->blend;
+	for(uint i = 0; i < R_NUM_SPRITE_AUX_TEXTURES; ++i) {
+		Texture *aux_tex = key->aux_textures[i];
 
-	if(blend == 0) {
-		blend = r_blend_current();
+		if(aux_tex != NULL && aux_tex != state->aux_textures[i]) {
+			r_flush_sprites();
+			state->aux_textures[i] = aux_tex;
+		}
 	}
 
-	if(blend != _r_sprite_batch.blend) {
+	if(key->shader != state->shader) {
 		r_flush_sprites();
-		_r_sprite_batch.blend = blend;
+		state->shader = key->shader;
 	}
 
-	bool depth_test_enabled = r_capability_current(RCAP_DEPTH_TEST);
-	bool depth_write_enabled = r_capability_current(RCAP_DEPTH_WRITE);
-	bool cull_enabled = r_capability_current(RCAP_CULL_FACE);
-	DepthTestFunc depth_func = r_depth_func_current();
-	CullFaceMode cull_mode = r_cull_current();
+	if(key->framebuffer != state->framebuffer) {
+		r_flush_sprites();
+		state->framebuffer = key->framebuffer;
+	}
 
-	if(_r_sprite_batch.depth_test_enabled != depth_test_enabled) {
+	if(key->blend != state->blend) {
 		r_flush_sprites();
-		_r_sprite_batch.depth_test_enabled = depth_test_enabled;
+		state->blend = key->blend;
 	}
 
-	if(_r_sprite_batch.depth_write_enabled != depth_write_enabled) {
+	if(key->depth_test_enabled != state->depth_test_enabled) {
 		r_flush_sprites();
-		_r_sprite_batch.depth_write_enabled = depth_write_enabled;
+		state->depth_test_enabled = key->depth_test_enabled;
 	}
 
-	if(_r_sprite_batch.cull_enabled != cull_enabled) {
+	if(key->depth_write_enabled != state->depth_write_enabled) {
 		r_flush_sprites();
-		_r_sprite_batch.cull_enabled = cull_enabled;
+		state->depth_write_enabled = key->depth_write_enabled;
 	}
 
-	if(_r_sprite_batch.depth_func != depth_func) {
+	if(key->cull_enabled != state->cull_enabled) {
 		r_flush_sprites();
-		_r_sprite_batch.depth_func = depth_func;
+		state->cull_enabled = key->cull_enabled;
 	}
 
-	if(_r_sprite_batch.cull_mode != cull_mode) {
+	if(key->depth_func != state->depth_func) {
 		r_flush_sprites();
-		_r_sprite_batch.cull_mode = cull_mode;
+		state->depth_func = key->depth_func;
 	}
 
-	mat4 *current_projection = r_mat_current_ptr(MM_PROJECTION);
+	if(key->cull_mode != state->cull_mode) {
+		r_flush_sprites();
+		state->cull_mode = key->cull_mode;
+	}
+
+	if(key->layout != state->layout) {
+		r_flush_sprites();
+		state->layout = key->layout;
+	}
 
-	if(memcmp(*current_projection, _r_sprite_batch.projection, sizeof(mat4))) {
+	if(memcmp(projection, _r_sprite_batch.projection, sizeof(mat4))) {
 		r_flush_sprites();
-		glm_mat4_copy(*current_projection, _r_sprite_batch.projection);
+		glm_mat4_copy(projection, _r_sprite_batch.projection);
 	}
+}
 
-	SDL_RWops *stream = r_vertex_buffer_get_stream(_r_sprite_batch.vbuf);
+// Appends a sprite to the pending batch, in the layout of the current state.
+static void _r_sprite_batch_add(const SpriteAttribs *attribs) {
+	struct SpriteBatchBuffers *b = _r_sprite_batch.buffers + _r_sprite_batch.state.layout;
+	SDL_RWops *stream = r_vertex_buffer_get_stream(b->vbuf);
 	size_t remaining = SDL_RWsize(stream) - SDL_RWtell(stream);
 
-	if(remaining < SIZEOF_SPRITE_ATTRIBS) {
+	if(remaining < b->attribs_size) {
 		if(!r_supports(RFEAT_DRAW_INSTANCED_BASE_INSTANCE)) {
-			log_warn("Vertex buffer exhausted (%zu needed for next sprite, %zu remaining), flush forced", SIZEOF_SPRITE_ATTRIBS, remaining);
+			log_warn("Vertex buffer exhausted (%zu needed for next sprite, %zu remaining), flush forced", b->attribs_size, remaining);
 		}
 
 		r_flush_sprites();
 	}
 
 	_r_sprite_batch.num_pending++;
-	_r_sprite_batch_add(spr, params, stream);
+
+	if(_r_sprite_batch.state.layout == SPRITE_LAYOUT_COMPACT) {
+		const vec4 *m = attribs->transform;
+		SpriteAttribsCompact cattribs = {
+			.affine = { m[0][0], m[0][1], m[1][0], m[1][1], m[3][0], m[3][1] },
+			.texrect = attribs->texrect,
+		};
+
+		memcpy(cattribs.rgba, attribs->rgba, sizeof(cattribs.rgba));
+		memcpy(cattribs.sprite_size, attribs->sprite_size, sizeof(cattribs.sprite_size));
+		memcpy(cattribs.custom, attribs->custom, sizeof(cattribs.custom));
+
+		SDL_RWwrite(stream, &cattribs, SIZEOF_SPRITE_ATTRIBS_COMPACT, 1);
+	} else {
+		SDL_RWwrite(stream, attribs, SIZEOF_SPRITE_ATTRIBS, 1);
+	}
+
+	_r_sprite_batch.frame_stats.sprites++;
+	_r_sprite_batch.frame_stats.bytes += b->attribs_size;
+}
+
+static void _r_sprite_batch_defer(const SpriteBatchKey *key, const SpriteAttribs *attribs) {
+	struct SpriteReorderQueue *q = &_r_sprite_batch.reorder;
+	mat4 *current_projection = r_mat_current_ptr(MM_PROJECTION);
+
+	if(q->num_projections == 0 || memcmp(*current_projection, q->projections[q->num_projections - 1], sizeof(mat4))) {
+		if(q->num_projections == q->projections_capacity) {
+			q->projections_capacity = q->projections_capacity ? q->projections_capacity * 2 : 4;
+			q->projections = realloc(q->projections, q->projections_capacity * sizeof(*q->projections));
+		}
+
+		glm_mat4_copy(*current_projection, q->projections[q->num_projections++]);
+	}
+
+	if(q->num_sprites == q->capacity) {
+		q->capacity = q->capacity ? q->capacity * 2 : 256;
+		q->sprites = realloc(q->sprites, q->capacity * sizeof(*q->sprites));
+		q->attribs = realloc(q->attribs, q->capacity * sizeof(*q->attribs));
+	}
+
+	DeferredSprite *ds = q->sprites + q->num_sprites;
+	memcpy(&ds->key, key, sizeof(ds->key));  // padding included, see _r_sprite_batch_deferred_cmp
+	ds->projection = q->num_projections - 1;
+	ds->index = q->num_sprites;
+	q->attribs[q->num_sprites++] = *attribs;
+}
+
+static int _r_sprite_batch_deferred_cmp(const void *p1, const void *p2) {
+	const DeferredSprite *s1 = p1;
+	const DeferredSprite *s2 = p2;
+
+	int r = memcmp(&s1->key, &s2->key, sizeof(s1->key));
+
+	if(r == 0) {
+		r = (s1->projection > s2->projection) - (s1->projection < s2->projection);
+	}
+
+	if(r == 0) {
+		// Keep the submission order within a batch.
+		r = (s1->index > s2->index) - (s1->index < s2->index);
+	}
+
+	return r;
+}
+
+static void _r_sprite_batch_emit_deferred(void) {
+	struct SpriteReorderQueue *q = &_r_sprite_batch.reorder;
+	uint num = q->num_sprites;
+
+	if(num == 0) {
+		return;
+	}
+
+	// needs to be done early to thwart recursive calls
+	q->num_sprites = 0;
+
+	qsort(q->sprites, num, sizeof(*q->sprites), _r_sprite_batch_deferred_cmp);
+
+	for(uint i = 0; i < num; ++i) {
+		DeferredSprite *ds = q->sprites + i;
+		_r_sprite_batch_apply_key(&ds->key, q->projections[ds->projection]);
+		_r_sprite_batch_add(q->attribs + ds->index);
+	}
+
+	q->num_projections = 0;
+	_r_sprite_batch.frame_stats.reordered += num;
+}
+
+void r_sprite_reorder_begin(void) {
+	_r_sprite_batch.reorder.depth++;
+}
+
+void r_sprite_reorder_end(void) {
+	assert(_r_sprite_batch.reorder.depth > 0);
+
+	if(--_r_sprite_batch.reorder.depth == 0) {
+		_r_sprite_batch_emit_deferred();
+	}
+}
+
+void r_draw_sprite(const SpriteParams *params) {
+	assert(!(params->shader && params->shader_ptr));
+	assert(!(params->sprite && params->sprite_ptr));
+
+	Sprite *spr = params->sprite_ptr;
+
+	if(spr == NULL) {
+		assert(params->sprite != NULL);
+		spr = get_sprite(params->sprite);
+	}
+
+	SpriteBatchKey key;
+	SpriteAttribs attribs;
+	_r_sprite_batch_compute_attribs(spr, params, &attribs);
+	_r_sprite_batch_compute_key(spr, params, &attribs, &key);
+
+	if(_r_sprite_batch.reorder.depth > 0) {
+		_r_sprite_batch_defer(&key, &attribs);
+	} else {
+		_r_sprite_batch_apply_key(&key, *r_mat_current_ptr(MM_PROJECTION));
+		_r_sprite_batch_add(&attribs);
+	}
+}
+
+void r_sprite_batch_stats(SpriteBatchStats *stats) {
+	*stats = _r_sprite_batch.last_frame_stats;
 }
 
 #include "resource/font.h"
 
 void _r_sprite_batch_end_frame(void) {
+	assert(_r_sprite_batch.reorder.depth == 0);
+
+	_r_sprite_batch.last_frame_stats = (SpriteBatchStats) {
+		.sprites = _r_sprite_batch.frame_stats.sprites,
+		.flushes = _r_sprite_batch.frame_stats.flushes,
+		.reordered = _r_sprite_batch.frame_stats.reordered,
+		.bytes = _r_sprite_batch.frame_stats.bytes,
+	};
+
 #ifdef DEBUG
 	if(!_r_sprite_batch.frame_stats.flushes) {
 		return;
@@ -368,12 +638,14 @@ void _r_sprite_batch_end_frame(void) {
 	r_flush_sprites();
 
 	static char buf[512];
-	snprintf(buf, sizeof(buf), "%6i sprites %6i flushes %9.02f spr/flush %6i best %6i worst",
+	snprintf(buf, sizeof(buf), "%6i sprites %6i flushes %9.02f spr/flush %6i best %6i worst %6i reordered %6zuK",
 		_r_sprite_batch.frame_stats.sprites,
 		_r_sprite_batch.frame_stats.flushes,
 		_r_sprite_batch.frame_stats.sprites / (double)_r_sprite_batch.frame_stats.flushes,
 		_r_sprite_batch.frame_stats.best_batch,
-		_r_sprite_batch.frame_stats.worst_batch
+		_r_sprite_batch.frame_stats.worst_batch,
+		_r_sprite_batch.frame_stats.reordered,
+		_r_sprite_batch.frame_stats.bytes / 1024
 	);
 
 	Font *font = get_font("monotiny");
@@ -384,19 +656,24 @@ void _r_sprite_batch_end_frame(void) {
 		.shader = "text_default",
 	});
 
-	memset(&_r_sprite_batch.frame_stats, 0, sizeof(_r_sprite_batch.frame_stats));
-
 #endif
+
+	memset(&_r_sprite_batch.frame_stats, 0, sizeof(_r_sprite_batch.frame_stats));
 }
 
 void _r_sprite_batch_texture_deleted(Texture *tex) {
-	if(_r_sprite_batch.primary_texture == tex) {
-		_r_sprite_batch.primary_texture = NULL;
+	// Deferred sprites may still reference it.
+	if(_r_sprite_batch.reorder.num_sprites) {
+		r_flush_sprites();
+	}
+
+	if(_r_sprite_batch.state.primary_texture == tex) {
+		_r_sprite_batch.state.primary_texture = NULL;
 	}
 
 	for(uint i = 0; i < R_NUM_SPRITE_AUX_TEXTURES; ++i) {
-		if(_r_sprite_batch.aux_textures[i] == tex) {
-			_r_sprite_batch.aux_textures[i] = NULL;
+		if(_r_sprite_batch.state.aux_textures[i] == tex) {
+			_r_sprite_batch.state.aux_textures[i] = NULL;
 		}
 	}
 }
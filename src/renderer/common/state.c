@@ -17,6 +17,8 @@
 static struct {
 	RendererStateRollback *head;
 	RendererStateRollback stack[RSTATE_STACK_SIZE];
+	RendererStateStats frame_stats;
+	RendererStateStats last_frame_stats;
 } _r_state;
 
 void _r_state_init(void) {
@@ -36,7 +38,26 @@ void _r_state_shutdown(void) {
 		} \
 	} while(0);
 // #define RESTORE(db) if(S.dirty_bits & (db)) log_debug(#db); if(S.dirty_bits & (db))
-#define RESTORE(db) if(S.dirty_bits & (db))
+#define RESTORE(db, unchanged) if((S.dirty_bits & (db)) && !_r_state_redundant(unchanged))
+
+bool _r_state_redundant(bool unchanged) {
+	if(unchanged) {
+		_r_state.frame_stats.avoided++;
+		return true;
+	}
+
+	_r_state.frame_stats.changes++;
+	return false;
+}
+
+void _r_state_end_frame(void) {
+	_r_state.last_frame_stats = _r_state.frame_stats;
+	memset(&_r_state.frame_stats, 0, sizeof(_r_state.frame_stats));
+}
+
+void r_state_stats(RendererStateStats *stats) {
+	*stats = _r_state.last_frame_stats;
+}
 
 void r_state_push(void) {
 	if(_r_state.head) {
@@ -53,39 +74,42 @@ void r_state_push(void) {
 void r_state_pop(void) {
 	assert(_r_state.head >= _r_state.stack);
 
-	RESTORE(RSTATE_CAPABILITIES) {
+	// Whatever was set in this scope may have already been set back (typically by the next
+	// entity's draw function setting up the same state), so only restore what actually differs.
+
+	RESTORE(RSTATE_CAPABILITIES, S.capabilities == B.capabilities_current()) {
 		B.capabilities(S.capabilities);
 	}
 
-	RESTORE(RSTATE_MATMODE) {
+	RESTORE(RSTATE_MATMODE, S.matmode == r_mat_mode_current()) {
 		r_mat_mode(S.matmode);
 	}
 
-	RESTORE(RSTATE_COLOR) {
+	RESTORE(RSTATE_COLOR, !memcmp(&S.color, B.color_current(), sizeof(S.color))) {
 		B.color4(S.color.r, S.color.g, S.color.b, S.color.a);
 	}
 
-	RESTORE(RSTATE_BLENDMODE) {
+	RESTORE(RSTATE_BLENDMODE, S.blend_mode == B.blend_current()) {
 		B.blend(S.blend_mode);
 	}
 
-	RESTORE(RSTATE_CULLMODE) {
+	RESTORE(RSTATE_CULLMODE, S.cull_mode == B.cull_current()) {
 		B.cull(S.cull_mode);
 	}
 
-	RESTORE(RSTATE_DEPTHFUNC) {
+	RESTORE(RSTATE_DEPTHFUNC, S.depth_func == B.depth_func_current()) {
 		B.depth_func(S.depth_func);
 	}
 
-	RESTORE(RSTATE_SHADER) {
+	RESTORE(RSTATE_SHADER, S.shader == B.shader_current()) {
 		B.shader(S.shader);
 	}
 
-	RESTORE(RSTATE_SHADER_UNIFORMS) {
+	if(S.dirty_bits & RSTATE_SHADER_UNIFORMS) {
 		// TODO
 	}
 
-	RESTORE(RSTATE_RENDERTARGET) {
+	RESTORE(RSTATE_RENDERTARGET, S.framebuffer == B.framebuffer_current()) {
 		B.framebuffer(S.framebuffer);
 	}
 
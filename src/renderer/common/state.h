@@ -63,6 +63,10 @@ void _r_state_touch_shader(void);
 void _r_state_touch_uniform(Uniform *uniform);
 void _r_state_touch_framebuffer(void);
 
+// Counts a state change, and returns true if it's a no-op that should be dropped.
+bool _r_state_redundant(bool unchanged);
+void _r_state_end_frame(void);
+
 void _r_state_init(void);
 void _r_state_shutdown(void);
 
@@ -10,9 +10,70 @@
 
 #include "common_buffer.h"
 #include "gl33.h"
+#include "ring_space.h"
+#include "util/env.h"
 
 #define STREAM_CBUF(rw) ((CommonBuffer*)rw)
 
+// Size of the ring, in multiples of the buffer size.
+#define STREAM_RING_WINDOWS 4
+
+// A frame pushes at most two fences, and the ones the GPU has passed are retired every frame,
+// so this only fills up if the GPU falls this many frames behind.
+#define STREAM_RING_MAX_FENCES 16
+#define STREAM_WINDOW_ALIGNMENT 64
+
+typedef struct StreamFence {
+	GLsync sync;
+	uint64_t pos;  // everything written up to here was submitted before the fence
+} StreamFence;
+
+struct StreamRing {
+	LIST_INTERFACE(StreamRing);
+	CommonBuffer *cbuf;
+
+	// Persistent mapping of the whole ring, if ARB_buffer_storage is available.
+	char *persistent_map;
+
+	// Otherwise, an unsynchronized mapping of [map_begin, map_end), dropped on flush.
+	char *temp_map;
+	size_t map_begin;
+	size_t map_end;
+
+	RingSpace space;
+	uint64_t window;    // start of the current window; its offset in the ring is cbuf->base_offset
+	size_t window_end;  // high-water mark of writes, relative to the window
+
+	StreamFence fences[STREAM_RING_MAX_FENCES];
+	uint first_fence;
+	uint num_fences;
+};
+
+static LIST_ANCHOR(StreamRing) stream_rings;
+
+typedef enum StreamingMode {
+	STREAMING_DISABLED,
+	STREAMING_MAP_RANGE,
+	STREAMING_PERSISTENT,
+} StreamingMode;
+
+static StreamingMode gl33_buffer_streaming_mode(void) {
+	StreamingMode mode = env_get("TAISEI_GL_STREAMING_BUFFERS", STREAMING_PERSISTENT);
+
+	if(mode >= STREAMING_PERSISTENT && glext.buffer_storage) {
+		return STREAMING_PERSISTENT;
+	}
+
+	if(mode >= STREAMING_MAP_RANGE && (GL_ATLEAST(3, 2) || GLES_ATLEAST(3, 0))) {
+		return STREAMING_MAP_RANGE;
+	}
+
+	return STREAMING_DISABLED;
+}
+
+static void stream_ring_push_fence(StreamRing *ring, uint64_t pos);
+static void stream_ring_write(StreamRing *ring, size_t offset, const void *data, size_t size);
+
 static int64_t gl33_buffer_stream_seek(SDL_RWops *rw, int64_t offset, int whence) {
 	CommonBuffer *cbuf = STREAM_CBUF(rw);
 
@@ -46,7 +107,10 @@ static size_t gl33_buffer_stream_write(SDL_RWops *rw, const void *data, size_t s
 	size_t total_size = size * num;
 	assert(cbuf->offset + total_size <= cbuf->size);
 
-	if(total_size > 0) {
+	if(total_size > 0 && cbuf->ring) {
+		stream_ring_write(cbuf->ring, cbuf->offset, data, total_size);
+		cbuf->offset += total_size;
+	} else if(total_size > 0) {
 		memcpy(cbuf->cache.buffer + cbuf->offset, data, total_size);
 		cbuf->cache.update_begin = min(cbuf->offset, cbuf->cache.update_begin);
 		cbuf->cache.update_end = max(cbuf->offset + total_size, cbuf->cache.update_end);
@@ -103,7 +167,212 @@ void gl33_buffer_init(CommonBuffer *cbuf, size_t capacity, void *data, GLenum us
 	}
 }
 
+// Returns false if the GPU hasn't reached the oldest fence yet, unless told to wait for it.
+static bool stream_ring_pop_fence(StreamRing *ring, bool wait) {
+	assert(ring->num_fences > 0);
+	StreamFence *f = ring->fences + ring->first_fence;
+
+	GLenum status = glClientWaitSync(f->sync, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+
+	if(status == GL_TIMEOUT_EXPIRED) {
+		if(!wait) {
+			return false;
+		}
+
+		log_debug("%s: waiting for the GPU to catch up", ring->cbuf->debug_label);
+
+		do {
+			status = glClientWaitSync(f->sync, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+		} while(status == GL_TIMEOUT_EXPIRED);
+	}
+
+	if(status == GL_WAIT_FAILED) {
+		log_error("%s: glClientWaitSync() failed", ring->cbuf->debug_label);
+	}
+
+	glDeleteSync(f->sync);
+	ring_space_release(&ring->space, f->pos);
+
+	ring->first_fence = (ring->first_fence + 1) % STREAM_RING_MAX_FENCES;
+	ring->num_fences--;
+	return true;
+}
+
+static void stream_ring_push_fence(StreamRing *ring, uint64_t pos) {
+	if(ring->num_fences > 0) {
+		uint last = (ring->first_fence + ring->num_fences - 1) % STREAM_RING_MAX_FENCES;
+
+		if(ring->fences[last].pos == pos) {
+			return;
+		}
+	}
+
+	if(ring->num_fences == STREAM_RING_MAX_FENCES) {
+		log_debug("%s: too many frames in flight", ring->cbuf->debug_label);
+		stream_ring_pop_fence(ring, true);
+	}
+
+	StreamFence *f = ring->fences + (ring->first_fence + ring->num_fences++) % STREAM_RING_MAX_FENCES;
+	f->sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	f->pos = pos;
+}
+
+static void stream_ring_unmap(StreamRing *ring) {
+	if(ring->temp_map == NULL) {
+		return;
+	}
+
+	CommonBuffer *cbuf = ring->cbuf;
+
+	GL33_BUFFER_TEMP_BIND(cbuf, {
+		glUnmapBuffer(gl33_bindidx_to_glenum(cbuf->bindidx));
+	});
+
+	ring->temp_map = NULL;
+}
+
+static void stream_ring_write(StreamRing *ring, size_t offset, const void *data, size_t size) {
+	size_t begin = ring->cbuf->base_offset + offset;
+	size_t end = begin + size;
+	char *dest;
+
+	if(ring->persistent_map) {
+		dest = ring->persistent_map + begin;
+	} else {
+		if(ring->temp_map == NULL || begin < ring->map_begin || end > ring->map_end) {
+			CommonBuffer *cbuf = ring->cbuf;
+			stream_ring_unmap(ring);
+
+			// Map the rest of the window, since writes are mostly sequential.
+			ring->map_begin = begin;
+			ring->map_end = cbuf->base_offset + cbuf->size;
+
+			GL33_BUFFER_TEMP_BIND(cbuf, {
+				ring->temp_map = glMapBufferRange(
+					gl33_bindidx_to_glenum(cbuf->bindidx),
+					ring->map_begin,
+					ring->map_end - ring->map_begin,
+					GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT
+				);
+			});
+
+			if(ring->temp_map == NULL) {
+				log_fatal("%s: glMapBufferRange() failed", cbuf->debug_label);
+			}
+		}
+
+		dest = ring->temp_map + (begin - ring->map_begin);
+	}
+
+	memcpy(dest, data, size);
+	ring->window_end = max(ring->window_end, offset + size);
+}
+
+// Gives back the unwritten part of the current window and reserves a new one.
+static void stream_ring_next_window(StreamRing *ring) {
+	size_t size = ring->cbuf->size;
+	size_t written = (ring->window_end + STREAM_WINDOW_ALIGNMENT - 1) & ~(size_t)(STREAM_WINDOW_ALIGNMENT - 1);
+	written = min(written, size);
+
+	stream_ring_unmap(ring);
+	ring_space_unreserve(&ring->space, ring->window + written);
+
+	uint64_t start;
+
+	while(!ring_space_reserve(&ring->space, size, &start)) {
+		if(ring->num_fences == 0) {
+			// Everything in flight was written this frame; fence it now and wait.
+			stream_ring_push_fence(ring, ring->space.head);
+		}
+
+		stream_ring_pop_fence(ring, true);
+	}
+
+	ring->window = start;
+	ring->window_end = 0;
+	ring->cbuf->base_offset = ring_space_offset(&ring->space, start);
+}
+
+static void stream_ring_create(CommonBuffer *cbuf, StreamingMode mode) {
+	StreamRing *ring = calloc(1, sizeof(*ring));
+	ring->cbuf = cbuf;
+	ring->space.size = cbuf->size * STREAM_RING_WINDOWS;
+
+	// The first window
+	ring->space.head = cbuf->size;
+
+	GLenum target = gl33_bindidx_to_glenum(cbuf->bindidx);
+
+	GL33_BUFFER_TEMP_BIND(cbuf, {
+		if(mode == STREAMING_PERSISTENT) {
+			GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+			glBufferStorage(target, ring->space.size, NULL, flags);
+			ring->persistent_map = glMapBufferRange(target, 0, ring->space.size, flags);
+		} else {
+			glBufferData(target, ring->space.size, NULL, GL_STREAM_DRAW);
+		}
+	});
+
+	if(mode == STREAMING_PERSISTENT && ring->persistent_map == NULL) {
+		log_fatal("%s: glMapBufferRange() failed", cbuf->debug_label);
+	}
+
+	free(cbuf->cache.buffer);
+	cbuf->cache.buffer = NULL;
+	cbuf->cache.update_begin = cbuf->size;
+	cbuf->cache.update_end = 0;
+	cbuf->base_offset = 0;
+	cbuf->ring = ring;
+
+	alist_append(&stream_rings, ring);
+
+	log_debug("%s: streaming through a %zukb %s ring",
+		cbuf->debug_label,
+		(size_t)(ring->space.size / 1024),
+		mode == STREAMING_PERSISTENT ? "persistently mapped" : "map-range"
+	);
+}
+
+static void stream_ring_destroy(StreamRing *ring) {
+	while(ring->num_fences > 0) {
+		StreamFence *f = ring->fences + ring->first_fence;
+		glDeleteSync(f->sync);
+		ring->first_fence = (ring->first_fence + 1) % STREAM_RING_MAX_FENCES;
+		ring->num_fences--;
+	}
+
+	CommonBuffer *cbuf = ring->cbuf;
+
+	if(ring->persistent_map || ring->temp_map) {
+		GL33_BUFFER_TEMP_BIND(cbuf, {
+			glUnmapBuffer(gl33_bindidx_to_glenum(cbuf->bindidx));
+		});
+	}
+
+	alist_unlink(&stream_rings, ring);
+	free(ring);
+}
+
+void gl33_buffers_end_frame(void) {
+	for(StreamRing *ring = stream_rings.first; ring; ring = ring->next) {
+		// Retire the fences the GPU has already passed, without waiting on any.
+		while(ring->num_fences > 0) {
+			if(!stream_ring_pop_fence(ring, false)) {
+				break;
+			}
+		}
+
+		if(ring->window_end > 0) {
+			stream_ring_push_fence(ring, ring->window + ring->window_end);
+		}
+	}
+}
+
 void gl33_buffer_destroy(CommonBuffer *cbuf) {
+	if(cbuf->ring) {
+		stream_ring_destroy(cbuf->ring);
+	}
+
 	free(cbuf->cache.buffer);
 	gl33_buffer_deleted(cbuf);
 	glDeleteBuffers(1, &cbuf->gl_handle);
@@ -111,13 +380,33 @@ void gl33_buffer_destroy(CommonBuffer *cbuf) {
 }
 
 void gl33_buffer_invalidate(CommonBuffer *cbuf) {
+	cbuf->offset = 0;
+
+	if(cbuf->ring) {
+		stream_ring_next_window(cbuf->ring);
+		return;
+	}
+
+	// Only buffers that get streamed into are ever invalidated, so that's when we switch them over.
+	StreamingMode mode = gl33_buffer_streaming_mode();
+
+	if(mode != STREAMING_DISABLED) {
+		stream_ring_create(cbuf, mode);
+		return;
+	}
+
 	GL33_BUFFER_TEMP_BIND(cbuf, {
 		glBufferData(gl33_bindidx_to_glenum(cbuf->bindidx), cbuf->size, NULL, GL_DYNAMIC_DRAW);
 	});
-	cbuf->offset = 0;
 }
 
 void gl33_buffer_flush(CommonBuffer *cbuf) {
+	if(cbuf->ring) {
+		// Persistent mappings are coherent; temporary ones have to be released before drawing.
+		stream_ring_unmap(cbuf->ring);
+		return;
+	}
+
 	if(cbuf->cache.update_begin >= cbuf->cache.update_end) {
 		return;
 	}
@@ -15,6 +15,7 @@
 #include "../api.h"
 
 typedef struct CommonBuffer CommonBuffer;
+typedef struct StreamRing StreamRing;
 
 struct CommonBuffer {
 	union {
@@ -22,12 +23,21 @@ struct CommonBuffer {
 		struct {
 			char padding[offsetof(SDL_RWops, hidden)];
 
+			// Shadow copy of the contents, uploaded on flush. Not used by streaming buffers.
 			struct {
 				char *buffer;
 				size_t update_begin;
 				size_t update_end;
 			} cache;
 
+			// Set once the buffer has been invalidated for the first time, if supported.
+			// Writes then go straight into a mapped ring several times the size of the buffer,
+			// and every invalidation moves on to a fresh part of it.
+			StreamRing *ring;
+
+			// Where the buffer's contents begin in the GL buffer object (nonzero only for streaming buffers).
+			size_t base_offset;
+
 			size_t offset;
 			size_t size;
 			GLuint gl_handle;
@@ -51,6 +61,7 @@ void gl33_buffer_destroy(CommonBuffer *cbuf);
 void gl33_buffer_invalidate(CommonBuffer *cbuf);
 SDL_RWops* gl33_buffer_get_stream(CommonBuffer *cbuf);
 void gl33_buffer_flush(CommonBuffer *cbuf);
+void gl33_buffers_end_frame(void);
 
 #define GL33_BUFFER_TEMP_BIND(cbuf, code) do { \
 	CommonBuffer *_tempbind_cbuf = (cbuf); \
@@ -21,12 +21,16 @@
 #include "vertex_buffer.h"
 #include "index_buffer.h"
 #include "vertex_array.h"
+#include "gpu_timer.h"
 #include "../glcommon/debug.h"
 #include "../glcommon/vtable.h"
+#include "../common/shaderlib/lang_glsl.h"
 #include "resource/resource.h"
 #include "resource/model.h"
 #include "util/glm.h"
 #include "util/env.h"
+#include "hirestime.h"
+#include "profiler.h"
 
 typedef struct TextureUnit {
 	LIST_INTERFACE(struct TextureUnit);
@@ -41,6 +45,16 @@ typedef struct TextureUnit {
 
 #define TU_INDEX(unit) ((ptrdiff_t)((unit) - R.texunits.array))
 
+// std140 layout of the r_FrameUniforms block; see lang_glsl.c
+typedef struct FrameUniforms {
+	mat4 projection;
+	vec2 framebuffer_size;
+	float time;
+	float stage_time;
+} FrameUniforms;
+
+static_assert(sizeof(FrameUniforms) == 80, "FrameUniforms must match the std140 layout");
+
 static struct {
 	struct {
 		TextureUnit *array;
@@ -103,6 +117,21 @@ static struct {
 		FloatRect default_framebuffer;
 	} viewport;
 
+	struct {
+		GLuint gl_handle;  // 0 if uniform buffers aren't supported
+		FrameUniforms pending;
+		FrameUniforms active;
+		hrtime_t start_time;
+
+		// Only used if uniform buffers aren't supported.
+		struct {
+			UniformCache projection;
+			UniformCache framebuffer_size;
+			UniformCache time;
+			UniformCache stage_time;
+		} fallback;
+	} frame_uniforms;
+
 	Color color;
 	Color clear_color;
 	float clear_depth;
@@ -117,7 +146,14 @@ static struct {
 		uint draw_calls;
 	} stats;
 	#endif
-} R;
+} R = {
+	.frame_uniforms.fallback = {
+		.projection = UNIFORM_CACHE("r_projectionMatrix"),
+		.framebuffer_size = UNIFORM_CACHE("r_framebufferSize"),
+		.time = UNIFORM_CACHE("r_time"),
+		.stage_time = UNIFORM_CACHE("r_stageTime"),
+	},
+};
 
 /*
  * Internal functions
@@ -244,6 +280,16 @@ static void gl41_set_viewport(const FloatRect *vp) {
 	glViewportIndexedfv(0, &vp->x);
 }
 
+static void gl33_init_frame_uniforms(void) {
+	glGenBuffers(1, &R.frame_uniforms.gl_handle);
+	glBindBuffer(GL_UNIFORM_BUFFER, R.frame_uniforms.gl_handle);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniforms), NULL, GL_DYNAMIC_DRAW);
+	glBindBufferBase(GL_UNIFORM_BUFFER, GLSL_FRAME_UNIFORMS_BINDING, R.frame_uniforms.gl_handle);
+
+	// Force an upload on first use.
+	memset(&R.frame_uniforms.active, 0xff, sizeof(R.frame_uniforms.active));
+}
+
 static void gl33_init_context(SDL_Window *window) {
 	R.gl_context = SDL_GL_CreateContext(window);
 
@@ -298,6 +344,13 @@ static void gl33_init_context(SDL_Window *window) {
 
 	R.features |= r_feature_bit(RFEAT_TEXTURE_BOTTOMLEFT_ORIGIN);
 
+	if(GL_ATLEAST(3, 1) || GLES_ATLEAST(3, 0)) {
+		R.features |= r_feature_bit(RFEAT_UNIFORM_BUFFERS);
+		gl33_init_frame_uniforms();
+	}
+
+	R.frame_uniforms.start_time = time_get();
+
 	if(glext.clear_texture) {
 		_r_backend.funcs.texture_clear = gl44_texture_clear;
 	}
@@ -329,6 +382,24 @@ static inline FloatRect* get_framebuffer_viewport(Framebuffer *fb) {
 	return &fb->viewport;
 }
 
+static void get_framebuffer_size(Framebuffer *fb, vec2 out_size) {
+	if(fb != NULL) {
+		for(uint i = 0; i < FRAMEBUFFER_MAX_ATTACHMENTS; ++i) {
+			if(fb->attachments[i] != NULL) {
+				uint w, h;
+				gl33_texture_get_size(fb->attachments[i], fb->attachment_mipmaps[i], &w, &h);
+				out_size[0] = w;
+				out_size[1] = h;
+				return;
+			}
+		}
+	}
+
+	FloatRect *vp = get_framebuffer_viewport(NULL);
+	out_size[0] = vp->w;
+	out_size[1] = vp->h;
+}
+
 static void gl33_sync_viewport(void) {
 	FloatRect *vp = get_framebuffer_viewport(R.framebuffer.pending);
 
@@ -338,11 +409,33 @@ static void gl33_sync_viewport(void) {
 	}
 }
 
+static void gl33_sync_frame_uniforms(void) {
+	FrameUniforms *fu = &R.frame_uniforms.pending;
+	glm_mat4_copy(*_r_matrices.projection.head, fu->projection);
+	get_framebuffer_size(R.framebuffer.pending, fu->framebuffer_size);
+
+	if(!R.frame_uniforms.gl_handle) {
+		ShaderProgram *prog = R.progs.active;
+		r_uniform_mat4(r_shader_uniform_cached(prog, &R.frame_uniforms.fallback.projection), fu->projection);
+		r_uniform_vec2_vec(r_shader_uniform_cached(prog, &R.frame_uniforms.fallback.framebuffer_size), fu->framebuffer_size);
+		r_uniform_float(r_shader_uniform_cached(prog, &R.frame_uniforms.fallback.time), fu->time);
+		r_uniform_float(r_shader_uniform_cached(prog, &R.frame_uniforms.fallback.stage_time), fu->stage_time);
+		return;
+	}
+
+	// Shared by all programs, so switching shaders doesn't cost anything here.
+	if(memcmp(&R.frame_uniforms.active, fu, sizeof(*fu))) {
+		glBindBuffer(GL_UNIFORM_BUFFER, R.frame_uniforms.gl_handle);
+		glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(*fu), fu);
+		R.frame_uniforms.active = *fu;
+	}
+}
+
 static void gl33_sync_state(void) {
 	gl33_sync_capabilities();
 	gl33_sync_shader();
+	gl33_sync_frame_uniforms();
 	r_uniform_mat4("r_modelViewMatrix", *_r_matrices.modelview.head);
-	r_uniform_mat4("r_projectionMatrix", *_r_matrices.projection.head);
 	r_uniform_mat4("r_textureMatrix", *_r_matrices.texture.head);
 	r_uniform_vec4_rgba("r_color", &R.color);
 	gl33_sync_uniforms(R.progs.active);
@@ -819,6 +912,13 @@ static void gl33_post_init(void) {
 }
 
 static void gl33_shutdown(void) {
+	gl33_texture_uploads_shutdown();
+	gl33_gpu_timers_shutdown();
+
+	if(R.frame_uniforms.gl_handle) {
+		glDeleteBuffers(1, &R.frame_uniforms.gl_handle);
+	}
+
 	glcommon_unload_library();
 	SDL_GL_DeleteContext(R.gl_context);
 }
@@ -995,11 +1095,24 @@ void gl33_set_clear_depth(float depth) {
 	}
 }
 
+static void gl33_stage_time(float seconds) {
+	R.frame_uniforms.pending.stage_time = seconds;
+}
+
 static void gl33_swap(SDL_Window *window) {
+	PROFILE_ZONE("gl33_swap");
 	r_flush_sprites();
 	gl33_sync_framebuffer();
+	gl33_buffers_end_frame();
+	gl33_texture_uploads_end_frame();
+
+	PROFILE_BEGIN(pz_swap, "SDL_GL_SwapWindow");
 	SDL_GL_SwapWindow(window);
+	PROFILE_END(pz_swap);
+
+	gl33_gpu_timers_end_frame();
 	gl33_stats_post_frame();
+	R.frame_uniforms.pending.time = (time_get() - R.frame_uniforms.start_time) / (double)HRTIME_RESOLUTION;
 
 	if(glext.version.is_webgl) {
 		// We can't rely on viewport being preserved across frames,
@@ -1076,6 +1189,7 @@ RendererBackend _r_backend_gl33 = {
 		.shader_program_get_debug_label = gl33_shader_program_get_debug_label,
 		.shader = gl33_shader,
 		.shader_current = gl33_shader_current,
+		.stage_time = gl33_stage_time,
 		.shader_uniform = gl33_shader_uniform,
 		.uniform = gl33_uniform,
 		.uniform_type = gl33_uniform_type,
@@ -1090,6 +1204,9 @@ RendererBackend _r_backend_gl33 = {
 		.texture_invalidate = gl33_texture_invalidate,
 		.texture_fill = gl33_texture_fill,
 		.texture_fill_region = gl33_texture_fill_region,
+		.texture_fill_async = gl33_texture_fill_async,
+		.texture_is_resident = gl33_texture_is_resident,
+		.texture_upload_stats = gl33_texture_upload_stats,
 		.texture_clear = gl33_texture_clear,
 		.framebuffer_create = gl33_framebuffer_create,
 		.framebuffer_destroy = gl33_framebuffer_destroy,
@@ -1129,6 +1246,9 @@ RendererBackend _r_backend_gl33 = {
 		.vsync = gl33_vsync,
 		.vsync_current = gl33_vsync_current,
 		.swap = gl33_swap,
+		.gpu_timer_begin = gl33_gpu_timer_begin,
+		.gpu_timer_end = gl33_gpu_timer_end,
+		.gpu_timer_stats = gl33_gpu_timer_stats,
 		.screenshot = gl33_screenshot,
 	},
 	.custom = &(GLBackendData) {
@@ -0,0 +1,254 @@
+/*
+ * This software is licensed under the terms of the MIT-License
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2019, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2019, Andrei Alexeyev <akari@alienslab.net>.
+ */
+
+#include "taisei.h"
+
+#include "gpu_timer.h"
+#include "opengl.h"
+#include "util.h"
+
+#ifdef DEBUG
+	#define GPU_TIMERS_DEFAULT 1
+#else
+	#define GPU_TIMERS_DEFAULT 0
+#endif
+
+// How many frames may be waiting for their results at once. If the GPU falls behind
+// further than that, frames go unrecorded until it catches up; we never wait on it.
+#define GPU_TIMER_FRAMES 4
+
+// A pass takes a query whenever it's entered, and whenever a pass nested in it ends.
+#define GPU_TIMER_MAX_QUERIES 64
+
+#define GPU_TIMER_MAX_DEPTH 8
+
+typedef struct GPUTimerFrame {
+	GLuint queries[GPU_TIMER_MAX_QUERIES];
+	uint8_t query_passes[GPU_TIMER_MAX_QUERIES];
+	uint num_queries;
+	uint64_t serial;
+	bool pending;  // recorded, but the results are not collected yet
+
+	// Pass names and times, accumulated as the results come in.
+	GPUTimerStats results;
+} GPUTimerFrame;
+
+static struct {
+	GPUTimerFrame frames[GPU_TIMER_FRAMES];
+	GPUTimerFrame *current;  // NULL if this frame is not being recorded
+	uint64_t frame_serial;
+
+	int stack[GPU_TIMER_MAX_DEPTH];  // pass indices; -1 for passes that didn't fit
+	uint depth;
+	bool query_active;
+
+	GPUTimerStats stats;
+	bool initialized;
+	bool enabled;
+} timers;
+
+static void timers_init(void) {
+	timers.initialized = true;
+	timers.enabled = glext.timer_query && env_get("TAISEI_GL_GPU_TIMERS", GPU_TIMERS_DEFAULT);
+
+	if(!timers.enabled) {
+		return;
+	}
+
+	for(uint i = 0; i < GPU_TIMER_FRAMES; ++i) {
+		glGenQueries(GPU_TIMER_MAX_QUERIES, timers.frames[i].queries);
+	}
+
+	timers.current = timers.frames;
+	log_debug("GPU timers enabled");
+}
+
+static int find_pass(GPUTimerFrame *f, const char *name) {
+	GPUTimerStats *r = &f->results;
+
+	for(uint i = 0; i < r->num_passes; ++i) {
+		if(!strncmp(r->passes[i].name, name, sizeof(r->passes[i].name) - 1)) {
+			return i;
+		}
+	}
+
+	if(r->num_passes == R_GPU_TIMER_MAX_PASSES) {
+		return -1;
+	}
+
+	uint i = r->num_passes++;
+	strlcpy(r->passes[i].name, name, sizeof(r->passes[i].name));
+	r->passes[i].time = 0;
+	return i;
+}
+
+static void start_query(int pass) {
+	GPUTimerFrame *f = timers.current;
+
+	if(!f || pass < 0 || f->num_queries == GPU_TIMER_MAX_QUERIES) {
+		return;
+	}
+
+	assert(!timers.query_active);
+	f->query_passes[f->num_queries] = pass;
+	glBeginQuery(GL_TIME_ELAPSED, f->queries[f->num_queries]);
+	timers.query_active = true;
+}
+
+static void stop_query(void) {
+	if(timers.query_active) {
+		glEndQuery(GL_TIME_ELAPSED);
+		timers.current->num_queries++;
+		timers.query_active = false;
+	}
+}
+
+void gl33_gpu_timer_begin(const char *name) {
+	if(!timers.initialized) {
+		timers_init();
+	}
+
+	if(!timers.enabled) {
+		return;
+	}
+
+	assert(timers.depth < GPU_TIMER_MAX_DEPTH);
+
+	if(timers.depth++ >= GPU_TIMER_MAX_DEPTH) {
+		// Nested too deep; just count this one towards its parent.
+		return;
+	}
+
+	// Whatever was batched up so far belongs to the previous pass. Only flushed when
+	// timing, so that the passes don't split batches otherwise.
+	r_flush_sprites();
+
+	// Only one time query can be active at a time; the outer pass resumes once this one ends.
+	stop_query();
+
+	int pass = timers.current ? find_pass(timers.current, name) : -1;
+	timers.stack[timers.depth - 1] = pass;
+	start_query(pass);
+}
+
+void gl33_gpu_timer_end(void) {
+	if(!timers.enabled) {
+		return;
+	}
+
+	assert(timers.depth > 0);
+
+	if(timers.depth == 0 || timers.depth-- > GPU_TIMER_MAX_DEPTH) {
+		return;
+	}
+
+	r_flush_sprites();
+	stop_query();
+
+	if(timers.depth > 0) {
+		start_query(timers.stack[timers.depth - 1]);
+	}
+}
+
+void gl33_gpu_timer_stats(GPUTimerStats *stats) {
+	memcpy(stats, &timers.stats, sizeof(*stats));
+}
+
+static bool frame_ready(GPUTimerFrame *f) {
+	if(f->num_queries == 0) {
+		return true;
+	}
+
+	// Queries complete in order, so checking the last one is enough.
+	GLuint available = GL_FALSE;
+	glGetQueryObjectuiv(f->queries[f->num_queries - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+	return available;
+}
+
+static void frame_collect(GPUTimerFrame *f) {
+	for(uint i = 0; i < f->num_queries; ++i) {
+		GLuint64 ns = 0;
+		glGetQueryObjectui64v(f->queries[i], GL_QUERY_RESULT, &ns);
+		f->results.passes[f->query_passes[i]].time += ns * (HRTIME_RESOLUTION / 1000000000);
+	}
+
+	memcpy(&timers.stats, &f->results, sizeof(timers.stats));
+	timers.stats.latency = timers.frame_serial - f->serial;
+	timers.stats.available = true;
+	f->pending = false;
+}
+
+void gl33_gpu_timers_end_frame(void) {
+	if(!timers.enabled) {
+		return;
+	}
+
+	if(timers.depth > 0) {
+		log_warn("%u GPU timer passes were never ended", timers.depth);
+		stop_query();
+		timers.depth = 0;
+	}
+
+	if(timers.current) {
+		timers.current->serial = timers.frame_serial;
+		timers.current->pending = true;
+	}
+
+	bool disjoint = false;
+
+	if(glext.timer_query & TSGL_EXTFLAG_EXT) {
+		// Set when something (e.g. a GPU clock change) made the queries in flight meaningless.
+		GLint value = 0;
+		glGetIntegerv(GL_GPU_DISJOINT_EXT, &value);
+		disjoint = value;
+	}
+
+	++timers.frame_serial;
+
+	// Oldest first; the slot after the frame that has just ended is the one that's reused next.
+	for(uint i = 0; i < GPU_TIMER_FRAMES; ++i) {
+		GPUTimerFrame *f = timers.frames + (timers.frame_serial + i) % GPU_TIMER_FRAMES;
+
+		if(!f->pending) {
+			continue;
+		}
+
+		if(disjoint) {
+			f->pending = false;
+			continue;
+		}
+
+		if(!frame_ready(f)) {
+			break;
+		}
+
+		frame_collect(f);
+	}
+
+	GPUTimerFrame *next = timers.frames + timers.frame_serial % GPU_TIMER_FRAMES;
+
+	if(next->pending) {
+		timers.current = NULL;
+	} else {
+		next->num_queries = 0;
+		next->results.num_passes = 0;
+		timers.current = next;
+	}
+}
+
+void gl33_gpu_timers_shutdown(void) {
+	if(timers.enabled) {
+		stop_query();
+
+		for(uint i = 0; i < GPU_TIMER_FRAMES; ++i) {
+			glDeleteQueries(GPU_TIMER_MAX_QUERIES, timers.frames[i].queries);
+		}
+	}
+
+	memset(&timers, 0, sizeof(timers));
+}
@@ -0,0 +1,22 @@
+/*
+ * This software is licensed under the terms of the MIT-License
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2019, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2019, Andrei Alexeyev <akari@alienslab.net>.
+ */
+
+#ifndef IGUARD_renderer_gl33_gpu_timer_h
+#define IGUARD_renderer_gl33_gpu_timer_h
+
+#include "taisei.h"
+
+#include "../api.h"
+
+void gl33_gpu_timer_begin(const char *name);
+void gl33_gpu_timer_end(void);
+void gl33_gpu_timer_stats(GPUTimerStats *stats);
+void gl33_gpu_timers_end_frame(void);
+void gl33_gpu_timers_shutdown(void);
+
+#endif // IGUARD_renderer_gl33_gpu_timer_h
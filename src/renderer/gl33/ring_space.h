@@ -0,0 +1,70 @@
+/*
+ * This software is licensed under the terms of the MIT-License
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2019, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2019, Andrei Alexeyev <akari@alienslab.net>.
+ */
+
+#ifndef IGUARD_renderer_gl33_ring_space_h
+#define IGUARD_renderer_gl33_ring_space_h
+
+#include "taisei.h"
+
+/*
+ * Space accounting for the streaming buffer rings (see common_buffer.c), kept free of GL
+ * so that it can be tested on its own.
+ *
+ * Positions are monotonic byte offsets; the actual offset into the ring is pos % size.
+ * Everything in [tail, head) is either reserved for writing or may still be read by the GPU,
+ * so a full ring (head - tail == size) can't be confused with an empty one.
+ */
+
+typedef struct RingSpace {
+	uint64_t size;
+	uint64_t head;  // end of the reserved area
+	uint64_t tail;  // start of the area that may still be in use
+} RingSpace;
+
+static inline size_t ring_space_offset(const RingSpace *rs, uint64_t pos) {
+	return pos % rs->size;
+}
+
+static inline uint64_t ring_space_used(const RingSpace *rs) {
+	return rs->head - rs->tail;
+}
+
+// Reserves size contiguous bytes after head, skipping the rest of the ring if they would
+// wrap around. Returns false if that would overwrite anything in use; release some, and retry.
+static inline bool ring_space_reserve(RingSpace *rs, size_t size, uint64_t *out_start) {
+	assert(size <= rs->size);
+
+	uint64_t start = rs->head;
+	size_t ofs = ring_space_offset(rs, start);
+
+	if(ofs + size > rs->size) {
+		start += rs->size - ofs;
+	}
+
+	if(start + size - rs->tail > rs->size) {
+		return false;
+	}
+
+	rs->head = start + size;
+	*out_start = start;
+	return true;
+}
+
+// Gives back the reserved space after pos, which must not have been written to.
+static inline void ring_space_unreserve(RingSpace *rs, uint64_t pos) {
+	assert(pos >= rs->tail && pos <= rs->head);
+	rs->head = pos;
+}
+
+// Everything before pos is no longer in use.
+static inline void ring_space_release(RingSpace *rs, uint64_t pos) {
+	assert(pos >= rs->tail && pos <= rs->head);
+	rs->tail = pos;
+}
+
+#endif // IGUARD_renderer_gl33_ring_space_h
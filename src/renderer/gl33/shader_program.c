@@ -12,6 +12,7 @@
 #include "shader_program.h"
 #include "shader_object.h"
 #include "../glcommon/debug.h"
+#include "../common/shaderlib/lang_glsl.h"
 #include "../api.h"
 
 static Uniform *sampler_uniforms;
@@ -162,6 +163,9 @@ static MagicalUniform magical_unfiroms[] = {
 	{ "r_projectionMatrix", "mat4", UNIFORM_MAT4 },
 	{ "r_textureMatrix",    "mat4", UNIFORM_MAT4 },
 	{ "r_color",            "vec4", UNIFORM_VEC4 },
+	{ "r_framebufferSize",  "vec2", UNIFORM_VEC2 },
+	{ "r_time",             "float", UNIFORM_FLOAT },
+	{ "r_stageTime",        "float", UNIFORM_FLOAT },
 };
 
 static void gl33_update_uniform(Uniform *uniform, uint offset, uint count, const void *data) {
@@ -440,6 +444,14 @@ ShaderProgram* gl33_shader_program_link(uint num_objects, ShaderObject *shobjs[n
 		return NULL;
 	}
 
+	if(r_supports(RFEAT_UNIFORM_BUFFERS)) {
+		GLuint block = glGetUniformBlockIndex(prog->gl_handle, GLSL_FRAME_UNIFORMS_BLOCK);
+
+		if(block != GL_INVALID_INDEX) {
+			glUniformBlockBinding(prog->gl_handle, block, GLSL_FRAME_UNIFORMS_BINDING);
+		}
+	}
+
 	return prog;
 }
 
@@ -13,6 +13,37 @@
 #include "opengl.h"
 #include "gl33.h"
 #include "../glcommon/debug.h"
+#include "list.h"
+
+// Default per-frame budget for async uploads, in KiB. 0 makes them synchronous.
+#define UPLOAD_DEFAULT_BUDGET 4096
+
+// Frames that spend longer than this on uploads are counted as hitches.
+#define UPLOAD_HITCH_THRESHOLD (HRTIME_RESOLUTION / 500)
+
+struct TextureUpload {
+	LIST_INTERFACE(TextureUpload);
+	Texture *tex;
+	GLTextureFormatTuple *fmt;
+	Pixmap pixmap;
+	uint mipmap;
+	uint rows_done;
+};
+
+static struct {
+	LIST_ANCHOR(TextureUpload) queue;
+	GLuint staging_pbo;
+	size_t frame_budget;
+	bool initialized;
+
+	struct {
+		size_t bytes;
+		hrtime_t time;
+		bool forced;
+	} frame;
+
+	TextureUploadStats stats;
+} uploads;
 
 static GLenum linear_to_nearest(GLenum filter) {
 	switch(filter) {
@@ -211,6 +242,178 @@ static void gl33_texture_set(Texture *tex, uint mipmap, const Pixmap *image) {
 	tex->mipmaps_outdated = true;
 }
 
+static size_t upload_row_size(TextureUpload *up) {
+	return up->pixmap.width * PIXMAP_FORMAT_PIXEL_SIZE(up->pixmap.format);
+}
+
+static void upload_free(TextureUpload *up) {
+	alist_unlink(&uploads.queue, up);
+	uploads.stats.pending_bytes -= upload_row_size(up) * (up->pixmap.height - up->rows_done);
+	uploads.stats.pending--;
+	up->tex->upload = NULL;
+	free(up->pixmap.data.untyped);
+	free(up);
+}
+
+static void upload_rows(TextureUpload *up, uint num_rows) {
+	Texture *tex = up->tex;
+	size_t row_size = upload_row_size(up);
+	size_t size = row_size * num_rows;
+	void *data = (char*)up->pixmap.data.untyped + row_size * up->rows_done;
+	GLuint prev_pbo = 0;
+
+	assert(up->rows_done + num_rows <= up->pixmap.height);
+
+	gl33_bind_texture(tex, false);
+	gl33_sync_texunit(tex->binding_unit, false, true);
+
+	if(uploads.staging_pbo) {
+		// Respecifying the whole buffer lets the driver hand us fresh storage while the
+		// previous chunk is still in flight, and the transfer itself happens asynchronously.
+		prev_pbo = gl33_buffer_current(GL33_BUFFER_BINDING_PIXEL_UNPACK);
+		gl33_bind_buffer(GL33_BUFFER_BINDING_PIXEL_UNPACK, uploads.staging_pbo);
+		gl33_sync_buffer(GL33_BUFFER_BINDING_PIXEL_UNPACK);
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, size, data, GL_STREAM_DRAW);
+		data = NULL;
+	}
+
+	glTexSubImage2D(
+		GL_TEXTURE_2D, up->mipmap,
+		0, up->rows_done, up->pixmap.width, num_rows,
+		up->fmt->gl_fmt,
+		up->fmt->gl_type,
+		data
+	);
+
+	if(uploads.staging_pbo) {
+		// Unbind right away: other uploads pass client memory and expect no PBO.
+		gl33_bind_buffer(GL33_BUFFER_BINDING_PIXEL_UNPACK, prev_pbo);
+		gl33_sync_buffer(GL33_BUFFER_BINDING_PIXEL_UNPACK);
+	}
+
+	up->rows_done += num_rows;
+	uploads.stats.pending_bytes -= size;
+	uploads.frame.bytes += size;
+
+	if(up->rows_done == up->pixmap.height) {
+		// Mipmaps are generated lazily, on first use; see gl33_texture_prepare.
+		tex->mipmaps_outdated = true;
+		upload_free(up);
+	}
+}
+
+static void texture_finish_upload(Texture *tex) {
+	if(tex->upload) {
+		log_debug("Forcing upload of %s (%u)", tex->debug_label, tex->gl_handle);
+		hrtime_t start = time_get();
+		upload_rows(tex->upload, tex->upload->pixmap.height - tex->upload->rows_done);
+		uploads.frame.time += time_get() - start;
+		uploads.frame.forced = true;
+	}
+}
+
+static void texture_cancel_upload(Texture *tex) {
+	if(tex->upload) {
+		upload_free(tex->upload);
+	}
+}
+
+static void uploads_init(void) {
+	uploads.frame_budget = env_get("TAISEI_GL_TEXTURE_UPLOAD_BUDGET", UPLOAD_DEFAULT_BUDGET) * 1024;
+
+	if(uploads.frame_budget > 0 && glext.pixel_buffer_object) {
+		glGenBuffers(1, &uploads.staging_pbo);
+	}
+
+	uploads.initialized = true;
+}
+
+void gl33_texture_fill_async(Texture *tex, uint mipmap, const Pixmap *image) {
+	assert(mipmap == 0 || tex->params.mipmap_mode != TEX_MIPMAP_AUTO);
+
+	if(!uploads.initialized) {
+		uploads_init();
+	}
+
+	if(tex->upload) {
+		if(tex->upload->mipmap == mipmap) {
+			texture_cancel_upload(tex);
+		} else {
+			texture_finish_upload(tex);
+		}
+	}
+
+	if(uploads.frame_budget == 0) {
+		gl33_texture_set(tex, mipmap, image);
+		return;
+	}
+
+	TextureUpload *up = calloc(1, sizeof(*up));
+	up->tex = tex;
+	up->mipmap = mipmap;
+	up->fmt = prepare_pixmap(tex, image, &up->pixmap);
+
+	attr_unused uint width, height;
+	gl33_texture_get_size(tex, mipmap, &width, &height);
+	assert(up->pixmap.width == width);
+	assert(up->pixmap.height == height);
+
+	tex->upload = up;
+	alist_append(&uploads.queue, up);
+	uploads.stats.pending_bytes += pixmap_data_size(&up->pixmap);
+	uploads.stats.pending++;
+}
+
+bool gl33_texture_is_resident(Texture *tex) {
+	return tex->upload == NULL;
+}
+
+void gl33_texture_upload_stats(TextureUploadStats *stats) {
+	memcpy(stats, &uploads.stats, sizeof(*stats));
+}
+
+void gl33_texture_uploads_end_frame(void) {
+	if(uploads.queue.first) {
+		size_t budget = uploads.frame_budget;
+		hrtime_t start = time_get();
+
+		while(uploads.queue.first && budget > 0) {
+			TextureUpload *up = uploads.queue.first;
+			size_t row_size = upload_row_size(up);
+			uint rows = umin(up->pixmap.height - up->rows_done, umax(1, budget / row_size));
+			budget -= umin(budget, rows * row_size);
+			upload_rows(up, rows);
+		}
+
+		uploads.frame.time += time_get() - start;
+	}
+
+	uploads.stats.frame_bytes = uploads.frame.bytes;
+	uploads.stats.frame_time = uploads.frame.time;
+
+	if(uploads.frame.forced || uploads.frame.time > UPLOAD_HITCH_THRESHOLD) {
+		uploads.stats.hitches++;
+	}
+
+	memset(&uploads.frame, 0, sizeof(uploads.frame));
+}
+
+void gl33_texture_uploads_shutdown(void) {
+	if(uploads.stats.pending) {
+		log_debug("%u texture uploads were still pending", uploads.stats.pending);
+	}
+
+	while(uploads.queue.first) {
+		upload_free(uploads.queue.first);
+	}
+
+	if(uploads.staging_pbo) {
+		glDeleteBuffers(1, &uploads.staging_pbo);
+	}
+
+	memset(&uploads, 0, sizeof(uploads));
+}
+
 Texture* gl33_texture_create(const TextureParams *params) {
 	Texture *tex = calloc(1, sizeof(Texture));
 	memcpy(&tex->params, params, sizeof(*params));
@@ -315,6 +518,7 @@ void gl33_texture_set_wrap(Texture *tex, TextureWrapMode ws, TextureWrapMode wt)
 }
 
 void gl33_texture_invalidate(Texture *tex) {
+	texture_cancel_upload(tex);
 	gl33_bind_texture(tex, false);
 	gl33_sync_texunit(tex->binding_unit, false, true);
 
@@ -338,12 +542,20 @@ void gl33_texture_invalidate(Texture *tex) {
 
 void gl33_texture_fill(Texture *tex, uint mipmap, const Pixmap *image) {
 	assert(mipmap == 0 || tex->params.mipmap_mode != TEX_MIPMAP_AUTO);
+
+	if(tex->upload && tex->upload->mipmap == mipmap) {
+		texture_cancel_upload(tex);
+	}
+
+	texture_finish_upload(tex);
 	gl33_texture_set(tex, mipmap, image);
 }
 
 void gl33_texture_fill_region(Texture *tex, uint mipmap, uint x, uint y, const Pixmap *image) {
 	assert(mipmap == 0 || tex->params.mipmap_mode != TEX_MIPMAP_AUTO);
 
+	texture_finish_upload(tex);
+
 	gl33_bind_texture(tex, false);
 	gl33_sync_texunit(tex->binding_unit, false, true);
 
@@ -363,12 +575,16 @@ void gl33_texture_fill_region(Texture *tex, uint mipmap, uint x, uint y, const P
 }
 
 void gl44_texture_clear(Texture *tex, const Color *clr) {
+	texture_cancel_upload(tex);
+
 	for(int i = 0; i < tex->params.mipmaps; ++i) {
 		glClearTexImage(tex->gl_handle, i, GL_RGBA, GL_FLOAT, &clr->r);
 	}
 }
 
 void gl33_texture_clear(Texture *tex, const Color *clr) {
+	texture_cancel_upload(tex);
+
 	// TODO: maybe find a more efficient method
 	Framebuffer *temp_fb = r_framebuffer_create();
 	r_framebuffer_attach(temp_fb, tex, 0, FRAMEBUFFER_ATTACH_COLOR0);
@@ -377,6 +593,7 @@ void gl33_texture_clear(Texture *tex, const Color *clr) {
 }
 
 void gl33_texture_destroy(Texture *tex) {
+	texture_cancel_upload(tex);
 	gl33_texture_deleted(tex);
 
 	glDeleteTextures(1, &tex->gl_handle);
@@ -393,6 +610,8 @@ void gl33_texture_taint(Texture *tex) {
 }
 
 void gl33_texture_prepare(Texture *tex) {
+	texture_finish_upload(tex);
+
 	if(tex->params.mipmap_mode == TEX_MIPMAP_AUTO && tex->mipmaps_outdated) {
 		log_debug("Generating mipmaps for %s (%u)", tex->debug_label, tex->gl_handle);
 
@@ -17,9 +17,12 @@
 #include "resource/texture.h"
 #include "../glcommon/vtable.h"
 
+typedef struct TextureUpload TextureUpload;
+
 typedef struct Texture {
 	GLTextureTypeInfo *type_info;
 	TextureUnit *binding_unit;
+	TextureUpload *upload;  // queued async upload; NULL when resident
 	GLuint gl_handle;
 	GLuint pbo;
 	TextureParams params;
@@ -37,6 +40,11 @@ void gl33_texture_set_wrap(Texture *tex, TextureWrapMode ws, TextureWrapMode wt)
 void gl33_texture_invalidate(Texture *tex);
 void gl33_texture_fill(Texture *tex, uint mipmap, const Pixmap *image);
 void gl33_texture_fill_region(Texture *tex, uint mipmap, uint x, uint y, const Pixmap *image);
+void gl33_texture_fill_async(Texture *tex, uint mipmap, const Pixmap *image);
+bool gl33_texture_is_resident(Texture *tex);
+void gl33_texture_upload_stats(TextureUploadStats *stats);
+void gl33_texture_uploads_end_frame(void);
+void gl33_texture_uploads_shutdown(void);
 void gl33_texture_prepare(Texture *tex);
 void gl33_texture_taint(Texture *tex);
 void gl44_texture_clear(Texture *tex, const Color *clr);
@@ -41,6 +41,7 @@ void gl33_vertex_array_destroy(VertexArray *varr) {
 	gl33_vertex_array_deleted(varr);
 	glDeleteVertexArrays(1, &varr->gl_handle);
 	free(varr->attachments);
+	free(varr->attachment_base_offsets);
 	free(varr->attribute_layout);
 	free(varr);
 }
@@ -76,6 +77,9 @@ static void gl33_vertex_array_update_layout(VertexArray *varr) {
 			continue;
 		}
 
+		uintptr_t offset = a->offset + vbuf->cbuf.base_offset;
+		varr->attachment_base_offsets[a->attachment] = vbuf->cbuf.base_offset;
+
 		gl33_sync_vao();
 
 		gl33_bind_buffer(GL33_BUFFER_BINDING_ARRAY, vbuf->cbuf.gl_handle);
@@ -92,7 +96,7 @@ static void gl33_vertex_array_update_layout(VertexArray *varr) {
 					va_type_to_gl_type[a->spec.type],
 					a->spec.coversion == VA_CONVERT_FLOAT_NORMALIZED,
 					a->stride,
-					(void*)a->offset
+					(void*)offset
 				);
 
 				break;
@@ -103,7 +107,7 @@ static void gl33_vertex_array_update_layout(VertexArray *varr) {
 					a->spec.elements,
 					va_type_to_gl_type[a->spec.type],
 					a->stride,
-					(void*)a->offset
+					(void*)offset
 				);
 
 				break;
@@ -136,10 +140,12 @@ void gl33_vertex_array_attach_vertex_buffer(VertexArray *varr, VertexBuffer *vbu
 	// TODO: more efficient way of handling this?
 	if(attachment >= varr->num_attachments) {
 		varr->attachments = realloc(varr->attachments, (attachment + 1) * sizeof(VertexBuffer*));
+		varr->attachment_base_offsets = realloc(varr->attachment_base_offsets, (attachment + 1) * sizeof(size_t));
 		varr->num_attachments = attachment + 1;
 	}
 
 	varr->attachments[attachment] = vbuf;
+	varr->attachment_base_offsets[attachment] = vbuf ? vbuf->cbuf.base_offset : 0;
 	varr->layout_dirty_bits |= (1u << attachment);
 }
 
@@ -179,6 +185,21 @@ void gl33_vertex_array_set_debug_label(VertexArray *varr, const char *label) {
 }
 
 void gl33_vertex_array_flush_buffers(VertexArray *varr) {
+	// Streaming buffers move their contents around; the attribute pointers have to follow.
+	for(uint i = 0; i < varr->num_attributes; ++i) {
+		VertexAttribFormat *a = varr->attribute_layout + i;
+
+		if(a->attachment >= varr->num_attachments) {
+			continue;
+		}
+
+		VertexBuffer *vbuf = varr->attachments[a->attachment];
+
+		if(vbuf != NULL && vbuf->cbuf.base_offset != varr->attachment_base_offsets[a->attachment]) {
+			varr->layout_dirty_bits |= (1u << i);
+		}
+	}
+
 	if(varr->layout_dirty_bits) {
 		gl33_vertex_array_update_layout(varr);
 	}
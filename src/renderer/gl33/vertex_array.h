@@ -19,6 +19,7 @@
 
 struct VertexArray {
 	VertexBuffer **attachments;
+	size_t *attachment_base_offsets;  // as of the last layout update; see CommonBuffer.base_offset
 	VertexAttribFormat *attribute_layout;
 	IndexBuffer *index_attachment;
 	GLuint gl_handle;
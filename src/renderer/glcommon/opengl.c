@@ -94,6 +94,12 @@ ext_flag_t glcommon_require_extension(const char *ext) {
 	return val;
 }
 
+// For entry points that glad doesn't know about. Goes through a void** like the glad
+// loaders do, since ISO C doesn't allow converting void* to a function pointer.
+static bool glcommon_load_proc(void *pfunc, const char *name) {
+	return (*(void**)pfunc = SDL_GL_GetProcAddress(name));
+}
+
 static void glcommon_ext_debug_output(void) {
 	if(
 		GL_ATLEAST(4, 3)
@@ -321,6 +327,34 @@ static void glcommon_ext_texture_filter_anisotropic(void) {
 	log_warn("Extension not supported");
 }
 
+static void glcommon_ext_buffer_storage(void) {
+	if(
+		GL_ATLEAST(4, 4)
+		&& glcommon_load_proc(&glext.BufferStorage, "glBufferStorage")
+	) {
+		glext.buffer_storage = TSGL_EXTFLAG_NATIVE;
+		log_info("Using core functionality");
+		return;
+	}
+
+	if((glext.buffer_storage = glcommon_check_extension("GL_ARB_buffer_storage"))
+		&& glcommon_load_proc(&glext.BufferStorage, "glBufferStorage")
+	) {
+		log_info("Using GL_ARB_buffer_storage");
+		return;
+	}
+
+	if((glext.buffer_storage = glcommon_check_extension("GL_EXT_buffer_storage"))
+		&& glcommon_load_proc(&glext.BufferStorage, "glBufferStorageEXT")
+	) {
+		log_info("Using GL_EXT_buffer_storage");
+		return;
+	}
+
+	glext.buffer_storage = 0;
+	log_warn("Extension not supported");
+}
+
 static void glcommon_ext_clear_texture(void) {
 	if(GL_ATLEAST(4, 4)) {
 		glext.clear_texture = TSGL_EXTFLAG_NATIVE;
@@ -433,6 +467,48 @@ static void glcommon_ext_float_blend(void) {
 	log_warn("Extension not supported");
 }
 
+static void glcommon_ext_timer_query(void) {
+	if(GL_ATLEAST(3, 3)
+		&& (glext.GenQueries = glad_glGenQueries)
+		&& (glext.DeleteQueries = glad_glDeleteQueries)
+		&& (glext.BeginQuery = glad_glBeginQuery)
+		&& (glext.EndQuery = glad_glEndQuery)
+		&& (glext.GetQueryObjectuiv = glad_glGetQueryObjectuiv)
+		&& (glext.GetQueryObjectui64v = glad_glGetQueryObjectui64v)
+	) {
+		glext.timer_query = TSGL_EXTFLAG_NATIVE;
+		log_info("Using core functionality");
+		return;
+	}
+
+	if((glext.timer_query = glcommon_check_extension("GL_ARB_timer_query"))
+		&& (glext.GenQueries = glad_glGenQueries)
+		&& (glext.DeleteQueries = glad_glDeleteQueries)
+		&& (glext.BeginQuery = glad_glBeginQuery)
+		&& (glext.EndQuery = glad_glEndQuery)
+		&& (glext.GetQueryObjectuiv = glad_glGetQueryObjectuiv)
+		&& glcommon_load_proc(&glext.GetQueryObjectui64v, "glGetQueryObjectui64v")
+	) {
+		log_info("Using GL_ARB_timer_query");
+		return;
+	}
+
+	if((glext.timer_query = glcommon_check_extension("GL_EXT_disjoint_timer_query"))
+		&& glcommon_load_proc(&glext.GenQueries, "glGenQueriesEXT")
+		&& glcommon_load_proc(&glext.DeleteQueries, "glDeleteQueriesEXT")
+		&& glcommon_load_proc(&glext.BeginQuery, "glBeginQueryEXT")
+		&& glcommon_load_proc(&glext.EndQuery, "glEndQueryEXT")
+		&& glcommon_load_proc(&glext.GetQueryObjectuiv, "glGetQueryObjectuivEXT")
+		&& glcommon_load_proc(&glext.GetQueryObjectui64v, "glGetQueryObjectui64vEXT")
+	) {
+		log_info("Using GL_EXT_disjoint_timer_query");
+		return;
+	}
+
+	glext.timer_query = 0;
+	log_warn("Extension not supported");
+}
+
 static void glcommon_ext_vertex_array_object(void) {
 	if((GL_ATLEAST(3, 0) || GLES_ATLEAST(3, 0))
 		&& (glext.BindVertexArray = glad_glBindVertexArray)
@@ -564,6 +640,7 @@ void glcommon_check_extensions(void) {
 	}
 
 	glcommon_ext_base_instance();
+	glcommon_ext_buffer_storage();
 	glcommon_ext_clear_texture();
 	glcommon_ext_color_buffer_float();
 	glcommon_ext_debug_output();
@@ -577,6 +654,7 @@ void glcommon_check_extensions(void) {
 	glcommon_ext_texture_half_float_linear();
 	glcommon_ext_texture_norm16();
 	glcommon_ext_texture_rg();
+	glcommon_ext_timer_query();
 	glcommon_ext_vertex_array_object();
 	glcommon_ext_viewport_array();
 
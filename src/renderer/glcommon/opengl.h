@@ -22,6 +22,26 @@
 	#define GL_NUM_SHADING_LANGUAGE_VERSIONS  0x82E9
 #endif
 
+// NOTE: ARB_buffer_storage (GL 4.4) is newer than what our glad loader is generated for.
+#ifndef GL_MAP_PERSISTENT_BIT
+	#define GL_MAP_PERSISTENT_BIT  0x0040
+#endif
+
+#ifndef GL_MAP_COHERENT_BIT
+	#define GL_MAP_COHERENT_BIT    0x0080
+#endif
+
+#ifndef GL_DYNAMIC_STORAGE_BIT
+	#define GL_DYNAMIC_STORAGE_BIT 0x0100
+#endif
+
+// NOTE: EXT_disjoint_timer_query (GLES) is not in our glad loader either.
+#ifndef GL_GPU_DISJOINT_EXT
+	#define GL_GPU_DISJOINT_EXT    0x8FBB
+#endif
+
+typedef void (APIENTRYP TSGL_PFNGLBUFFERSTORAGEPROC)(GLenum target, GLsizeiptr size, const void *data, GLbitfield flags);
+
 #define TSGL_EXT_VENDORS \
 	TSGL_EXT_VENDOR(AMD) \
 	TSGL_EXT_VENDOR(ANGLE) \
@@ -75,6 +95,7 @@ struct glext_s {
 	} version;
 
 	ext_flag_t base_instance;
+	ext_flag_t buffer_storage;
 	ext_flag_t clear_texture;
 	ext_flag_t color_buffer_float;
 	ext_flag_t debug_output;
@@ -88,6 +109,7 @@ struct glext_s {
 	ext_flag_t texture_half_float_linear;
 	ext_flag_t texture_norm16;
 	ext_flag_t texture_rg;
+	ext_flag_t timer_query;
 	ext_flag_t vertex_array_object;
 	ext_flag_t viewport_array;
 
@@ -133,6 +155,14 @@ struct glext_s {
 	#undef glDrawElementsInstancedBaseInstance
 	#define glDrawElementsInstancedBaseInstance (glext.DrawElementsInstancedBaseInstance)
 
+	//
+	// buffer_storage
+	//
+
+	TSGL_PFNGLBUFFERSTORAGEPROC BufferStorage;
+	#undef glBufferStorage
+	#define glBufferStorage (glext.BufferStorage)
+
 	//
 	// draw_buffers
 	//
@@ -155,6 +185,34 @@ struct glext_s {
 	#define glClearTexSubImage (glext.ClearTexSubImage)
 	*/
 
+	//
+	// timer_query
+	//
+
+	PFNGLGENQUERIESPROC GenQueries;
+	#undef glGenQueries
+	#define glGenQueries (glext.GenQueries)
+
+	PFNGLDELETEQUERIESPROC DeleteQueries;
+	#undef glDeleteQueries
+	#define glDeleteQueries (glext.DeleteQueries)
+
+	PFNGLBEGINQUERYPROC BeginQuery;
+	#undef glBeginQuery
+	#define glBeginQuery (glext.BeginQuery)
+
+	PFNGLENDQUERYPROC EndQuery;
+	#undef glEndQuery
+	#define glEndQuery (glext.EndQuery)
+
+	PFNGLGETQUERYOBJECTUIVPROC GetQueryObjectuiv;
+	#undef glGetQueryObjectuiv
+	#define glGetQueryObjectuiv (glext.GetQueryObjectuiv)
+
+	PFNGLGETQUERYOBJECTUI64VPROC GetQueryObjectui64v;
+	#undef glGetQueryObjectui64v
+	#define glGetQueryObjectui64v (glext.GetQueryObjectui64v)
+
 	//
 	// 	vertex_array_object
 	//
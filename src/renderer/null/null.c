@@ -56,6 +56,7 @@ static const char* null_shader_program_get_debug_label(ShaderProgram *prog) { re
 
 static void null_shader(ShaderProgram *prog) { }
 static ShaderProgram* null_shader_current(void) { return (void*)&placeholder; }
+static void null_stage_time(float seconds) { }
 
 static Uniform* null_shader_uniform(ShaderProgram *prog, const char *uniform_name) {
 	return NULL;
@@ -89,6 +90,9 @@ static void null_texture_set_filter(Texture *tex, TextureFilterMode fmin, Textur
 static void null_texture_set_wrap(Texture *tex, TextureWrapMode fmin, TextureWrapMode fmag) { }
 static void null_texture_fill(Texture *tex, uint mipmap, const Pixmap *image_data) { }
 static void null_texture_fill_region(Texture *tex, uint mipmap, uint x, uint y, const Pixmap *image_data) { }
+static void null_texture_fill_async(Texture *tex, uint mipmap, const Pixmap *image_data) { }
+static bool null_texture_is_resident(Texture *tex) { return true; }
+static void null_texture_upload_stats(TextureUploadStats *stats) { memset(stats, 0, sizeof(*stats)); }
 static void null_texture_invalidate(Texture *tex) { }
 static void null_texture_destroy(Texture *tex) { }
 static void null_texture_clear(Texture *tex, const Color *color) { }
@@ -160,6 +164,10 @@ static VsyncMode null_vsync_current(void) { return VSYNC_NONE; }
 
 static void null_swap(SDL_Window *window) { }
 
+static void null_gpu_timer_begin(const char *name) { }
+static void null_gpu_timer_end(void) { }
+static void null_gpu_timer_stats(GPUTimerStats *stats) { memset(stats, 0, sizeof(*stats)); }
+
 static bool null_screenshot(Pixmap *dest) { return false; }
 
 RendererBackend _r_backend_null = {
@@ -193,6 +201,7 @@ RendererBackend _r_backend_null = {
 		.shader_program_get_debug_label = null_shader_program_get_debug_label,
 		.shader = null_shader,
 		.shader_current = null_shader_current,
+		.stage_time = null_stage_time,
 		.shader_uniform = null_shader_uniform,
 		.uniform = null_uniform,
 		.uniform_type = null_uniform_type,
@@ -207,6 +216,9 @@ RendererBackend _r_backend_null = {
 		.texture_invalidate = null_texture_invalidate,
 		.texture_fill = null_texture_fill,
 		.texture_fill_region = null_texture_fill_region,
+		.texture_fill_async = null_texture_fill_async,
+		.texture_is_resident = null_texture_is_resident,
+		.texture_upload_stats = null_texture_upload_stats,
 		.texture_clear = null_texture_clear,
 		.framebuffer_create = null_framebuffer_create,
 		.framebuffer_get_debug_label = null_framebuffer_get_debug_label,
@@ -246,6 +258,9 @@ RendererBackend _r_backend_null = {
 		.vsync = null_vsync,
 		.vsync_current = null_vsync_current,
 		.swap = null_swap,
+		.gpu_timer_begin = null_gpu_timer_begin,
+		.gpu_timer_end = null_gpu_timer_end,
+		.gpu_timer_stats = null_gpu_timer_stats,
 		.screenshot = null_screenshot,
 	},
 };
@@ -16,6 +16,12 @@
 
 static uint8_t replay_magic_header[] = REPLAY_MAGIC_HEADER;
 
+// frame (4), type (1), value (2)
+#define REPLAY_EVENT_SIZE 7
+
+// Upper bound for the compressed size of an event block; anything larger means the file is corrupt.
+#define REPLAY_EVENT_BLOCK_MAX_SIZE (REPLAY_EVENT_BLOCK_SIZE * REPLAY_EVENT_SIZE * 2 + 64)
+
 void replay_init(Replay *rpy) {
 	memset(rpy, 0, sizeof(Replay));
 	log_debug("Replay at %p initialized for writing", (void*)rpy);
@@ -91,8 +97,12 @@ void replay_destroy_events(Replay *rpy) {
 			ReplayStage *stg = rpy->stages + i;
 			free(stg->events);
 			stg->events = NULL;
+			stg->stream = NULL;
 		}
 	}
+
+	replay_event_stream_close(rpy->event_stream);
+	rpy->event_stream = NULL;
 }
 
 void replay_destroy(Replay *rpy) {
@@ -108,6 +118,7 @@ void replay_destroy(Replay *rpy) {
 		free(rpy->stages);
 	}
 
+	replay_event_stream_close(rpy->event_stream);
 	free(rpy->playername);
 
 	memset(rpy, 0, sizeof(Replay));
@@ -134,6 +145,67 @@ void replay_stage_event(ReplayStage *stg, uint32_t frame, uint8_t type, uint16_t
 	}
 }
 
+void replay_stage_rewind(ReplayStage *stg) {
+	stg->playpos = 0;
+
+	if(stg->stream) {
+		replay_event_stream_seek(stg->stream, stg->stream_idx, 0);
+	}
+}
+
+void replay_stage_seek(ReplayStage *stg, uint32_t frame) {
+	if(stg->stream) {
+		replay_event_stream_seek(stg->stream, stg->stream_idx, frame);
+		return;
+	}
+
+	int lo = 0, hi = stg->numevents;
+
+	while(lo < hi) {
+		int mid = lo + (hi - lo) / 2;
+
+		if(stg->events[mid].frame < frame) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	stg->playpos = lo;
+}
+
+const ReplayEvent* replay_stage_peek_event(ReplayStage *stg) {
+	if(stg->stream) {
+		return replay_event_stream_peek(stg->stream, stg->stream_idx);
+	}
+
+	if(stg->playpos < stg->numevents) {
+		return stg->events + stg->playpos;
+	}
+
+	return NULL;
+}
+
+void replay_stage_next_event(ReplayStage *stg) {
+	++stg->playpos;
+
+	if(stg->stream) {
+		replay_event_stream_next(stg->stream);
+	}
+}
+
+uint32_t replay_stage_final_frame(ReplayStage *stg) {
+	if(stg->stream) {
+		return replay_event_stream_final_frame(stg->stream, stg->stream_idx);
+	}
+
+	if(stg->numevents) {
+		return stg->events[stg->numevents - 1].frame;
+	}
+
+	return 0;
+}
+
 static void replay_write_string(SDL_RWops *file, char *str, uint16_t version) {
 	if(version >= REPLAY_STRUCT_VERSION_TS102000_REV1) {
 		SDL_WriteU8(file, strlen(str));
@@ -144,19 +216,77 @@ static void replay_write_string(SDL_RWops *file, char *str, uint16_t version) {
 	SDL_RWwrite(file, str, 1, strlen(str));
 }
 
+static void replay_write_stage_events(ReplayStage *stg, int first, int num, SDL_RWops *file) {
+	for(int j = first; j < first + num; ++j) {
+		ReplayEvent *evt = stg->events + j;
+
+		SDL_WriteLE32(file, evt->frame);
+		SDL_WriteU8(file, evt->type);
+		SDL_WriteLE16(file, evt->value);
+	}
+}
+
 static bool replay_write_events(Replay *rpy, SDL_RWops *file) {
 	for(int i = 0; i < rpy->numstages; ++i) {
 		ReplayStage *stg = rpy->stages + i;
+		replay_write_stage_events(stg, 0, stg->numevents, file);
+	}
 
-		for(int j = 0; j < stg->numevents; ++j) {
-			ReplayEvent *evt = stg->events + j;
+	return true;
+}
+
+static inline int replay_stage_num_blocks(ReplayStage *stg) {
+	return (stg->numevents + REPLAY_EVENT_BLOCK_SIZE - 1) / REPLAY_EVENT_BLOCK_SIZE;
+}
+
+static bool replay_write_event_blocks(Replay *rpy, SDL_RWops *file) {
+	int num_blocks = 0;
+
+	for(int i = 0; i < rpy->numstages; ++i) {
+		num_blocks += replay_stage_num_blocks(rpy->stages + i);
+	}
+
+	uint32_t offsets[num_blocks];
+	int block = 0;
+
+	for(int i = 0; i < rpy->numstages; ++i) {
+		ReplayStage *stg = rpy->stages + i;
+
+		for(int j = 0; j < stg->numevents; j += REPLAY_EVENT_BLOCK_SIZE, ++block) {
+			int64_t ofs = SDL_RWtell(file);
+
+			if(ofs < 0) {
+				log_error("SDL_RWtell() failed: %s", SDL_GetError());
+				return false;
+			}
+
+			void *buf;
+			SDL_RWops *abuf = SDL_RWAutoBuffer(&buf, 64);
+			SDL_RWops *zfile = SDL_RWWrapZWriter(abuf, REPLAY_COMPRESSION_CHUNK_SIZE, false);
+			replay_write_stage_events(stg, j, umin(REPLAY_EVENT_BLOCK_SIZE, stg->numevents - j), zfile);
+			SDL_RWclose(zfile);
+
+			offsets[block] = ofs;
+			SDL_WriteLE32(file, SDL_RWtell(abuf));
+			SDL_RWwrite(file, buf, SDL_RWtell(abuf), 1);
+			SDL_RWclose(abuf);
+		}
+	}
 
-			SDL_WriteLE32(file, evt->frame);
-			SDL_WriteU8(file, evt->type);
-			SDL_WriteLE16(file, evt->value);
+	uint32_t index_offset = SDL_RWtell(file);
+	block = 0;
+
+	for(int i = 0; i < rpy->numstages; ++i) {
+		ReplayStage *stg = rpy->stages + i;
+		SDL_WriteLE32(file, stg->numevents ? stg->events[stg->numevents - 1].frame : 0);
+
+		for(int j = 0; j < stg->numevents; j += REPLAY_EVENT_BLOCK_SIZE, ++block) {
+			SDL_WriteLE32(file, offsets[block]);
+			SDL_WriteLE32(file, stg->events[j].frame);
 		}
 	}
 
+	SDL_WriteLE32(file, index_offset);
 	return true;
 }
 
@@ -289,18 +419,23 @@ bool replay_write(Replay *rpy, SDL_RWops *file, uint16_t version) {
 		}
 	}
 
+	bool events_ok;
+
 	if(compression) {
 		SDL_RWclose(vfile);
 		SDL_WriteLE32(file, SDL_RWtell(file) + SDL_RWtell(abuf) + 4);
 		SDL_RWwrite(file, buf, SDL_RWtell(abuf), 1);
 		SDL_RWclose(abuf);
-		vfile = SDL_RWWrapZWriter(file, REPLAY_COMPRESSION_CHUNK_SIZE, false);
-	}
-
-	bool events_ok = replay_write_events(rpy, vfile);
 
-	if(compression) {
-		SDL_RWclose(vfile);
+		if(base_version >= REPLAY_STRUCT_VERSION_TS103000_REV4) {
+			events_ok = replay_write_event_blocks(rpy, file);
+		} else {
+			vfile = SDL_RWWrapZWriter(file, REPLAY_COMPRESSION_CHUNK_SIZE, false);
+			events_ok = replay_write_events(rpy, vfile);
+			SDL_RWclose(vfile);
+		}
+	} else {
+		events_ok = replay_write_events(rpy, file);
 	}
 
 	if(!events_ok) {
@@ -369,6 +504,7 @@ static bool replay_read_header(Replay *rpy, SDL_RWops *file, int64_t filesize, s
 		case REPLAY_STRUCT_VERSION_TS103000_REV1:
 		case REPLAY_STRUCT_VERSION_TS103000_REV2:
 		case REPLAY_STRUCT_VERSION_TS103000_REV3:
+		case REPLAY_STRUCT_VERSION_TS103000_REV4:
 		{
 			if(taisei_version_read(file, &rpy->game_version) != TAISEI_VERSION_SIZE) {
 				log_error("%s: Failed to read game version", source);
@@ -494,6 +630,104 @@ static bool replay_read_meta(Replay *rpy, SDL_RWops *file, int64_t filesize, con
 	return true;
 }
 
+static bool replay_read_event(SDL_RWops *file, ReplayEvent *evt) {
+	uint8_t buf[REPLAY_EVENT_SIZE];
+
+	if(SDL_RWread(file, buf, sizeof(buf), 1) != 1) {
+		return false;
+	}
+
+	evt->frame = buf[0] | (buf[1] << 8) | (buf[2] << 16) | ((uint32_t)buf[3] << 24);
+	evt->type = buf[4];
+	evt->value = buf[5] | (buf[6] << 8);
+
+	return true;
+}
+
+static bool replay_read_u32(SDL_RWops *file, uint32_t *out) {
+	uint32_t val;
+
+	if(SDL_RWread(file, &val, sizeof(val), 1) != 1) {
+		return false;
+	}
+
+	*out = SDL_SwapLE32(val);
+	return true;
+}
+
+// Reads a compressed block of events (REPLAY_STRUCT_VERSION_TS103000_REV4 and above) into *buf,
+// and returns a stream that decompresses it.
+static SDL_RWops* replay_open_event_block(SDL_RWops *file, void **buf, size_t *bufsize, const char *source) {
+	uint32_t size;
+
+	if(!replay_read_u32(file, &size)) {
+		log_error("%s: Premature EOF", source);
+		return NULL;
+	}
+
+	if(size == 0 || size > REPLAY_EVENT_BLOCK_MAX_SIZE) {
+		log_error("%s: Invalid event block size %u", source, size);
+		return NULL;
+	}
+
+	if(*bufsize < size) {
+		*buf = realloc(*buf, size);
+		*bufsize = size;
+	}
+
+	if(SDL_RWread(file, *buf, size, 1) != 1) {
+		log_error("%s: Premature EOF", source);
+		return NULL;
+	}
+
+	return SDL_RWWrapZReader(SDL_RWFromConstMem(*buf, size), REPLAY_COMPRESSION_CHUNK_SIZE, true);
+}
+
+static bool replay_read_event_blocks(Replay *rpy, SDL_RWops *file, const char *source) {
+	void *buf = NULL;
+	size_t bufsize = 0;
+	bool ok = true;
+
+	for(int i = 0; i < rpy->numstages && ok; ++i) {
+		ReplayStage *stg = rpy->stages + i;
+
+		if(!stg->numevents) {
+			log_error("%s: No events in stage", source);
+			ok = false;
+			break;
+		}
+
+		stg->events = calloc(stg->numevents, sizeof(ReplayEvent));
+		SDL_RWops *block = NULL;
+
+		for(int j = 0; j < stg->numevents; ++j) {
+			if(j % REPLAY_EVENT_BLOCK_SIZE == 0) {
+				if(block) {
+					SDL_RWclose(block);
+				}
+
+				if(!(block = replay_open_event_block(file, &buf, &bufsize, source))) {
+					ok = false;
+					break;
+				}
+			}
+
+			if(!replay_read_event(block, stg->events + j)) {
+				log_error("%s: Event block is corrupt", source);
+				ok = false;
+				break;
+			}
+		}
+
+		if(block) {
+			SDL_RWclose(block);
+		}
+	}
+
+	free(buf);
+	return ok;
+}
+
 static bool replay_read_events(Replay *rpy, SDL_RWops *file, int64_t filesize, const char *source) {
 	for(int i = 0; i < rpy->numstages; ++i) {
 		ReplayStage *stg = rpy->stages + i;
@@ -602,8 +836,19 @@ bool replay_read(Replay *rpy, SDL_RWops *file, ReplayReadMode mode, const char *
 		}
 
 		bool compression = false;
+		uint16_t base_version = (rpy->version & ~REPLAY_VERSION_COMPRESSION_BIT);
 
 		if(rpy->version & REPLAY_VERSION_COMPRESSION_BIT) {
+			if(base_version >= REPLAY_STRUCT_VERSION_TS103000_REV4) {
+				// followed by the seek index, which we don't need here
+				if(!replay_read_event_blocks(rpy, file, source)) {
+					replay_destroy_events(rpy);
+					return false;
+				}
+
+				return true;
+			}
+
 			vfile = SDL_RWWrapZReader(file, REPLAY_COMPRESSION_CHUNK_SIZE, false);
 			filesize = -1;
 			compression = true;
@@ -632,6 +877,378 @@ bool replay_read(Replay *rpy, SDL_RWops *file, ReplayReadMode mode, const char *
 #undef CHECKPROP
 #undef PRINTPROP
 
+/*
+ *  Streaming event reader
+ */
+
+typedef struct ReplayEventStreamStage {
+	uint32_t numevents;
+	uint32_t final_frame;
+
+	// REPLAY_STRUCT_VERSION_TS103000_REV4 and above, compressed: the seek index
+	uint32_t *block_offsets;
+	uint32_t *block_frames;
+
+	// uncompressed: where the events of this stage begin
+	int64_t fileoffset;
+} ReplayEventStreamStage;
+
+struct ReplayEventStream {
+	SDL_RWops *file;
+	SDL_RWops *reader;
+	char *source;
+
+	ReplayEventStreamStage *stages;
+	uint16_t numstages;
+
+	uint32_t events_offset;
+	bool compressed;
+	bool indexed;
+	bool error;
+
+	void *blockbuf;
+	size_t blockbuf_size;
+
+	// position of the current event
+	uint16_t stage;
+	uint32_t event;
+	ReplayEvent current;
+	bool current_valid;
+};
+
+static void rstream_close_reader(ReplayEventStream *s) {
+	if(s->reader && s->reader != s->file) {
+		SDL_RWclose(s->reader);
+	}
+
+	s->reader = NULL;
+}
+
+static bool rstream_seek_file(ReplayEventStream *s, int64_t ofs) {
+	if(SDL_RWseek(s->file, ofs, RW_SEEK_SET) < 0) {
+		log_error("%s: SDL_RWseek() failed: %s", s->source, SDL_GetError());
+		s->error = true;
+		return false;
+	}
+
+	return true;
+}
+
+// Decodes the event at the current position.
+static bool rstream_fetch(ReplayEventStream *s) {
+	s->current_valid = false;
+
+	while(s->stage < s->numstages && s->event >= s->stages[s->stage].numevents) {
+		++s->stage;
+		s->event = 0;
+	}
+
+	if(s->stage >= s->numstages || s->error) {
+		return false;
+	}
+
+	if(s->indexed && s->event % REPLAY_EVENT_BLOCK_SIZE == 0) {
+		rstream_close_reader(s);
+
+		if(!rstream_seek_file(s, s->stages[s->stage].block_offsets[s->event / REPLAY_EVENT_BLOCK_SIZE])) {
+			return false;
+		}
+
+		if(!(s->reader = replay_open_event_block(s->file, &s->blockbuf, &s->blockbuf_size, s->source))) {
+			s->error = true;
+			return false;
+		}
+	}
+
+	assert(s->reader != NULL);
+
+	if(!replay_read_event(s->reader, &s->current)) {
+		log_error("%s: Premature EOF", s->source);
+		s->error = true;
+		return false;
+	}
+
+	s->current_valid = true;
+	return true;
+}
+
+// Starts decoding from the current position, which must be a point the format allows to restart from:
+// the start of a block if indexed, any event if uncompressed, or the very beginning otherwise.
+static bool rstream_restart(ReplayEventStream *s) {
+	rstream_close_reader(s);
+	s->current_valid = false;
+	s->error = false;
+
+	if(s->indexed) {
+		assert(s->event % REPLAY_EVENT_BLOCK_SIZE == 0);
+	} else if(!s->compressed) {
+		if(!rstream_seek_file(s, s->stages[s->stage].fileoffset + s->event * REPLAY_EVENT_SIZE)) {
+			return false;
+		}
+
+		s->reader = s->file;
+	} else {
+		assert(s->stage == 0 && s->event == 0);
+
+		if(!rstream_seek_file(s, s->events_offset)) {
+			return false;
+		}
+
+		s->reader = SDL_RWWrapZReader(s->file, REPLAY_COMPRESSION_CHUNK_SIZE, false);
+	}
+
+	return rstream_fetch(s);
+}
+
+static bool rstream_read_index(ReplayEventStream *s, int64_t filesize) {
+	// index offset, useless byte
+	int64_t index_end = filesize - 5;
+	uint32_t index_offset;
+
+	if(index_end <= s->events_offset || !rstream_seek_file(s, index_end) || !replay_read_u32(s->file, &index_offset)) {
+		log_error("%s: Seek index is missing", s->source);
+		return false;
+	}
+
+	if(index_offset <= s->events_offset || index_offset >= index_end || !rstream_seek_file(s, index_offset)) {
+		log_error("%s: Invalid seek index offset %u", s->source, index_offset);
+		return false;
+	}
+
+	for(int i = 0; i < s->numstages; ++i) {
+		ReplayEventStreamStage *stg = s->stages + i;
+		uint num_blocks = (stg->numevents + REPLAY_EVENT_BLOCK_SIZE - 1) / REPLAY_EVENT_BLOCK_SIZE;
+
+		stg->block_offsets = calloc(num_blocks, sizeof(*stg->block_offsets));
+		stg->block_frames = calloc(num_blocks, sizeof(*stg->block_frames));
+
+		if(!replay_read_u32(s->file, &stg->final_frame)) {
+			log_error("%s: Seek index is truncated", s->source);
+			return false;
+		}
+
+		for(uint j = 0; j < num_blocks; ++j) {
+			if(
+				!replay_read_u32(s->file, stg->block_offsets + j) ||
+				!replay_read_u32(s->file, stg->block_frames + j)
+			) {
+				log_error("%s: Seek index is truncated", s->source);
+				return false;
+			}
+
+			if(stg->block_offsets[j] < s->events_offset || stg->block_offsets[j] >= index_offset) {
+				log_error("%s: Seek index is corrupt", s->source);
+				return false;
+			}
+		}
+	}
+
+	if(SDL_RWtell(s->file) != index_end) {
+		log_error("%s: Seek index is corrupt", s->source);
+		return false;
+	}
+
+	return true;
+}
+
+// Without an index, we still need to know when each stage ends for playback.
+static bool rstream_scan(ReplayEventStream *s, int64_t filesize) {
+	if(!s->compressed) {
+		ReplayEventStreamStage *last = s->stages + s->numstages - 1;
+
+		if(last->fileoffset + last->numevents * REPLAY_EVENT_SIZE >= filesize) {
+			log_error("%s: Premature EOF", s->source);
+			return false;
+		}
+
+		for(int i = 0; i < s->numstages; ++i) {
+			ReplayEventStreamStage *stg = s->stages + i;
+			ReplayEvent evt;
+
+			if(
+				!rstream_seek_file(s, stg->fileoffset + (stg->numevents - 1) * REPLAY_EVENT_SIZE) ||
+				!replay_read_event(s->file, &evt)
+			) {
+				return false;
+			}
+
+			stg->final_frame = evt.frame;
+		}
+
+		return true;
+	}
+
+	// Have to decode everything once; memory use is still constant.
+	s->stage = s->event = 0;
+
+	for(rstream_restart(s); s->current_valid; replay_event_stream_next(s)) {
+		if(s->event == s->stages[s->stage].numevents - 1) {
+			s->stages[s->stage].final_frame = s->current.frame;
+		}
+	}
+
+	return !s->error;
+}
+
+ReplayEventStream* replay_event_stream_open(Replay *rpy, SDL_RWops *file, const char *source) {
+	if(!source) {
+		source = "<unknown>";
+	}
+
+	if(!rpy->fileoffset || !rpy->stages) {
+		log_fatal("%s: Tried to read events before reading metadata", source);
+	}
+
+	int64_t filesize = SDL_RWsize(file);
+
+	if(filesize < 0) {
+		log_error("%s: Can't stream events from a non-seekable file: %s", source, SDL_GetError());
+		return NULL;
+	}
+
+	ReplayEventStream *s = calloc(1, sizeof(*s));
+	s->file = file;
+	s->source = strdup(source);
+	s->numstages = rpy->numstages;
+	s->stages = calloc(s->numstages, sizeof(*s->stages));
+	s->events_offset = rpy->fileoffset;
+	s->compressed = rpy->version & REPLAY_VERSION_COMPRESSION_BIT;
+
+	int64_t ofs = rpy->fileoffset;
+
+	for(int i = 0; i < s->numstages; ++i) {
+		if(!rpy->stages[i].numevents) {
+			log_error("%s: No events in stage", source);
+			goto fail;
+		}
+
+		s->stages[i].numevents = rpy->stages[i].numevents;
+		s->stages[i].fileoffset = ofs;
+		ofs += rpy->stages[i].numevents * REPLAY_EVENT_SIZE;
+	}
+
+	uint16_t base_version = (rpy->version & ~REPLAY_VERSION_COMPRESSION_BIT);
+
+	if(s->compressed && base_version >= REPLAY_STRUCT_VERSION_TS103000_REV4) {
+		if(!rstream_read_index(s, filesize)) {
+			goto fail;
+		}
+
+		s->indexed = true;
+	} else if(!rstream_scan(s, filesize)) {
+		goto fail;
+	}
+
+	s->stage = s->event = 0;
+
+	if(!rstream_restart(s)) {
+		goto fail;
+	}
+
+	for(int i = 0; i < s->numstages; ++i) {
+		rpy->stages[i].stream = s;
+		rpy->stages[i].stream_idx = i;
+	}
+
+	rpy->event_stream = s;
+	log_debug("%s: Streaming events (%s)", source, s->indexed ? "indexed" : "no index");
+	return s;
+
+fail:
+	// the caller keeps ownership of the file on failure
+	rstream_close_reader(s);
+	s->file = NULL;
+	replay_event_stream_close(s);
+	return NULL;
+}
+
+void replay_event_stream_close(ReplayEventStream *s) {
+	if(!s) {
+		return;
+	}
+
+	rstream_close_reader(s);
+
+	if(s->file) {
+		SDL_RWclose(s->file);
+	}
+
+	for(int i = 0; i < s->numstages; ++i) {
+		free(s->stages[i].block_offsets);
+		free(s->stages[i].block_frames);
+	}
+
+	free(s->stages);
+	free(s->blockbuf);
+	free(s->source);
+	free(s);
+}
+
+bool replay_event_stream_seek(ReplayEventStream *s, uint16_t stage_idx, uint32_t frame) {
+	if(stage_idx >= s->numstages) {
+		log_error("%s: No stage #%u in the replay", s->source, stage_idx);
+		return false;
+	}
+
+	// whether we can get there by just reading forward
+	bool ahead = s->current_valid && (s->stage < stage_idx || (s->stage == stage_idx && s->current.frame <= frame));
+
+	if(s->indexed) {
+		ReplayEventStreamStage *stg = s->stages + stage_idx;
+		uint num_blocks = (stg->numevents + REPLAY_EVENT_BLOCK_SIZE - 1) / REPLAY_EVENT_BLOCK_SIZE;
+		uint block = 0;
+
+		while(block + 1 < num_blocks && stg->block_frames[block + 1] <= frame) {
+			++block;
+		}
+
+		if(!ahead || s->stage != stage_idx || s->event < block * REPLAY_EVENT_BLOCK_SIZE) {
+			s->stage = stage_idx;
+			s->event = block * REPLAY_EVENT_BLOCK_SIZE;
+			rstream_restart(s);
+		}
+	} else if(!s->compressed) {
+		if(!ahead || s->stage != stage_idx) {
+			s->stage = stage_idx;
+			s->event = 0;
+			rstream_restart(s);
+		}
+	} else if(!ahead) {
+		s->stage = s->event = 0;
+		rstream_restart(s);
+	}
+
+	while(s->current_valid && (s->stage < stage_idx || (s->stage == stage_idx && s->current.frame < frame))) {
+		replay_event_stream_next(s);
+	}
+
+	return !s->error;
+}
+
+const ReplayEvent* replay_event_stream_peek(ReplayEventStream *s, uint16_t stage_idx) {
+	if(s->current_valid && s->stage == stage_idx) {
+		return &s->current;
+	}
+
+	return NULL;
+}
+
+void replay_event_stream_next(ReplayEventStream *s) {
+	if(s->current_valid) {
+		++s->event;
+		rstream_fetch(s);
+	}
+}
+
+uint32_t replay_event_stream_final_frame(ReplayEventStream *s, uint16_t stage_idx) {
+	assert(stage_idx < s->numstages);
+	return s->stages[stage_idx].final_frame;
+}
+
+bool replay_event_stream_has_index(ReplayEventStream *s) {
+	return s->indexed;
+}
+
 static char* replay_getpath(const char *name, bool ext) {
 	return ext ?    strfmt("storage/replays/%s.%s", name, REPLAY_EXTENSION) :
 					strfmt("storage/replays/%s",    name);
@@ -657,9 +1274,39 @@ bool replay_save(Replay *rpy, const char *name) {
 	return result;
 }
 
+// Always closes the file, unless it's been handed over to an event stream.
+static bool replay_read_file(Replay *rpy, SDL_RWops *file, ReplayReadMode mode, const char *source) {
+	if((mode & REPLAY_READ_STREAM) && SDL_RWsize(file) < 0) {
+		log_debug("%s: File is not seekable, loading all events into memory", source);
+		mode &= ~REPLAY_READ_STREAM;
+	}
+
+	if(!(mode & REPLAY_READ_STREAM) || !(mode & REPLAY_READ_EVENTS)) {
+		bool result = replay_read(rpy, file, mode, source);
+		SDL_RWclose(file);
+		return result;
+	}
+
+	if((mode & REPLAY_READ_META) && !replay_read(rpy, file, REPLAY_READ_META, source)) {
+		SDL_RWclose(file);
+		return false;
+	}
+
+	replay_destroy_events(rpy);
+
+	if(replay_event_stream_open(rpy, file, source)) {
+		return true;
+	}
+
+	log_warn("%s: Can't stream events, loading all of them into memory", source);
+	bool result = replay_read(rpy, file, REPLAY_READ_EVENTS, source);
+	SDL_RWclose(file);
+	return result;
+}
+
 static const char* replay_mode_string(ReplayReadMode mode) {
 	if((mode & REPLAY_READ_ALL) == REPLAY_READ_ALL) {
-		return "full";
+		return (mode & REPLAY_READ_STREAM) ? "full, streamed" : "full";
 	}
 
 	if(mode & REPLAY_READ_META) {
@@ -667,7 +1314,7 @@ static const char* replay_mode_string(ReplayReadMode mode) {
 	}
 
 	if(mode & REPLAY_READ_EVENTS) {
-		return "events";
+		return (mode & REPLAY_READ_STREAM) ? "events, streamed" : "events";
 	}
 
 	log_fatal("Bad mode %i", mode);
@@ -678,7 +1325,7 @@ bool replay_load(Replay *rpy, const char *name, ReplayReadMode mode) {
 	char *sp = vfs_repr(p, true);
 	log_info("Loading %s (%s)", sp, replay_mode_string(mode));
 
-	SDL_RWops *file = vfs_open(p, VFS_MODE_READ);
+	SDL_RWops *file = vfs_open(p, VFS_MODE_READ | ((mode & REPLAY_READ_STREAM) ? VFS_MODE_SEEKABLE : 0));
 	free(p);
 
 	if(!file) {
@@ -687,14 +1334,13 @@ bool replay_load(Replay *rpy, const char *name, ReplayReadMode mode) {
 		return false;
 	}
 
-	bool result = replay_read(rpy, file, mode, sp);
+	bool result = replay_read_file(rpy, file, mode, sp);
 
 	if(!result) {
 		replay_destroy(rpy);
 	}
 
 	free(sp);
-	SDL_RWclose(file);
 	return result;
 }
 
@@ -716,13 +1362,12 @@ bool replay_load_syspath(Replay *rpy, const char *path, ReplayReadMode mode) {
 		return false;
 	}
 
-	bool result = replay_read(rpy, file, mode, path);
+	bool result = replay_read_file(rpy, file, mode, path);
 
 	if(!result) {
 		replay_destroy(rpy);
 	}
 
-	SDL_RWclose(file);
 	return result;
 }
 
@@ -745,12 +1390,22 @@ void replay_copy(Replay *dst, Replay *src, bool steal_events) {
 
 		if(steal_events) {
 			s->events = NULL;
-		} else {
+			s->stream = NULL;
+		} else if(s->events) {
 			d->capacity = s->numevents;
 			d->events = (ReplayEvent*)malloc(sizeof(ReplayEvent) * d->capacity);
 			memcpy(d->events, s->events, sizeof(ReplayEvent) * d->capacity);
+		} else {
+			// can't share a stream
+			d->stream = NULL;
 		}
 	}
+
+	if(steal_events) {
+		src->event_stream = NULL;
+	} else {
+		dst->event_stream = NULL;
+	}
 }
 
 void replay_stage_check_desync(ReplayStage *stg, int time, uint16_t check, ReplayMode mode) {
@@ -761,12 +1416,7 @@ void replay_stage_check_desync(ReplayStage *stg, int time, uint16_t check, Repla
 	if(mode == REPLAY_PLAY) {
 		if(stg->desync_check && stg->desync_check != check) {
 			log_warn("Frame %d: replay desync detected! 0x%04x != 0x%04x", time, stg->desync_check, check);
-			stg->desynced = true;
-
-			if(global.is_replay_verification) {
-				// log_fatal("Replay verification failed");
-				exit(1);
-			}
+			replay_stage_desync(stg, time);
 		} else if(global.is_replay_verification) {
 			log_info("Frame %d: 0x%04x OK", time, check);
 		} else {
@@ -781,6 +1431,18 @@ void replay_stage_check_desync(ReplayStage *stg, int time, uint16_t check, Repla
 #endif
 }
 
+void replay_stage_desync(ReplayStage *stg, int frame) {
+	if(!stg->desynced) {
+		stg->desynced = true;
+		stg->desync_frame = frame;
+	}
+
+	if(global.is_replay_verification) {
+		// Nothing useful can be learned past this point; the result is reported to whoever called replay_play.
+		global.gameover = GAMEOVER_ABORT;
+	}
+}
+
 int replay_find_stage_idx(Replay *rpy, uint8_t stageid) {
 	assert(rpy != NULL);
 	assert(rpy->stages != NULL);
@@ -798,6 +1460,7 @@ int replay_find_stage_idx(Replay *rpy, uint8_t stageid) {
 typedef struct ReplayContext {
 	CallChain cc;
 	int stage_idx;
+	ReplayPlaybackResult result;
 } ReplayContext;
 
 static void replay_do_cleanup(CallChainResult ccr);
@@ -821,6 +1484,8 @@ void replay_play(Replay *rpy, int firstidx, CallChain next) {
 	ReplayContext *ctx = calloc(1, sizeof(*ctx));
 	ctx->cc = next;
 	ctx->stage_idx = firstidx;
+	ctx->result.desync_stage = -1;
+	ctx->result.desync_frame = -1;
 
 	replay_do_play(CALLCHAIN_RESULT(ctx, NULL));
 }
@@ -852,6 +1517,15 @@ static void replay_do_play(CallChainResult ccr) {
 
 static void replay_do_post_play(CallChainResult ccr) {
 	ReplayContext *ctx = ccr.ctx;
+	ReplayStage *rstg = global.replay_stage;
+
+	++ctx->result.stages;
+	ctx->result.frames += global.frames;
+
+	if(rstg->desynced && ctx->result.desync_stage < 0) {
+		ctx->result.desync_stage = rstg - global.replay.stages;
+		ctx->result.desync_frame = rstg->desync_frame;
+	}
 
 	if(global.gameover == GAMEOVER_ABORT) {
 		replay_do_cleanup(ccr);
@@ -876,6 +1550,7 @@ static void replay_do_cleanup(CallChainResult ccr) {
 	free_resources(false);
 
 	CallChain cc = ctx->cc;
+	ReplayPlaybackResult result = ctx->result;
 	free(ctx);
-	run_call_chain(&cc, NULL);
+	run_call_chain(&cc, &result);
 }
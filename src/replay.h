@@ -52,13 +52,19 @@
 
 	// Taisei v1.3 revision 3: add final score at the end of each stage
 	#define REPLAY_STRUCT_VERSION_TS103000_REV3 12
+
+	// Taisei v1.3 revision 4: compressed events are split into independently decodable blocks, followed by a seek index
+	#define REPLAY_STRUCT_VERSION_TS103000_REV4 13
 /* END supported struct versions */
 
 #define REPLAY_VERSION_COMPRESSION_BIT 0x8000
 #define REPLAY_COMPRESSION_CHUNK_SIZE 4096
 
+// How many events of a stage go into one compressed block (REPLAY_STRUCT_VERSION_TS103000_REV4 and above)
+#define REPLAY_EVENT_BLOCK_SIZE 256
+
 // What struct version to use when saving recorded replays
-#define REPLAY_STRUCT_VERSION_WRITE (REPLAY_STRUCT_VERSION_TS103000_REV3 | REPLAY_VERSION_COMPRESSION_BIT)
+#define REPLAY_STRUCT_VERSION_WRITE (REPLAY_STRUCT_VERSION_TS103000_REV4 | REPLAY_VERSION_COMPRESSION_BIT)
 
 #define REPLAY_ALLOC_INITIAL 256
 
@@ -82,6 +88,8 @@ typedef struct ReplayEvent {
 	/* END stored fields */
 } ReplayEvent;
 
+typedef struct ReplayEventStream ReplayEventStream;
+
 typedef struct ReplayStage {
 	/* BEGIN stored fields */
 
@@ -139,6 +147,10 @@ typedef struct ReplayStage {
 	SystemTime init_time;
 	ReplayEvent *events;
 
+	// If not NULL, events are decoded from this stream on demand instead; see REPLAY_READ_STREAM
+	ReplayEventStream *stream;
+	uint16_t stream_idx;
+
 	// events allocated (may be higher than numevents)
 	int capacity;
 
@@ -146,6 +158,7 @@ typedef struct ReplayStage {
 	int playpos;
 	int fps;
 	uint16_t desync_check;
+	int desync_frame; // first desynced frame, valid if desynced is set
 	bool desynced;
 } ReplayStage;
 
@@ -197,12 +210,28 @@ typedef struct Replay {
 	// All input events are stored at the very end of the replay so that we can save some time and memory
 	// by only loading them when necessary without seeking around the file too much.
 	//
-	// ReplayStage input_events[];
+	// REPLAY_STRUCT_VERSION_TS103000_REV3 and below, or uncompressed:
+	//      ReplayEvent input_events[];
+	//
+	// REPLAY_STRUCT_VERSION_TS103000_REV4 and above, compressed:
+	//      Every stage's events are split into blocks of up to REPLAY_EVENT_BLOCK_SIZE, each compressed separately:
+	//          uint32_t compressed_size;
+	//          uint8_t compressed_events[compressed_size];
+	//
+	//      They are followed by the seek index. For every stage:
+	//          uint32_t final_frame; // frame of the last event
+	//          struct { uint32_t fileoffset; uint32_t first_frame; } blocks[ceil(numevents / REPLAY_EVENT_BLOCK_SIZE)];
+	//
+	//      And finally, the offset of the index:
+	//          uint32_t index_offset;
 
 	// at least one trailing byte, value doesn't matter
 	// uint8_t useless;
 
 	/* END stored fields */
+
+	// Owns the ReplayStage.stream pointers
+	ReplayEventStream *event_stream;
 } Replay;
 
 typedef enum {
@@ -215,6 +244,10 @@ typedef enum ReplayReadMode {
 	REPLAY_READ_META = 1,
 	REPLAY_READ_EVENTS = 2,
 	REPLAY_READ_ALL = 3, // includes the other two
+
+	// With REPLAY_READ_EVENTS: don't load the events into memory, decode them during playback instead.
+	// Keeps the file open until the events are destroyed. Falls back to a normal load if the file is not seekable.
+	REPLAY_READ_STREAM = 4,
 } ReplayReadMode;
 
 typedef enum ReplayGlobalFlags {
@@ -239,8 +272,17 @@ void replay_destroy_events(Replay *rpy);
 
 void replay_stage_event(ReplayStage *stg, uint32_t frame, uint8_t type, uint16_t value);
 void replay_stage_check_desync(ReplayStage *stg, int time, uint16_t check, ReplayMode mode);
+// Marks the stage as desynced. When verifying replays, the playback is aborted.
+void replay_stage_desync(ReplayStage *stg, int frame) attr_nonnull(1);
 void replay_stage_sync_player_state(ReplayStage *stg, Player *plr);
 
+// Playback; these work with both in-memory and streamed events
+void replay_stage_rewind(ReplayStage *stg);
+void replay_stage_seek(ReplayStage *stg, uint32_t frame); // to the first event at or after frame
+const ReplayEvent* replay_stage_peek_event(ReplayStage *stg);
+void replay_stage_next_event(ReplayStage *stg);
+uint32_t replay_stage_final_frame(ReplayStage *stg);
+
 bool replay_write(Replay *rpy, SDL_RWops *file, uint16_t version);
 bool replay_read(Replay *rpy, SDL_RWops *file, ReplayReadMode mode, const char *source);
 
@@ -250,6 +292,28 @@ bool replay_load_syspath(Replay *rpy, const char *path, ReplayReadMode mode);
 
 void replay_copy(Replay *dst, Replay *src, bool steal_events);
 
+// Streaming event reader. Takes ownership of the file, which must be seekable; the metadata must be loaded already.
+// Memory use doesn't depend on the length of the replay.
+ReplayEventStream* replay_event_stream_open(Replay *rpy, SDL_RWops *file, const char *source);
+void replay_event_stream_close(ReplayEventStream *stream);
+// Positions the stream at the first event of the stage at or after the given frame.
+// Uses the seek index if the file has one; otherwise has to decode everything from the start of the stage (or the file).
+bool replay_event_stream_seek(ReplayEventStream *stream, uint16_t stage_idx, uint32_t frame);
+// NULL when there are no more events in the stage.
+const ReplayEvent* replay_event_stream_peek(ReplayEventStream *stream, uint16_t stage_idx);
+void replay_event_stream_next(ReplayEventStream *stream);
+uint32_t replay_event_stream_final_frame(ReplayEventStream *stream, uint16_t stage_idx);
+bool replay_event_stream_has_index(ReplayEventStream *stream);
+
+typedef struct ReplayPlaybackResult {
+	int stages;        // stages played, including restarts
+	int frames;        // logic frames simulated
+	int desync_stage;  // index of the first desynced stage, or -1
+	int desync_frame;  // first desynced frame in that stage, or -1
+} ReplayPlaybackResult;
+
+// next receives a pointer to a ReplayPlaybackResult, valid only for the duration of the call,
+// or NULL if there was nothing to play.
 void replay_play(Replay *rpy, int firstidx, CallChain next);
 
 int replay_find_stage_idx(Replay *rpy, uint8_t stageid);
@@ -0,0 +1,426 @@
+/*
+ * This software is licensed under the terms of the MIT-License
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2019, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2019, Andrei Alexeyev <akari@alienslab.net>.
+ */
+
+#include "taisei.h"
+
+#include "replay_verify.h"
+#include "global.h"
+#include "replay.h"
+#include "vfs/public.h"
+#include "vfs/syspath_public.h"
+
+#ifdef TAISEI_BUILDCONF_HAVE_POSIX
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#endif
+
+#define VERIFY_MOUNTPOINT "verify-replays"
+
+static struct {
+	char *dir;
+
+	// Where the results go: either straight to the output, or through a pipe to the parent process.
+	// Each record is written with a single write() call, so that lines from different workers don't
+	// get mixed up; see PIPE_BUF. See spawn_workers for the format.
+	SDL_RWops *output;
+	int result_fd;
+
+	// Index of the next file to verify. Shared between the worker processes.
+	SDL_atomic_t *next;
+	SDL_atomic_t next_local;
+
+	char **files;
+	size_t num_files;
+	char *current_path;
+	hrtime_t start_time;
+
+	uint num_verified;
+	uint num_failed;
+
+	CallChain cc;
+} rv;
+
+static void verify_next(void);
+
+static SDL_RWops *open_output(const char *path) {
+	if(!path) {
+		return SDL_RWFromFP(stdout, false);
+	}
+
+	SDL_RWops *rw = SDL_RWFromFile(path, "w");
+
+	if(!rw) {
+		log_fatal("SDL_RWFromFile() failed: %s", SDL_GetError());
+	}
+
+	return rw;
+}
+
+static char *format_result(const char *escaped_path, const char *status, int stages, int frames, double wall_time, const char *desync_stage, const char *desync_frame) {
+	return strfmt(
+		"{\"replay\":\"%s\",\"status\":\"%s\",\"stages\":%i,\"frames\":%i,\"wall_time\":%.3f,\"desync_stage\":%s,\"desync_frame\":%s}\n",
+		escaped_path, status, stages, frames, wall_time, desync_stage, desync_frame
+	);
+}
+
+#ifdef TAISEI_BUILDCONF_HAVE_POSIX
+
+/*
+ * Workers send two kinds of records through the pipe, one line each:
+ *
+ *   +<pid> <escaped path>    about to start on a replay
+ *   =<pid> <result line>     done with it
+ *
+ * A worker that dies in between (e.g. crashes) leaves a replay that was started but never
+ * finished; the parent reports those with the status "crash".
+ */
+
+typedef struct Worker {
+	pid_t pid;
+	char *current;  // JSON-escaped path of the replay in progress, if any
+	hrtime_t start_time;
+} Worker;
+
+static Worker *find_worker(Worker *workers, uint num_workers, pid_t pid) {
+	for(uint i = 0; i < num_workers; ++i) {
+		if(workers[i].pid == pid) {
+			return workers + i;
+		}
+	}
+
+	return NULL;
+}
+
+static void handle_record(char *rec, Worker *workers, uint num_workers) {
+	char kind = *rec;
+	char *end;
+	long pid = strtol(rec + 1, &end, 10);
+	Worker *w = (kind == '+' || kind == '=') && *end == ' ' ? find_worker(workers, num_workers, pid) : NULL;
+
+	if(!w) {
+		log_error("Bad record from a worker: %s", rec);
+		return;
+	}
+
+	free(w->current);
+	w->current = NULL;
+
+	if(kind == '+') {
+		w->current = strdup(end + 1);
+		w->start_time = time_get();
+	} else {
+		SDL_RWwrite(rv.output, end + 1, 1, strlen(end + 1));
+		SDL_RWwrite(rv.output, "\n", 1, 1);
+	}
+}
+
+static void collect_results(int fd, Worker *workers, uint num_workers) {
+	char buf[4096];
+	size_t buflen = 0;
+	ssize_t len;
+
+	// Records may arrive split across reads, so split them up into lines here.
+	while((len = read(fd, buf + buflen, sizeof(buf) - buflen)) != 0) {
+		if(len < 0) {
+			if(errno == EINTR) {
+				continue;
+			}
+
+			log_error("read() failed: %s", strerror(errno));
+			break;
+		}
+
+		buflen += len;
+		char *line = buf, *nl;
+
+		while((nl = memchr(line, '\n', buflen - (line - buf)))) {
+			*nl = 0;
+			handle_record(line, workers, num_workers);
+			line = nl + 1;
+		}
+
+		buflen -= line - buf;
+		memmove(buf, line, buflen);
+
+		if(buflen == sizeof(buf)) {
+			log_error("Record from a worker is too long; discarding it");
+			buflen = 0;
+		}
+	}
+}
+
+static void send_record(char kind, const char *payload) {
+	char *rec = strfmt("%c%i %s", kind, (int)getpid(), payload);
+	size_t len = strlen(rec);
+
+	if(write(rv.result_fd, rec, len) != (ssize_t)len) {
+		log_error("Failed to send a record for %s: %s", rv.current_path, strerror(errno));
+	}
+
+	free(rec);
+}
+
+// Returns true in the workers (or if none could be started), false in the parent once they're all done.
+static bool spawn_workers(uint jobs, int *exit_status) {
+	SDL_atomic_t *next = mmap(NULL, sizeof(*next), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+
+	if(next == MAP_FAILED) {
+		log_error("mmap() failed: %s", strerror(errno));
+		return true;
+	}
+
+	int pipefd[2];
+
+	if(pipe(pipefd)) {
+		log_error("pipe() failed: %s", strerror(errno));
+		munmap(next, sizeof(*next));
+		return true;
+	}
+
+	SDL_AtomicSet(next, 0);
+
+	// don't let the workers inherit anything that's still buffered
+	fflush(NULL);
+
+	Worker workers[jobs];
+	uint num_workers = 0;
+
+	for(uint i = 0; i < jobs; ++i) {
+		pid_t pid = fork();
+
+		if(pid == 0) {
+			close(pipefd[0]);
+			SDL_RWclose(rv.output);
+			rv.output = NULL;
+			rv.result_fd = pipefd[1];
+			rv.next = next;
+			return true;
+		}
+
+		if(pid < 0) {
+			log_error("fork() failed: %s", strerror(errno));
+			break;
+		}
+
+		workers[num_workers++] = (Worker) { .pid = pid };
+	}
+
+	close(pipefd[1]);
+
+	if(num_workers == 0) {
+		close(pipefd[0]);
+		munmap(next, sizeof(*next));
+		return true;
+	}
+
+	log_info("Verifying replays in %s with %u worker processes", rv.dir, num_workers);
+	collect_results(pipefd[0], workers, num_workers);
+	close(pipefd[0]);
+
+	int status = 0;
+
+	for(uint i = 0; i < num_workers; ++i) {
+		Worker *w = workers + i;
+		int wstatus;
+
+		while(waitpid(w->pid, &wstatus, 0) < 0) {
+			if(errno != EINTR) {
+				log_fatal("waitpid() failed: %s", strerror(errno));
+			}
+		}
+
+		if(WIFSIGNALED(wstatus)) {
+			log_error("Worker %i was killed by signal %i", (int)w->pid, WTERMSIG(wstatus));
+			status = 1;
+		} else if(!WIFEXITED(wstatus) || WEXITSTATUS(wstatus) != 0) {
+			status = 1;
+		}
+
+		if(w->current) {
+			log_error("Worker %i died while playing %s", (int)w->pid, w->current);
+			double wall_time = (time_get() - w->start_time) / (double)HRTIME_RESOLUTION;
+			char *line = format_result(w->current, "crash", 0, 0, wall_time, "null", "null");
+			SDL_RWwrite(rv.output, line, 1, strlen(line));
+			free(line);
+			free(w->current);
+			status = 1;
+		}
+	}
+
+	munmap(next, sizeof(*next));
+	*exit_status = status;
+	return false;
+}
+
+#endif
+
+bool replay_verify_setup(const char *dir, int jobs, const char *output, int *exit_status) {
+	memset(&rv, 0, sizeof(rv));
+	rv.dir = strdup(dir);
+	rv.output = open_output(output);
+	rv.result_fd = -1;
+	rv.next = &rv.next_local;
+
+	if(jobs < 1) {
+		jobs = SDL_GetCPUCount();
+	}
+
+#ifdef TAISEI_BUILDCONF_HAVE_POSIX
+	if(jobs > 1 && !spawn_workers(jobs, exit_status)) {
+		SDL_RWclose(rv.output);
+		free(rv.dir);
+		memset(&rv, 0, sizeof(rv));
+		return false;
+	}
+#else
+	if(jobs > 1) {
+		log_warn("Parallel verification is not supported on this platform; using only one process");
+	}
+#endif
+
+	return true;
+}
+
+static bool is_replay_file(const char *name) {
+	return strendswith(name, "." REPLAY_EXTENSION);
+}
+
+static void report(const ReplayPlaybackResult *res) {
+	const char *status;
+
+	if(!res || !res->stages) {
+		status = "error";
+	} else if(res->desync_stage >= 0) {
+		status = "desync";
+	} else {
+		status = "ok";
+	}
+
+	char desync_stage[16] = "null", desync_frame[16] = "null";
+
+	if(res && res->desync_stage >= 0) {
+		snprintf(desync_stage, sizeof(desync_stage), "%i", res->desync_stage);
+		snprintf(desync_frame, sizeof(desync_frame), "%i", res->desync_frame);
+	}
+
+	char *path = json_escape(rv.current_path);
+	char *line = format_result(
+		path, status,
+		res ? res->stages : 0,
+		res ? res->frames : 0,
+		(time_get() - rv.start_time) / (double)HRTIME_RESOLUTION,
+		desync_stage, desync_frame
+	);
+	free(path);
+
+	if(rv.output) {
+		SDL_RWwrite(rv.output, line, 1, strlen(line));
+	}
+#ifdef TAISEI_BUILDCONF_HAVE_POSIX
+	else {
+		send_record('=', line);
+	}
+#endif
+
+	free(line);
+
+	++rv.num_verified;
+
+	if(strcmp(status, "ok")) {
+		log_warn("%s: %s", rv.current_path, status);
+		++rv.num_failed;
+	}
+
+	free(rv.current_path);
+	rv.current_path = NULL;
+}
+
+static void finish(void) {
+	log_info("%u replays verified, %u failed", rv.num_verified, rv.num_failed);
+
+	int status = (rv.num_failed || !rv.files) ? 1 : 0;
+	CallChain cc = rv.cc;
+
+	vfs_dir_list_free(rv.files, rv.num_files);
+
+	if(rv.output) {
+		SDL_RWclose(rv.output);
+	}
+#ifdef TAISEI_BUILDCONF_HAVE_POSIX
+	else {
+		close(rv.result_fd);
+	}
+#endif
+
+	free(rv.dir);
+	memset(&rv, 0, sizeof(rv));
+
+	run_call_chain(&cc, &status);
+}
+
+static void verify_done(CallChainResult ccr) {
+	report(ccr.result);
+	verify_next();
+}
+
+static void verify_next(void) {
+	for(;;) {
+		size_t idx = SDL_AtomicAdd(rv.next, 1);
+
+		if(idx >= rv.num_files) {
+			finish();
+			return;
+		}
+
+		rv.current_path = strfmt("%s%c%s", rv.dir, vfs_get_syspath_separator(), rv.files[idx]);
+		rv.start_time = time_get();
+
+#ifdef TAISEI_BUILDCONF_HAVE_POSIX
+		if(!rv.output) {
+			char *path = json_escape(rv.current_path);
+			char *rec = strfmt("%s\n", path);
+			send_record('+', rec);
+			free(rec);
+			free(path);
+		}
+#endif
+
+		// replay_play takes it from here, and destroys it when done
+		if(replay_load_syspath(&global.replay, rv.current_path, REPLAY_READ_ALL | REPLAY_READ_STREAM)) {
+			replay_play(&global.replay, 0, CALLCHAIN(verify_done, NULL));
+			return;
+		}
+
+		report(NULL);
+	}
+}
+
+void replay_verify_run(CallChain next) {
+	rv.cc = next;
+
+	if(!vfs_mount_syspath(VERIFY_MOUNTPOINT, rv.dir, VFS_SYSPATH_MOUNT_READONLY)) {
+		log_error("Failed to mount '%s': %s", rv.dir, vfs_get_error());
+	} else {
+		if(vfs_query(VERIFY_MOUNTPOINT).is_dir) {
+			rv.files = vfs_dir_list_sorted(VERIFY_MOUNTPOINT, &rv.num_files, vfs_dir_list_order_ascending, is_replay_file);
+		} else {
+			log_error("'%s' is not a directory", rv.dir);
+		}
+
+		vfs_unmount(VERIFY_MOUNTPOINT);
+	}
+
+	if(rv.files && !rv.num_files) {
+		log_warn("No replays found in '%s'", rv.dir);
+	}
+
+	// Every worker lists the directory on its own, so it must not change while they're running.
+	verify_next();
+}
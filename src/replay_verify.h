@@ -0,0 +1,44 @@
+/*
+ * This software is licensed under the terms of the MIT-License
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2019, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2019, Andrei Alexeyev <akari@alienslab.net>.
+ */
+
+#ifndef IGUARD_replay_verify_h
+#define IGUARD_replay_verify_h
+
+#include "taisei.h"
+
+#include "eventloop/eventloop.h"
+
+/*
+ * Batch replay verification (--verify-replays DIR).
+ *
+ * Every *.tsr file in the directory is played back in headless mode, and one line of JSON
+ * is written to the output for each of them, e.g.:
+ *
+ *   {"replay":"dir/foo.tsr","status":"desync","stages":2,"frames":18351,"wall_time":3.217,"desync_stage":1,"desync_frame":6300}
+ *
+ * status is one of "ok", "desync", "error" (the file couldn't be loaded or played) or "crash"
+ * (the worker process playing it died; stages and frames are 0 then). The desync fields are
+ * null unless the status is "desync". Lines come in order of completion, not in order of the
+ * file names.
+ *
+ * The game keeps a lot of its state in globals, so replays can't be simulated side by side
+ * within one process. Instead, on POSIX systems, a number of worker processes are forked
+ * before anything is initialized. Each of them initializes the game once and then takes
+ * replays from a shared queue until it's empty. The results are sent back to the parent
+ * process, which is the only one writing to the output.
+ */
+
+// Called right after the command line is parsed, before any other initialization.
+// Returns true in the process(es) that should initialize the game and call replay_verify_run.
+// Otherwise, the work has been done by the child processes, and *exit_status is set.
+bool replay_verify_setup(const char *dir, int jobs, const char *output, int *exit_status) attr_nonnull(1, 4);
+
+// Verifies replays until there are none left, then calls next with a pointer to the exit status (int).
+void replay_verify_run(CallChain next);
+
+#endif // IGUARD_replay_verify_h
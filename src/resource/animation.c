@@ -209,6 +209,13 @@ void* load_animation_begin(const char *filename, uint flags) {
 		return NULL;
 	}
 
+	char buf[strlen(basename) + sizeof(".frame0000")];
+
+	for(int i = 0; i < ani->sprite_count; ++i) {
+		snprintf(buf, sizeof(buf), "%s.frame%04d", basename, i);
+		preload_resource(RES_SPRITE, buf, flags);
+	}
+
 	AnimationLoadData *data = malloc(sizeof(AnimationLoadData));
 	data->ani = ani;
 	data->basename = basename;
@@ -29,6 +29,7 @@ static bool check_font_path(const char*);
 static void* load_font_begin(const char*, uint);
 static void* load_font_end(void*, const char*, uint);
 static void unload_font(void*);
+static void* font_stub(const char*);
 
 ResourceHandler font_res_handler = {
 	.type = RES_FONT,
@@ -44,6 +45,7 @@ ResourceHandler font_res_handler = {
 		.begin_load = load_font_begin,
 		.end_load = load_font_end,
 		.unload = unload_font,
+		.stub = font_stub,
 	},
 };
 
@@ -255,24 +257,49 @@ static FT_Error FT_Done_Face_Thread_Safe(FT_Face face) {
 	return err;
 }
 
+static void ftstream_close_mapped(FT_Stream stream) {
+	vfs_unmap(stream->descriptor.pointer);
+	free(stream->descriptor.pointer);
+}
+
+static FT_Stream open_ftstream(char *vfspath, char *syspath) {
+	FT_Stream ftstream = calloc(1, sizeof(*ftstream));
+	VFSMapping mapping;
+
+	if(vfs_map(vfspath, &mapping)) {
+		// FreeType reads memory-based streams directly, without going through the read callback
+		ftstream->descriptor.pointer = memdup(&mapping, sizeof(mapping));
+		ftstream->base = (uchar*)mapping.data;
+		ftstream->size = mapping.size;
+		ftstream->close = ftstream_close_mapped;
+	} else {
+		SDL_RWops *rwops = vfs_open(vfspath, VFS_MODE_READ | VFS_MODE_SEEKABLE);
+
+		if(!rwops) {
+			log_error("VFS error: %s", vfs_get_error());
+			free(ftstream);
+			return NULL;
+		}
+
+		ftstream->descriptor.pointer = rwops;
+		ftstream->read = ftstream_read;
+		ftstream->close = ftstream_close;
+		ftstream->size = SDL_RWsize(rwops);
+	}
+
+	ftstream->pathname.pointer = syspath;
+	return ftstream;
+}
+
 static FT_Face load_font_face(char *vfspath, long index) {
 	char *syspath = vfs_repr(vfspath, true);
+	FT_Stream ftstream = open_ftstream(vfspath, syspath);
 
-	SDL_RWops *rwops = vfs_open(vfspath, VFS_MODE_READ | VFS_MODE_SEEKABLE);
-
-	if(!rwops) {
-		log_error("VFS error: %s", vfs_get_error());
+	if(!ftstream) {
 		free(syspath);
 		return NULL;
 	}
 
-	FT_Stream ftstream = calloc(1, sizeof(*ftstream));
-	ftstream->descriptor.pointer = rwops;
-	ftstream->pathname.pointer = syspath;
-	ftstream->read = ftstream_read;
-	ftstream->close = ftstream_close;
-	ftstream->size = SDL_RWsize(rwops);
-
 	FT_Open_Args ftargs;
 	memset(&ftargs, 0, sizeof(ftargs));
 	ftargs.flags = FT_OPEN_STREAM;
@@ -618,6 +645,10 @@ static Glyph* load_glyph(Font *font, FT_UInt gindex, SpriteSheetAnchor *spritesh
 static Glyph* get_glyph(Font *fnt, charcode_t cp) {
 	int64_t ofs;
 
+	if(!fnt->face) {
+		return NULL;
+	}
+
 	if(!ht_lookup(&fnt->charcodes_to_glyph_ofs, cp, &ofs)) {
 		Glyph *glyph;
 		uint ft_index = FT_Get_Char_Index(fnt->face, cp);
@@ -725,13 +756,29 @@ void unload_font(void *vfont) {
 	free(vfont);
 }
 
+void* font_stub(const char *name) {
+	// Has no face and no glyphs, so every string measures zero pixels wide. The metrics
+	// are nominal but finite, so that text layout code still gets sane heights.
+	Font *font = calloc(1, sizeof(*font));
+	ht_create(&font->charcodes_to_glyph_ofs);
+	ht_create(&font->ftindex_to_glyph_ofs);
+	font->metrics.scale = 1;
+	font->metrics.ascent = font->metrics.max_glyph_height = font->metrics.lineskip = 20;
+
+#ifdef DEBUG
+	strlcpy(font->debug_label, name, sizeof(font->debug_label));
+#endif
+
+	return font;
+}
+
 struct rlfonts_arg {
 	double quality;
 };
 
 attr_nonnull(1)
 static void reload_font(Font *font, double quality) {
-	if(font->metrics.scale != quality) {
+	if(font->face && font->metrics.scale != quality) {
 		wipe_glyph_cache(font);
 		set_font_size(font, font->base_size, quality);
 	}
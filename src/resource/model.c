@@ -16,6 +16,8 @@
 // TODO: Rewrite all of this mess, maybe even consider a different format
 // IQM for instance: http://sauerbraten.org/iqm/
 
+static void* model_stub(const char *name);
+
 ResourceHandler model_res_handler = {
 	.type = RES_MODEL,
 	.typename = "model",
@@ -27,6 +29,7 @@ ResourceHandler model_res_handler = {
 		.begin_load = load_model_begin,
 		.end_load = load_model_end,
 		.unload = unload_model,
+		.stub = model_stub,
 	},
 };
 
@@ -138,6 +141,11 @@ void unload_model(void *model) { // Does not delete elements from the VBO, so do
 	free(model);
 }
 
+static void* model_stub(const char *name) {
+	// An empty model; nothing will be drawn with it anyway.
+	return calloc(1, sizeof(Model));
+}
+
 static void free_obj(ObjFileData *data) {
 	free(data->xs);
 	free(data->normals);
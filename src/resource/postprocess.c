@@ -13,6 +13,7 @@
 #include "postprocess.h"
 #include "resource.h"
 #include "renderer/api.h"
+#include "profiler.h"
 
 ResourceHandler postprocess_res_handler = {
 	.type = RES_POSTPROCESS,
@@ -189,6 +190,7 @@ void postprocess(PostprocessShader *ppshaders, FBPair *fbos, PostprocessPrepareF
 		return;
 	}
 
+	PROFILE_ZONE("postprocess");
 	ShaderProgram *shader_saved = r_shader_current();
 	BlendMode blend_saved = r_blend_current();
 
@@ -197,6 +199,7 @@ void postprocess(PostprocessShader *ppshaders, FBPair *fbos, PostprocessPrepareF
 	for(PostprocessShader *pps = ppshaders; pps; pps = pps->next) {
 		ShaderProgram *s = pps->shader;
 
+		r_gpu_timer_begin(r_shader_program_get_debug_label(s));
 		r_framebuffer(fbos->back);
 		r_shader_ptr(s);
 
@@ -210,6 +213,7 @@ void postprocess(PostprocessShader *ppshaders, FBPair *fbos, PostprocessPrepareF
 
 		draw(fbos->front, width, height);
 		fbpair_swap(fbos);
+		r_gpu_timer_end();
 	}
 
 	r_shader_ptr(shader_saved);
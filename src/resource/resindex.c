@@ -0,0 +1,263 @@
+/*
+ * This software is licensed under the terms of the MIT-License
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2019, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2019, Andrei Alexeyev <akari@alienslab.net>.
+ */
+
+#include "taisei.h"
+
+#include "resindex.h"
+#include "util.h"
+#include "hashtable.h"
+
+// See scripts/taiseilib/resindex.py for the format.
+#define RESINDEX_DIR "res/resindex"
+#define RESINDEX_MAGIC "TRIX"
+#define RESINDEX_VERSION 2
+
+// The union of the loose resource directories; see vfs/setup_generic.c
+#define RESINDEX_OVERRIDES_DIR "resdirs"
+
+static struct {
+	char **entries;  // full vfs paths, e.g. "res/gfx/foo.png"
+	uint num_entries;
+	uint capacity;
+	ht_str2ptr_t lookup;
+
+	// Resources may be loaded from worker threads, hence atomic.
+	struct {
+		SDL_atomic_t indexed;   // answered from the index
+		SDL_atomic_t probed;    // passed on to the VFS
+	} lookups;
+
+	// top-level directories of res/ that have loose files in them
+	char **overrides;
+	uint num_overrides;
+
+	bool loaded;
+} resindex;
+
+static void add_entry(const char *relpath) {
+	char *path = strjoin("res/", relpath, NULL);
+
+	// The same file may be in several packages; it only needs to be listed once.
+	if(ht_get(&resindex.lookup, path, NULL)) {
+		free(path);
+		return;
+	}
+
+	if(resindex.num_entries == resindex.capacity) {
+		resindex.capacity = resindex.capacity ? resindex.capacity * 2 : 1024;
+		resindex.entries = realloc(resindex.entries, resindex.capacity * sizeof(*resindex.entries));
+	}
+
+	resindex.entries[resindex.num_entries++] = path;
+	ht_set(&resindex.lookup, path, path);
+}
+
+static bool load_index(const char *path) {
+	SDL_RWops *rw = vfs_open(path, VFS_MODE_READ);
+
+	if(!rw) {
+		log_error("VFS error: %s", vfs_get_error());
+		return false;
+	}
+
+	bool ok = false;
+	char magic[sizeof(RESINDEX_MAGIC) - 1];
+
+	if(SDL_RWread(rw, magic, sizeof(magic), 1) != 1 || memcmp(magic, RESINDEX_MAGIC, sizeof(magic))) {
+		log_error("%s: not a resource index", path);
+		goto done;
+	}
+
+	uint32_t version = SDL_ReadLE32(rw);
+
+	if(version != RESINDEX_VERSION) {
+		log_error("%s: unsupported version %u", path, version);
+		goto done;
+	}
+
+	uint32_t num_entries = SDL_ReadLE32(rw);
+
+	for(uint32_t i = 0; i < num_entries; ++i) {
+		uint16_t len = SDL_ReadLE16(rw);
+		char relpath[len + 1];
+
+		if(len == 0 || SDL_RWread(rw, relpath, len, 1) != 1) {
+			log_error("%s: unexpected end of file", path);
+			goto done;
+		}
+
+		relpath[len] = 0;
+		add_entry(relpath);
+	}
+
+	ok = true;
+
+done:
+	SDL_RWclose(rw);
+	return ok;
+}
+
+static bool is_package(const char *name) {
+	static const char *const exts[] = { ".zip", ".pkgdir" };
+	size_t len = strlen(name);
+
+	for(uint i = 0; i < ARRAY_SIZE(exts); ++i) {
+		size_t extlen = strlen(exts[i]);
+
+		if(len > extlen && !SDL_strcasecmp(name + len - extlen, exts[i])) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static void find_overrides(void) {
+	VFSDir *dir = vfs_dir_open(RESINDEX_OVERRIDES_DIR);
+
+	if(!dir) {
+		return;
+	}
+
+	for(const char *e; (e = vfs_dir_read(dir));) {
+		if(is_package(e)) {
+			continue;
+		}
+
+		log_debug("Loose files in '%s' override the packages; not indexing it", e);
+		resindex.overrides = realloc(resindex.overrides, (resindex.num_overrides + 1) * sizeof(*resindex.overrides));
+		resindex.overrides[resindex.num_overrides++] = strdup(e);
+	}
+
+	vfs_dir_close(dir);
+}
+
+static void free_entries(void) {
+	for(uint i = 0; i < resindex.num_entries; ++i) {
+		free(resindex.entries[i]);
+	}
+
+	free(resindex.entries);
+	resindex.entries = NULL;
+	resindex.num_entries = resindex.capacity = 0;
+}
+
+void resindex_init(void) {
+	memset(&resindex, 0, sizeof(resindex));
+	ht_create(&resindex.lookup);
+
+	if(env_get("TAISEI_NO_RESINDEX", false)) {
+		return;
+	}
+
+	size_t num_indices = 0;
+	char **indices = vfs_dir_list_sorted(RESINDEX_DIR, &num_indices, vfs_dir_list_order_ascending, NULL);
+
+	if(!indices || !num_indices) {
+		log_debug("No resource index found");
+		vfs_dir_list_free(indices, num_indices);
+		return;
+	}
+
+	bool ok = true;
+
+	for(size_t i = 0; i < num_indices && ok; ++i) {
+		char path[sizeof(RESINDEX_DIR) + strlen(indices[i]) + 1];
+		snprintf(path, sizeof(path), "%s/%s", RESINDEX_DIR, indices[i]);
+		ok = load_index(path);
+	}
+
+	vfs_dir_list_free(indices, num_indices);
+
+	if(!ok) {
+		// A partial index would make us miss files, so don't use it at all.
+		log_warn("Resource index is broken, falling back to probing");
+		ht_unset_all(&resindex.lookup);
+		free_entries();
+		return;
+	}
+
+	find_overrides();
+	resindex.loaded = true;
+
+	log_info("Resource index: %u files in %zu packages, %u overridden directories",
+		resindex.num_entries, num_indices, resindex.num_overrides
+	);
+}
+
+void resindex_shutdown(void) {
+	if(resindex.loaded) {
+		log_info("Resource index answered %i lookups, %i went to the VFS",
+			SDL_AtomicGet(&resindex.lookups.indexed), SDL_AtomicGet(&resindex.lookups.probed)
+		);
+	}
+
+	free_entries();
+
+	for(uint i = 0; i < resindex.num_overrides; ++i) {
+		free(resindex.overrides[i]);
+	}
+
+	free(resindex.overrides);
+	ht_destroy(&resindex.lookup);
+	memset(&resindex, 0, sizeof(resindex));
+}
+
+static bool resindex_covers(const char *path) {
+	if(!resindex.loaded || !strstartswith(path, "res/")) {
+		return false;
+	}
+
+	const char *top = path + strlen("res/");
+	size_t toplen = strcspn(top, "/");
+
+	for(uint i = 0; i < resindex.num_overrides; ++i) {
+		if(strlen(resindex.overrides[i]) == toplen && !strncmp(resindex.overrides[i], top, toplen)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool resindex_path_exists(const char *path) {
+	if(!resindex_covers(path)) {
+		SDL_AtomicIncRef(&resindex.lookups.probed);
+		return vfs_query(path).exists;
+	}
+
+	SDL_AtomicIncRef(&resindex.lookups.indexed);
+	return ht_get(&resindex.lookup, path, NULL) != NULL;
+}
+
+void* resindex_dir_walk(const char *path, void* (*visit)(const char *path, void *arg), void *arg) {
+	char prefix[strlen(path) + 2];
+	strcpy(prefix, path);
+
+	if(!strendswith(prefix, "/")) {
+		strcat(prefix, "/");
+	}
+
+	if(!resindex_covers(prefix)) {
+		SDL_AtomicIncRef(&resindex.lookups.probed);
+		return vfs_dir_walk(path, visit, arg);
+	}
+
+	SDL_AtomicIncRef(&resindex.lookups.indexed);
+	void *result = NULL;
+
+	for(uint i = 0; i < resindex.num_entries; ++i) {
+		const char *p = resindex.entries[i];
+
+		if(strstartswith(p, prefix) && (result = visit(p, arg))) {
+			break;
+		}
+	}
+
+	return result;
+}
@@ -14,6 +14,7 @@
 #include "menu/mainmenu.h"
 #include "events.h"
 #include "taskmanager.h"
+#include "global.h"
 
 #include "texture.h"
 #include "animation.h"
@@ -26,6 +27,8 @@
 #include "postprocess.h"
 #include "sprite.h"
 #include "font.h"
+#include "resindex.h"
+#include "profiler.h"
 
 #include "renderer/common/backend.h"
 
@@ -65,6 +68,17 @@ typedef struct ResourceAsyncLoadData {
 	void *opaque;
 } ResourceAsyncLoadData;
 
+static struct {
+	SDL_mutex *mutex;
+	InternalResource **resources;
+	uint num_resources;
+	uint capacity;
+	char *label;
+	hrtime_t start_time;
+	hrtime_t main_thread_time;
+	bool active;
+} preload_plan;
+
 static inline ResourceHandler* get_handler(ResourceType type) {
 	return *(_handlers + type);
 }
@@ -169,6 +183,29 @@ static void unload_resource(InternalResource *ires) {
 	free(ires);
 }
 
+// Resources that only matter for what's drawn on the screen or played through the speakers.
+// In logic-only mode, they are never preloaded, and stubbed out where possible.
+static bool is_presentation_only(ResourceType type) {
+	switch(type) {
+		case RES_TEXTURE:
+		case RES_SHADER_OBJECT:
+		case RES_SHADER_PROGRAM:
+		case RES_MODEL:
+		case RES_POSTPROCESS:
+		case RES_FONT:
+		case RES_SFX:
+		case RES_BGM:
+			return true;
+
+		default:
+			return false;
+	}
+}
+
+static inline bool should_stub(ResourceHandler *handler) {
+	return global.is_logic_only && handler->procs.stub && is_presentation_only(handler->type);
+}
+
 static char* get_name(ResourceHandler *handler, const char *path) {
 	if(handler->procs.name) {
 		return handler->procs.name(path);
@@ -181,7 +218,9 @@ static void* load_resource_async_task(void *vdata) {
 	ResourceAsyncLoadData *data = vdata;
 
 	SDL_LockMutex(data->ires->mutex);
+	PROFILE_BEGIN(pz, "resource_begin_load");
 	data->opaque = get_ires_handler(data->ires)->procs.begin_load(data->path, data->flags);
+	PROFILE_END(pz);
 	events_emit(TE_RESOURCE_ASYNC_LOADED, 0, data->ires, data);
 	SDL_UnlockMutex(data->ires->mutex);
 
@@ -249,6 +288,21 @@ static void load_resource(InternalResource *ires, const char *path, const char *
 		flags |= RESF_OPTIONAL;
 	}
 
+	if(should_stub(handler)) {
+		if(!name) {
+			name = allocated_name = get_name(handler, path);
+		}
+
+		log_debug("Stubbing out %s '%s'", typename, name);
+		ires->res.flags = flags;
+		ires->res.data = handler->procs.stub(name);
+		ires->status = RES_STATUS_LOADED;
+		assert(ires->res.data != NULL);
+
+		free(allocated_name);
+		return;
+	}
+
 	if(!path) {
 		path = allocated_path = handler->procs.find(name);
 
@@ -280,7 +334,10 @@ static void load_resource(InternalResource *ires, const char *path, const char *
 		name = allocated_name ? allocated_name : strdup(name);
 		load_resource_async(ires, (char*)path, (char*)name, flags);
 	} else {
-		load_resource_finish(ires, handler->procs.begin_load(path, flags), path, name, allocated_path, allocated_name, flags);
+		PROFILE_BEGIN(pz, "resource_begin_load");
+		void *opaque = handler->procs.begin_load(path, flags);
+		PROFILE_END(pz);
+		load_resource_finish(ires, opaque, path, name, allocated_path, allocated_name, flags);
 	}
 }
 
@@ -313,8 +370,24 @@ static void finalize_resource(InternalResource *ires, const char *name, void *da
 }
 
 static void load_resource_finish(InternalResource *ires, void *opaque, const char *path, const char *name, char *allocated_path, char *allocated_name, ResourceFlags flags) {
+	PROFILE_ZONE("resource_end_load");
+
+	// end_load may load dependencies synchronously; don't count those twice.
+	static uint nesting;
+	bool main_thread = is_main_thread();
+	bool measure = main_thread && nesting++ == 0 && preload_plan.active;
+	hrtime_t start_time = measure ? time_get() : 0;
+
 	void *raw = (ires->status == RES_STATUS_FAILED) ? NULL : get_ires_handler(ires)->procs.end_load(opaque, path, flags);
 
+	if(main_thread) {
+		--nesting;
+	}
+
+	if(measure) {
+		preload_plan.main_thread_time += time_get() - start_time;
+	}
+
 	name = name ? name : "<name unknown>";
 	path = path ? path : "<path unknown>";
 
@@ -343,7 +416,7 @@ Resource* get_resource(ResourceType type, const char *name, ResourceFlags flags)
 	if(try_begin_load_resource(type, name, &ires)) {
 		SDL_LockMutex(ires->mutex);
 
-		if(!(flags & RESF_PRELOAD)) {
+		if(!(flags & RESF_PRELOAD) && !(global.is_logic_only && is_presentation_only(type))) {
 			log_warn("%s '%s' was not preloaded", type_name(type), name);
 
 			if(env_get("TAISEI_PRELOAD_REQUIRED", false)) {
@@ -393,9 +466,27 @@ void preload_resource(ResourceType type, const char *name, ResourceFlags flags)
 	if(env_get("TAISEI_NOPRELOAD", false))
 		return;
 
+	if(global.is_logic_only && is_presentation_only(type)) {
+		return;
+	}
+
 	InternalResource *ires;
 
 	if(try_begin_load_resource(type, name, &ires)) {
+		// may be called from a loader thread, while resolving dependencies
+		SDL_LockMutex(preload_plan.mutex);
+
+		if(preload_plan.active) {
+			if(preload_plan.num_resources == preload_plan.capacity) {
+				preload_plan.capacity = preload_plan.capacity ? preload_plan.capacity * 2 : 64;
+				preload_plan.resources = realloc(preload_plan.resources, preload_plan.capacity * sizeof(*preload_plan.resources));
+			}
+
+			preload_plan.resources[preload_plan.num_resources++] = ires;
+		}
+
+		SDL_UnlockMutex(preload_plan.mutex);
+
 		SDL_LockMutex(ires->mutex);
 		load_resource(ires, NULL, name, flags | RESF_PRELOAD, !env_get("TAISEI_NOASYNC", false));
 		SDL_UnlockMutex(ires->mutex);
@@ -413,7 +504,71 @@ void preload_resources(ResourceType type, ResourceFlags flags, const char *first
 	va_end(args);
 }
 
+void preload_plan_begin(const char *label) {
+	assert(is_main_thread());
+	assert(!preload_plan.active);
+
+	SDL_LockMutex(preload_plan.mutex);
+	preload_plan.label = strdup(label);
+	preload_plan.num_resources = 0;
+	preload_plan.main_thread_time = 0;
+	preload_plan.start_time = time_get();
+	preload_plan.active = true;
+	SDL_UnlockMutex(preload_plan.mutex);
+}
+
+void preload_plan_end(ResourcePreloadStats *stats) {
+	assert(is_main_thread());
+	assert(preload_plan.active);
+
+	ResourcePreloadStats st = { 0 };
+
+	// Resources are finished in the order they were requested. Those that depend on others
+	// wait for their dependencies as needed; the dependencies themselves get appended to the
+	// list by the loader threads while we're going through it.
+	for(uint i = 0;; ++i) {
+		SDL_LockMutex(preload_plan.mutex);
+
+		if(i >= preload_plan.num_resources) {
+			SDL_UnlockMutex(preload_plan.mutex);
+			break;
+		}
+
+		InternalResource *ires = preload_plan.resources[i];
+		SDL_UnlockMutex(preload_plan.mutex);
+
+		if(wait_for_resource_load(ires, 0) != RES_STATUS_LOADED) {
+			++st.num_failed;
+		}
+	}
+
+	SDL_LockMutex(preload_plan.mutex);
+	st.num_resources = preload_plan.num_resources;
+	st.time = time_get() - preload_plan.start_time;
+	st.main_thread_time = preload_plan.main_thread_time;
+	preload_plan.active = false;
+	SDL_UnlockMutex(preload_plan.mutex);
+
+	log_info("%s: preloaded %u resources in %.2f ms (%.2f ms in main thread, %u failed)",
+		preload_plan.label,
+		st.num_resources,
+		st.time / (double)(HRTIME_RESOLUTION / 1000),
+		st.main_thread_time / (double)(HRTIME_RESOLUTION / 1000),
+		st.num_failed
+	);
+
+	free(preload_plan.label);
+	preload_plan.label = NULL;
+
+	if(stats) {
+		*stats = st;
+	}
+}
+
 void init_resources(void) {
+	resindex_init();
+	preload_plan.mutex = SDL_CreateMutex();
+
 	for(int i = 0; i < RES_NUMTYPES; ++i) {
 		ResourceHandler *h = get_handler(i);
 		alloc_handler(h);
@@ -504,11 +659,13 @@ void load_resources(void) {
 		}
 	}
 
+	preload_plan_begin("Main menu");
 	menu_preload();
+	preload_plan_end(NULL);
 
 	if(env_get("TAISEI_PRELOAD_SHADERS", 0)) {
 		log_warn("Loading all shaders now due to TAISEI_PRELOAD_SHADERS");
-		vfs_dir_walk(SHPROG_PATH_PREFIX, preload_shaders, NULL);
+		resindex_dir_walk(SHPROG_PATH_PREFIX, preload_shaders, NULL);
 	}
 }
 
@@ -577,4 +734,9 @@ void free_resources(bool all) {
 	if(!env_get("TAISEI_NOASYNC", 0)) {
 		events_unregister_handler(resource_asyncload_handler);
 	}
+
+	resindex_shutdown();
+	free(preload_plan.resources);
+	SDL_DestroyMutex(preload_plan.mutex);
+	memset(&preload_plan, 0, sizeof(preload_plan));
 }
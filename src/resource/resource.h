@@ -12,6 +12,7 @@
 #include "taisei.h"
 
 #include "hashtable.h"
+#include "hirestime.h"
 
 typedef enum ResourceType {
 	RES_TEXTURE,
@@ -64,6 +65,11 @@ typedef void* (*ResourceEndLoadProc)(void *opaque, const char *path, uint flags)
 // Unloads a resource, freeing all allocated to it memory.
 typedef void (*ResourceUnloadProc)(void *res);
 
+// Creates a placeholder that stands in for the resource when nothing is going to be rendered or
+// played (see global.is_logic_only), without touching any files. Must be safe to free with the
+// unload proc. This method is optional; without it, such resources are loaded as usual on demand.
+typedef void* (*ResourceStubProc)(const char *name);
+
 // Called during resource subsystem initialization
 typedef void (*ResourceInitProc)(void);
 
@@ -86,6 +92,7 @@ typedef struct ResourceHandler {
 		ResourceBeginLoadProc begin_load;
 		ResourceEndLoadProc end_load;
 		ResourceUnloadProc unload;
+		ResourceStubProc stub;
 		ResourceInitProc init;
 		ResourcePostInitProc post_init;
 		ResourceShutdownProc shutdown;
@@ -102,6 +109,13 @@ typedef struct Resource {
 	void *data;
 } Resource;
 
+typedef struct ResourcePreloadStats {
+	uint num_resources;
+	uint num_failed;
+	hrtime_t time;              // wall clock, from preload_plan_begin to preload_plan_end
+	hrtime_t main_thread_time;  // spent in the main thread finalizing resources
+} ResourcePreloadStats;
+
 void init_resources(void);
 void load_resources(void);
 void free_resources(bool all);
@@ -110,6 +124,12 @@ Resource* get_resource(ResourceType type, const char *name, ResourceFlags flags)
 void* get_resource_data(ResourceType type, const char *name, ResourceFlags flags);
 void preload_resource(ResourceType type, const char *name, ResourceFlags flags);
 void preload_resources(ResourceType type, ResourceFlags flags, const char *firstname, ...) attr_sentinel;
+// Everything preloaded between these two calls, including dependencies that the handlers discover
+// along the way, is loaded in parallel and then finalized in one batch by preload_plan_end, which
+// blocks until all of it is ready and logs the total load time. stats may be NULL.
+void preload_plan_begin(const char *label) attr_nonnull(1);
+void preload_plan_end(ResourcePreloadStats *stats);
+
 void* resource_for_each(ResourceType type, void* (*callback)(const char *name, Resource *res, void *arg), void *arg);
 
 void resource_util_strip_ext(char *path);
@@ -74,6 +74,7 @@ static void* load_shader_object_begin(const char *path, uint flags) {
 			GLSLSourceOptions opts = {
 				.version = { 330, GLSL_PROFILE_CORE },
 				.stage = type->stage,
+				.frame_uniform_block = r_supports(RFEAT_UNIFORM_BUFFERS),
 			};
 
 			if(!glsl_load_source(path, &ldata->source, &opts)) {
@@ -108,6 +108,11 @@ static void unload_shader_program(void *vprog) {
 	r_shader_program_destroy(vprog);
 }
 
+static void* shader_program_stub(const char *name) {
+	// Only meaningful with the null renderer, which is the only one logic-only mode runs with.
+	return r_shader_program_link(0, NULL);
+}
+
 ResourceHandler shader_program_res_handler = {
 	.type = RES_SHADER_PROGRAM,
 	.typename = "shader program",
@@ -119,5 +124,6 @@ ResourceHandler shader_program_res_handler = {
 		.begin_load = load_shader_program_begin,
 		.end_load = load_shader_program_end,
 		.unload = unload_shader_program,
+		.stub = shader_program_stub,
 	},
 };
@@ -11,6 +11,7 @@
 #include "sprite.h"
 #include "video.h"
 #include "renderer/api.h"
+#include "resindex.h"
 
 ResourceHandler sprite_res_handler = {
 	.type = RES_SPRITE,
@@ -29,9 +30,7 @@ ResourceHandler sprite_res_handler = {
 char* sprite_path(const char *name) {
 	char *path = strjoin(SPRITE_PATH_PREFIX, name, SPRITE_EXTENSION, NULL);
 
-	VFSInfo pinfo = vfs_query(path);
-
-	if(!pinfo.exists) {
+	if(!resindex_path_exists(path)) {
 		free(path);
 		return texture_path(name);
 	}
@@ -57,6 +56,7 @@ void* load_sprite_begin(const char *path, uint flags) {
 
 	if(check_texture_path(path)) {
 		state->texture_name = resource_util_basename(TEX_PATH_PREFIX, path);
+		preload_resource(RES_TEXTURE, state->texture_name, flags);
 		return state;
 	}
 
@@ -82,6 +82,9 @@ void* load_sprite_begin(const char *path, uint flags) {
 		log_warn("%s: inferred texture name from sprite name", state->texture_name);
 	}
 
+	// Get the texture going right away, instead of waiting for load_sprite_end to ask for it.
+	preload_resource(RES_TEXTURE, state->texture_name, flags);
+
 	return state;
 }
 
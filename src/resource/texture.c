@@ -18,6 +18,7 @@
 static void* load_texture_begin(const char *path, uint flags);
 static void* load_texture_end(void *opaque, const char *path, uint flags);
 static void free_texture(Texture *tex);
+static void* texture_stub(const char *name);
 
 ResourceHandler texture_res_handler = {
 	.type = RES_TEXTURE,
@@ -30,6 +31,7 @@ ResourceHandler texture_res_handler = {
 		.begin_load = load_texture_begin,
 		.end_load = load_texture_end,
 		.unload = (ResourceUnloadProc)free_texture,
+		.stub = texture_stub,
 	},
 };
 
@@ -269,10 +271,9 @@ static void* load_texture_begin(const char *path, uint flags) {
 			.mipmaps = TEX_MIPMAPS_MAX,
 			.anisotropy = TEX_ANISOTROPY_DEFAULT,
 
-			// Manual because we don't want mipmaps generated until we've applied the
-			// post-load shader, which will premultiply alpha.
-			// Mipmaps and filtering are basically broken without premultiplied alpha.
-			.mipmap_mode = TEX_MIPMAP_MANUAL,
+			// Alpha is premultiplied below, before the image ever reaches the renderer,
+			// so mipmaps can be generated as soon as the upload completes.
+			.mipmap_mode = TEX_MIPMAP_AUTO,
 		}
 	};
 
@@ -357,6 +358,13 @@ static void* load_texture_begin(const char *path, uint flags) {
 
 	override_format = override_format ? override_format : ld.pixmap.format;
 	ld.params.type = pixmap_format_to_texture_type(override_format);
+
+	// Do all the pixel crunching here, on the loader thread, so that the main thread
+	// only has to stream the result to the GPU.
+	// Mipmaps and filtering are basically broken without premultiplied alpha.
+	pixmap_convert_inplace_realloc(&ld.pixmap, override_format);
+	pixmap_premultiply_alpha_inplace(&ld.pixmap);
+
 	log_debug("%s: %d channels, %d bits per channel, %s",
 		path,
 		PIXMAP_FORMAT_LAYOUT(override_format),
@@ -374,55 +382,6 @@ static void* load_texture_begin(const char *path, uint flags) {
 	return memdup(&ld, sizeof(ld));
 }
 
-static Texture* texture_post_load(Texture *tex) {
-	// this is a bit hacky and not very efficient,
-	// but it's still much faster than fixing up the texture on the CPU
-
-	ShaderProgram *shader_saved = r_shader_current();
-	Framebuffer *fb_saved = r_framebuffer_current();
-	BlendMode blend_saved = r_blend_current();
-	bool cullcap_saved = r_capability_current(RCAP_CULL_FACE);
-
-	Texture *fbo_tex;
-	TextureParams params;
-	Framebuffer *fb;
-
-	r_blend(BLEND_NONE);
-	r_disable(RCAP_CULL_FACE);
-	r_texture_get_params(tex, &params);
-	params.mipmap_mode = TEX_MIPMAP_AUTO;
-	r_texture_set_filter(tex, TEX_FILTER_NEAREST, TEX_FILTER_NEAREST);
-	fbo_tex = r_texture_create(&params);
-	r_shader("texture_post_load");
-	r_uniform_sampler("tex", tex);
-	r_mat_push();
-	r_mat_identity();
-	r_mat_mode(MM_PROJECTION);
-	r_mat_push();
-	r_mat_identity();
-	r_mat_ortho(0, params.width, params.height, 0, -100, 100);
-	r_mat_mode(MM_MODELVIEW);
-	r_mat_scale(params.width, params.height, 1);
-	r_mat_translate(0.5, 0.5, 0);
-	fb = r_framebuffer_create();
-	r_framebuffer_attach(fb, fbo_tex, 0, FRAMEBUFFER_ATTACH_COLOR0);
-	r_framebuffer_viewport(fb, 0, 0, params.width, params.height);
-	r_framebuffer(fb);
-	r_draw_quad();
-	r_mat_pop();
-	r_mat_mode(MM_PROJECTION);
-	r_mat_pop();
-	r_mat_mode(MM_MODELVIEW);
-	r_framebuffer(fb_saved);
-	r_shader_ptr(shader_saved);
-	r_blend(blend_saved);
-	r_capability(RCAP_CULL_FACE, cullcap_saved);
-	r_framebuffer_destroy(fb);
-	r_texture_destroy(tex);
-
-	return fbo_tex;
-}
-
 static void* load_texture_end(void *opaque, const char *path, uint flags) {
 	TextureLoadData *ld = opaque;
 
@@ -433,12 +392,9 @@ static void* load_texture_end(void *opaque, const char *path, uint flags) {
 	char *basename = resource_util_basename(TEX_PATH_PREFIX, path);
 	Texture *texture = r_texture_create(&ld->params);
 	r_texture_set_debug_label(texture, basename);
-	r_texture_fill(texture, 0, &ld->pixmap);
+	r_texture_fill_async(texture, 0, &ld->pixmap);
 	free(ld->pixmap.data.untyped);
 	free(ld);
-
-	texture = texture_post_load(texture);
-	r_texture_set_debug_label(texture, basename);
 	free(basename);
 
 	return texture;
@@ -461,6 +417,18 @@ static void free_texture(Texture *tex) {
 	r_texture_destroy(tex);
 }
 
+static void* texture_stub(const char *name) {
+	// Same as what the null renderer reports for any texture, so the sprites come out the same either way.
+	return r_texture_create(&(TextureParams) {
+		.width = 1,
+		.height = 1,
+		.type = TEX_TYPE_RGBA,
+		.filter = { .mag = TEX_FILTER_NEAREST, .min = TEX_FILTER_NEAREST },
+		.wrap = { .s = TEX_WRAP_CLAMP, .t = TEX_WRAP_CLAMP },
+		.mipmaps = 1,
+	});
+}
+
 static struct draw_texture_state {
 	bool drawing;
 	bool texture_matrix_tainted;
@@ -0,0 +1,465 @@
+/*
+ * This software is licensed under the terms of the MIT-License
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2019, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2019, Andrei Alexeyev <akari@alienslab.net>.
+ */
+
+#include "taisei.h"
+
+#include "snapshot.h"
+#include "global.h"
+#include "stageobjects.h"
+#include "projectile_motion.h"
+
+#define SNAPSHOT_POOLS \
+	SNAPSHOT_POOL(projectiles) \
+	SNAPSHOT_POOL(items) \
+	SNAPSHOT_POOL(enemies) \
+	SNAPSHOT_POOL(lasers) \
+
+// Fields of Global that are part of the simulation, other than plr, boss and dialog.
+#define SNAPSHOT_GLOBALS \
+	SNAPSHOT_GLOBAL(ProjectileList, projs) \
+	SNAPSHOT_GLOBAL(ProjectileList, particles) \
+	SNAPSHOT_GLOBAL(EnemyList, enemies) \
+	SNAPSHOT_GLOBAL(ItemList, items) \
+	SNAPSHOT_GLOBAL(LaserList, lasers) \
+	SNAPSHOT_GLOBAL(int, frames) \
+	SNAPSHOT_GLOBAL(int, timer) \
+	SNAPSHOT_GLOBAL(int, stage_start_frame) \
+	SNAPSHOT_GLOBAL(GameoverType, gameover) \
+	SNAPSHOT_GLOBAL(int, gameover_time) \
+	SNAPSHOT_GLOBAL(float, shake_view) \
+	SNAPSHOT_GLOBAL(float, shake_view_fade) \
+	SNAPSHOT_GLOBAL(uint, voltage_threshold) \
+	SNAPSHOT_GLOBAL(RandomState, rand_game) \
+	SNAPSHOT_GLOBAL(RandomState, rand_visual) \
+
+typedef struct SnapshotSection {
+	const char *name;
+	void *data;
+	size_t size;
+} SnapshotSection;
+
+struct GameSnapshot {
+	struct {
+		#define SNAPSHOT_POOL(field) ObjectPoolSnapshot *field;
+		SNAPSHOT_POOLS
+		#undef SNAPSHOT_POOL
+	} pools;
+
+	struct {
+		#define SNAPSHOT_GLOBAL(type, field) type field;
+		SNAPSHOT_GLOBALS
+		#undef SNAPSHOT_GLOBAL
+	} global;
+
+	EntitySnapshot *entities;
+	RefSnapshot *refs;
+
+	Player plr;
+	Boss *boss;
+	EntityInterface *boss_ent; // where the boss was registered from; see copy_boss
+	Dialog *dialog;
+
+	struct {
+		uint16_t desync_check;
+		int fps;
+	} replay;
+
+	SnapshotSection *sections;
+	uint num_sections;
+	char *section_data;
+
+	uint64_t checksum;
+	size_t size;
+};
+
+static struct {
+	SnapshotSection *sections;
+	uint num_sections;
+
+	struct {
+		GameSnapshot **snaps;  // oldest first, starting at index 'first'
+		uint capacity;
+		uint first;
+		uint count;
+		uint interval;
+		bool active;
+	} ring;
+} snapshots;
+
+void snapshot_register_section(const char *name, void *data, size_t size) {
+	snapshots.sections = realloc(snapshots.sections, (snapshots.num_sections + 1) * sizeof(*snapshots.sections));
+	snapshots.sections[snapshots.num_sections++] = (SnapshotSection) { name, data, size };
+}
+
+void snapshot_register_zeroed_section(const char *name, void *data, size_t size) {
+	memset(data, 0, size);
+	snapshot_register_section(name, data, size);
+}
+
+void snapshot_unregister_section(void *data) {
+	for(uint i = 0; i < snapshots.num_sections; ++i) {
+		if(snapshots.sections[i].data == data) {
+			snapshots.sections[i] = snapshots.sections[--snapshots.num_sections];
+			return;
+		}
+	}
+
+	UNREACHABLE;
+}
+
+static const SnapshotSection *find_section(void *data) {
+	for(uint i = 0; i < snapshots.num_sections; ++i) {
+		if(snapshots.sections[i].data == data) {
+			return snapshots.sections + i;
+		}
+	}
+
+	return NULL;
+}
+
+static void hash_bytes(uint64_t *h, const void *data, size_t size) {
+	// FNV-1a
+	const uint8_t *p = data;
+
+	for(size_t i = 0; i < size; ++i) {
+		*h = (*h ^ p[i]) * UINT64_C(0x100000001b3);
+	}
+}
+
+#define HASH(h, val) hash_bytes(h, &(val), sizeof(val))
+
+// Particles are left out: they don't feed back into the simulation.
+static uint64_t compute_checksum(void) {
+	uint64_t h = UINT64_C(0xcbf29ce484222325);
+	Player *plr = &global.plr;
+
+	HASH(&h, global.frames);
+	HASH(&h, global.timer);
+	HASH(&h, global.rand_game.state);
+
+	HASH(&h, plr->pos);
+	HASH(&h, plr->points);
+	HASH(&h, plr->lives);
+	HASH(&h, plr->bombs);
+	HASH(&h, plr->life_fragments);
+	HASH(&h, plr->bomb_fragments);
+	HASH(&h, plr->power);
+	HASH(&h, plr->graze);
+	HASH(&h, plr->voltage);
+
+	for(Projectile *p = global.projs.first; p; p = p->next) {
+		HASH(&h, p->pos);
+		HASH(&h, p->birthtime);
+	}
+
+	for(Enemy *e = global.enemies.first; e; e = e->next) {
+		HASH(&h, e->pos);
+		HASH(&h, e->hp);
+	}
+
+	for(Item *i = global.items.first; i; i = i->next) {
+		HASH(&h, i->pos);
+		HASH(&h, i->type);
+	}
+
+	for(Laser *l = global.lasers.first; l; l = l->next) {
+		HASH(&h, l->pos);
+		HASH(&h, l->args);
+		HASH(&h, l->birthtime);
+		HASH(&h, l->next_graze);
+		HASH(&h, l->timespan);
+		HASH(&h, l->deathtime);
+		HASH(&h, l->timeshift);
+		HASH(&h, l->speed);
+		HASH(&h, l->width);
+	}
+
+	if(global.boss) {
+		Boss *boss = global.boss;
+
+		HASH(&h, boss->pos);
+		HASH(&h, boss->failed_spells);
+		HASH(&h, boss->lastdamageframe);
+
+		if(boss->current) {
+			ptrdiff_t attack = boss->current - boss->attacks;
+			HASH(&h, attack);
+		}
+
+		for(int i = 0; i < boss->acount; ++i) {
+			Attack *a = boss->attacks + i;
+			HASH(&h, a->starttime);
+			HASH(&h, a->timeout);
+			HASH(&h, a->endtime);
+			HASH(&h, a->endtime_undelayed);
+			HASH(&h, a->hp);
+			HASH(&h, a->finished);
+			HASH(&h, a->failtime);
+		}
+	}
+
+	// Module state, including whatever the boss attacks keep outside of the boss.
+	for(uint i = 0; i < snapshots.num_sections; ++i) {
+		hash_bytes(&h, snapshots.sections[i].data, snapshots.sections[i].size);
+	}
+
+	return h;
+}
+
+GameSnapshot *snapshot_capture(void) {
+	GameSnapshot *snap = calloc(1, sizeof(*snap));
+
+	#define SNAPSHOT_POOL(field) \
+		if(!(snap->pools.field = objpool_snapshot(stage_object_pools.field))) { \
+			log_error("Object pools don't support snapshots in this build"); \
+			snapshot_free(snap); \
+			return NULL; \
+		} \
+		snap->size += objpool_snapshot_size(snap->pools.field);
+
+	SNAPSHOT_POOLS
+	#undef SNAPSHOT_POOL
+
+	#define SNAPSHOT_GLOBAL(type, field) snap->global.field = global.field;
+	SNAPSHOT_GLOBALS
+	#undef SNAPSHOT_GLOBAL
+
+	snap->entities = ent_snapshot();
+	snap->refs = ref_snapshot();
+
+	snap->plr = global.plr;
+	aniplayer_copy(&snap->plr.ani, &global.plr.ani);
+
+	if(global.boss) {
+		snap->boss = copy_boss(global.boss);
+		snap->boss_ent = &global.boss->ent;
+	}
+
+	if(global.dialog) {
+		snap->dialog = copy_dialog(global.dialog);
+	}
+
+	if(global.replay_stage) {
+		snap->replay.desync_check = global.replay_stage->desync_check;
+		snap->replay.fps = global.replay_stage->fps;
+	}
+
+	size_t section_size = 0;
+
+	for(uint i = 0; i < snapshots.num_sections; ++i) {
+		section_size += snapshots.sections[i].size;
+	}
+
+	snap->num_sections = snapshots.num_sections;
+	snap->sections = memdup(snapshots.sections, snap->num_sections * sizeof(*snap->sections));
+	snap->section_data = malloc(section_size);
+
+	for(uint i = 0, ofs = 0; i < snap->num_sections; ofs += snap->sections[i++].size) {
+		memcpy(snap->section_data + ofs, snap->sections[i].data, snap->sections[i].size);
+	}
+
+	snap->size += sizeof(*snap) + section_size;
+	snap->checksum = compute_checksum();
+
+	return snap;
+}
+
+void snapshot_restore(GameSnapshot *snap) {
+	// The entity registry and the ref table are about to be overwritten, so these are
+	// freed without unregistering.
+	if(global.boss) {
+		free_boss_copy(global.boss);
+		global.boss = NULL;
+	}
+
+	if(global.dialog) {
+		delete_dialog(global.dialog);
+		global.dialog = NULL;
+	}
+
+	#define SNAPSHOT_POOL(field) \
+		if(!objpool_restore(stage_object_pools.field, snap->pools.field)) { \
+			log_fatal("Failed to restore the snapshot of frame %i", snap->global.frames); \
+		}
+
+	SNAPSHOT_POOLS
+	#undef SNAPSHOT_POOL
+
+	#define SNAPSHOT_GLOBAL(type, field) global.field = snap->global.field;
+	SNAPSHOT_GLOBALS
+	#undef SNAPSHOT_GLOBAL
+
+	ent_snapshot_restore(snap->entities);
+	ref_snapshot_restore(snap->refs);
+
+	aniplayer_free(&global.plr.ani);
+	global.plr = snap->plr;
+	aniplayer_copy(&global.plr.ani, &snap->plr.ani);
+
+	if(snap->boss) {
+		global.boss = copy_boss(snap->boss);
+		ent_relocate(snap->boss_ent, &global.boss->ent);
+	}
+
+	if(snap->dialog) {
+		global.dialog = copy_dialog(snap->dialog);
+	}
+
+	if(global.replay_stage) {
+		replay_stage_seek(global.replay_stage, global.frames);
+		global.replay_stage->desync_check = snap->replay.desync_check;
+		global.replay_stage->fps = snap->replay.fps;
+	}
+
+	for(uint i = 0, ofs = 0; i < snap->num_sections; ofs += snap->sections[i++].size) {
+		const SnapshotSection *s = find_section(snap->sections[i].data);
+
+		if(s && s->size == snap->sections[i].size) {
+			memcpy(s->data, snap->section_data + ofs, s->size);
+		} else {
+			log_debug("Section '%s' is no longer registered, not restoring it", snap->sections[i].name);
+		}
+	}
+
+	proj_motion_rebuild();
+}
+
+void snapshot_free(GameSnapshot *snap) {
+	#define SNAPSHOT_POOL(field) \
+		if(snap->pools.field) { \
+			objpool_snapshot_free(snap->pools.field); \
+		}
+
+	SNAPSHOT_POOLS
+	#undef SNAPSHOT_POOL
+
+	if(snap->entities) {
+		ent_snapshot_free(snap->entities);
+	}
+
+	if(snap->refs) {
+		ref_snapshot_free(snap->refs);
+	}
+
+	if(snap->boss) {
+		free_boss_copy(snap->boss);
+	}
+
+	if(snap->dialog) {
+		delete_dialog(snap->dialog);
+	}
+
+	aniplayer_free(&snap->plr.ani);
+	free(snap->sections);
+	free(snap->section_data);
+	free(snap);
+}
+
+int snapshot_frame(GameSnapshot *snap) {
+	return snap->global.frames;
+}
+
+uint64_t snapshot_checksum(GameSnapshot *snap) {
+	return snap->checksum;
+}
+
+static inline GameSnapshot **ring_slot(uint i) {
+	return snapshots.ring.snaps + (snapshots.ring.first + i) % snapshots.ring.capacity;
+}
+
+static void ring_drop_newest(void) {
+	assert(snapshots.ring.count > 0);
+	GameSnapshot **slot = ring_slot(--snapshots.ring.count);
+	snapshot_free(*slot);
+	*slot = NULL;
+}
+
+void snapshot_ring_init(uint interval, uint capacity) {
+	assert(!snapshots.ring.active);
+	assert(interval > 0);
+	assert(capacity > 0);
+
+	snapshots.ring.snaps = calloc(capacity, sizeof(*snapshots.ring.snaps));
+	snapshots.ring.capacity = capacity;
+	snapshots.ring.first = 0;
+	snapshots.ring.count = 0;
+	snapshots.ring.interval = interval;
+	snapshots.ring.active = true;
+
+	stage_objpools_hold_extents(true);
+
+	log_debug("Taking a snapshot every %u frames, keeping up to %u", interval, capacity);
+}
+
+void snapshot_ring_shutdown(void) {
+	if(!snapshots.ring.active) {
+		return;
+	}
+
+	while(snapshots.ring.count > 0) {
+		ring_drop_newest();
+	}
+
+	free(snapshots.ring.snaps);
+	memset(&snapshots.ring, 0, sizeof(snapshots.ring));
+	stage_objpools_hold_extents(false);
+}
+
+bool snapshot_ring_active(void) {
+	return snapshots.ring.active;
+}
+
+GameSnapshot *snapshot_ring_update(void) {
+	if(!snapshots.ring.active || global.frames % snapshots.ring.interval) {
+		return NULL;
+	}
+
+	if(snapshots.ring.count > 0 && snapshot_frame(*ring_slot(snapshots.ring.count - 1)) >= global.frames) {
+		return NULL;
+	}
+
+	GameSnapshot *snap = snapshot_capture();
+
+	if(!snap) {
+		snapshot_ring_shutdown();
+		return NULL;
+	}
+
+	if(snapshots.ring.count == snapshots.ring.capacity) {
+		snapshot_free(snapshots.ring.snaps[snapshots.ring.first]);
+		snapshots.ring.snaps[snapshots.ring.first] = NULL;
+		snapshots.ring.first = (snapshots.ring.first + 1) % snapshots.ring.capacity;
+		--snapshots.ring.count;
+	}
+
+	*ring_slot(snapshots.ring.count++) = snap;
+	log_debug("Frame %i: %zu bytes", global.frames, snap->size);
+
+	return snap;
+}
+
+GameSnapshot *snapshot_ring_find(int frame) {
+	for(uint i = snapshots.ring.count; i > 0; --i) {
+		GameSnapshot *snap = *ring_slot(i - 1);
+
+		if(snapshot_frame(snap) <= frame) {
+			return snap;
+		}
+	}
+
+	return NULL;
+}
+
+void snapshot_ring_restore(GameSnapshot *snap) {
+	while(snapshots.ring.count > 0 && *ring_slot(snapshots.ring.count - 1) != snap) {
+		ring_drop_newest();
+	}
+
+	assert(snapshots.ring.count > 0);
+	snapshot_restore(snap);
+}
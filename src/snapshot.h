@@ -0,0 +1,66 @@
+/*
+ * This software is licensed under the terms of the MIT-License
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2019, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2019, Andrei Alexeyev <akari@alienslab.net>.
+ */
+
+#ifndef IGUARD_snapshot_h
+#define IGUARD_snapshot_h
+
+#include "taisei.h"
+
+/*
+ * Snapshots of the deterministic simulation state of the running stage, taken between
+ * logic frames. Used to seek backwards in replays: restore the latest snapshot before
+ * the target frame, then simulate forward.
+ *
+ * A snapshot covers the player, the boss and dialog, the stage object pools (except
+ * stagetext, which is purely visual), the entity registry, the ref table, timers and
+ * RNG states, and whatever else has been registered with snapshot_register_section.
+ *
+ * Snapshots only ever live in memory, within one stage. That means pointers inside the
+ * saved state (rules, list links, resources) can be kept as they are: pooled objects are
+ * put back at the addresses they were saved from, and the only heap-allocated entity,
+ * the boss, is relocated explicitly. For the same reason, the pools can't release their
+ * extents while the snapshot ring is active.
+ */
+
+typedef struct GameSnapshot GameSnapshot;
+
+// Registers a plain block of memory holding module state that affects the simulation
+// (or how it's presented, if it can't be recomputed). It's saved and restored verbatim.
+void snapshot_register_section(const char *name, void *data, size_t size) attr_nonnull(1, 2);
+
+// Zeroes the data, then registers it. Meant for state that boss attacks and the like keep
+// across calls of their rules (in file-scope statics, for lack of a better place), which
+// their stage registers when it starts and unregisters when it ends.
+void snapshot_register_zeroed_section(const char *name, void *data, size_t size) attr_nonnull(1, 2);
+void snapshot_unregister_section(void *data) attr_nonnull(1);
+
+GameSnapshot *snapshot_capture(void) attr_nodiscard;
+void snapshot_restore(GameSnapshot *snap) attr_nonnull(1);
+void snapshot_free(GameSnapshot *snap) attr_nonnull(1);
+int snapshot_frame(GameSnapshot *snap) attr_nonnull(1);
+
+// Hash of the parts of the state that show up in the simulation results. Two snapshots of
+// the same frame of the same replay must hash the same.
+uint64_t snapshot_checksum(GameSnapshot *snap) attr_nonnull(1);
+
+// Ring buffer of snapshots taken every 'interval' frames, holding up to 'capacity' of them.
+void snapshot_ring_init(uint interval, uint capacity);
+void snapshot_ring_shutdown(void);
+bool snapshot_ring_active(void);
+
+// Takes a snapshot if one is due at the current frame. Returns it, or NULL if none was taken.
+GameSnapshot *snapshot_ring_update(void);
+
+// Latest snapshot at or before frame, or NULL.
+GameSnapshot *snapshot_ring_find(int frame);
+
+// Restores a snapshot from the ring. Newer snapshots are dropped; they'll be taken again as
+// the simulation catches up.
+void snapshot_ring_restore(GameSnapshot *snap) attr_nonnull(1);
+
+#endif // IGUARD_snapshot_h
@@ -25,7 +25,12 @@
 #include "stagetext.h"
 #include "stagedraw.h"
 #include "stageobjects.h"
+#include "entity_grid.h"
+#include "snapshot.h"
+#include "bench.h"
+#include "profiler.h"
 #include "eventloop/eventloop.h"
+#include "stages/stress.h"
 
 #ifdef DEBUG
 	#define DPSTEST
@@ -139,6 +144,24 @@ void stage_init_array(void) {
 #endif
 }
 
+// The stress tests are only meant for --bench, so they are left out of the array unless it
+// asks for them. Must be called before anything holds on to pointers into the array.
+void stage_add_stress_tests(void) {
+	if(stage_get(0x50)) {
+		return;
+	}
+
+	// drop the terminator, and add it back after the new entries
+	assert(numstages > 0 && !stages[numstages - 1].procs);
+	--numstages;
+
+	add_stage(0x50|0, &stage_stress_bullets_procs, STAGE_SPECIAL, "Stress Test", "Bullet spiral", NULL, D_Normal);
+	add_stage(0x50|1, &stage_stress_lasers_procs, STAGE_SPECIAL, "Stress Test", "Laser storm", NULL, D_Normal);
+	add_stage(0x50|2, &stage_stress_items_procs, STAGE_SPECIAL, "Stress Test", "Item flood", NULL, D_Normal);
+
+	end_stages();
+}
+
 void stage_free_array(void) {
 	for(StageInfo *stg = stages; stg->procs; ++stg) {
 		free(stg->title);
@@ -295,10 +318,35 @@ void stage_gameover(void) {
 	stage_enter_ingame_menu(create_gameover_menu(), NO_CALLCHAIN);
 }
 
+typedef struct StageFrameState {
+	StageInfo *stage;
+	int transition_delay;
+	uint16_t last_replay_fps;
+	CallChain cc;
+	int logic_calls;
+	hrtime_t start_time;
+
+	// Replay seeking; see snapshot.h
+	struct {
+		int target;
+		bool pending;
+		bool fast_forwarding;
+		bool verify;
+	} seek;
+} StageFrameState;
+
+// How far KEY_LEFT and KEY_RIGHT seek during replay playback
+#define REPLAY_SEEK_STEP (FPS * 5)
+
 static bool stage_input_common(SDL_Event *event, void *arg) {
 	TaiseiEvent type = TAISEI_EVENT(event->type);
 	int32_t code = event->user.code;
 
+	if(event->type == SDL_APP_LOWMEMORY) {
+		stage_objpools_reclaim();
+		return false;
+	}
+
 	switch(type) {
 		case TE_GAME_KEY_DOWN:
 			switch(code) {
@@ -400,23 +448,47 @@ static bool stage_input_handler_gameplay(SDL_Event *event, void *arg) {
 	return false;
 }
 
+static void stage_request_seek(StageFrameState *fstate, int delta) {
+	if(global.gameover) {
+		return;
+	}
+
+	int from = fstate->seek.pending ? fstate->seek.target : global.frames;
+	fstate->seek.target = imax(0, from + delta);
+	fstate->seek.pending = true;
+}
+
 static bool stage_input_handler_replay(SDL_Event *event, void *arg) {
-	stage_input_common(event, arg);
+	if(stage_input_common(event, arg)) {
+		return false;
+	}
+
+	if(TAISEI_EVENT(event->type) == TE_GAME_KEY_DOWN) {
+		switch(event->user.code) {
+			case KEY_LEFT:
+				if(snapshot_ring_active()) {
+					stage_request_seek(arg, -REPLAY_SEEK_STEP);
+				}
+				break;
+
+			case KEY_RIGHT:
+				stage_request_seek(arg, REPLAY_SEEK_STEP);
+				break;
+		}
+	}
+
 	return false;
 }
 
-static void replay_input(void) {
+static void replay_input(StageFrameState *fstate) {
 	ReplayStage *s = global.replay_stage;
-	int i;
 
 	events_poll((EventHandler[]){
-		{ .proc = stage_input_handler_replay },
+		{ .proc = stage_input_handler_replay, .arg = fstate },
 		{NULL}
 	}, EFLAG_GAME);
 
-	for(i = s->playpos; i < s->numevents; ++i) {
-		ReplayEvent *e = s->events + i;
-
+	for(const ReplayEvent *e; (e = replay_stage_peek_event(s)); replay_stage_next_event(s)) {
 		if(e->frame != global.frames)
 			break;
 
@@ -440,7 +512,6 @@ static void replay_input(void) {
 		}
 	}
 
-	s->playpos = i;
 	player_applymovement(&global.plr);
 }
 
@@ -454,14 +525,26 @@ static void stage_input(void) {
 }
 
 static void stage_logic(void) {
+	PROFILE_ZONE("stage_logic");
+	hrtime_t lap = bench_frame_begin();
+
 	player_logic(&global.plr);
+	bench_lap(BENCH_ZONE_PLAYER, &lap);
 
 	process_boss(&global.boss);
+	bench_lap(BENCH_ZONE_BOSS, &lap);
 	process_enemies(&global.enemies);
+	bench_lap(BENCH_ZONE_ENEMIES, &lap);
+	ent_grid_rebuild();
 	process_projectiles(&global.projs, true);
+	ent_grid_invalidate();
+	bench_lap(BENCH_ZONE_PROJECTILES, &lap);
 	process_items();
+	bench_lap(BENCH_ZONE_ITEMS, &lap);
 	process_lasers();
+	bench_lap(BENCH_ZONE_LASERS, &lap);
 	process_projectiles(&global.particles, false);
+	bench_lap(BENCH_ZONE_PARTICLES, &lap);
 	process_dialog(&global.dialog);
 
 	update_sounds();
@@ -473,12 +556,13 @@ static void stage_logic(void) {
 	}
 
 	if(global.replaymode == REPLAY_PLAY &&
-		global.frames == global.replay_stage->events[global.replay_stage->numevents-1].frame - FADE_TIME &&
+		global.frames == replay_stage_final_frame(global.replay_stage) - FADE_TIME &&
 		global.gameover != GAMEOVER_TRANSITIONING) {
 		stage_finish(GAMEOVER_DEFEAT);
 	}
 
 	stagetext_update();
+	bench_frame_end();
 }
 
 void stage_clear_hazards_predicate(bool (*predicate)(EntityInterface *ent, void *arg), void *arg, ClearHazardsFlags flags) {
@@ -671,14 +755,6 @@ bool stage_is_cleared(void) {
 	return global.gameover == GAMEOVER_SCORESCREEN || global.gameover == GAMEOVER_TRANSITIONING;
 }
 
-typedef struct StageFrameState {
-	StageInfo *stage;
-	int transition_delay;
-	uint16_t last_replay_fps;
-	CallChain cc;
-	int logic_calls;
-} StageFrameState;
-
 static void stage_update_fps(StageFrameState *fstate) {
 	if(global.replaymode == REPLAY_RECORD) {
 		uint16_t replay_fps = (uint16_t)rint(global.fps.logic.fps);
@@ -720,10 +796,105 @@ static void stage_give_clear_bonus(const StageInfo *stage, StageClearBonus *bonu
 	player_add_points(&global.plr, bonus->total, global.plr.pos);
 }
 
+static LogicFrameAction stage_logic_frame(void *arg);
+
+// Runs the logic of the frames before 'frame' without drawing anything.
+static void stage_fast_forward(StageFrameState *fstate, int frame) {
+	assert(!fstate->seek.fast_forwarding);
+	fstate->seek.fast_forwarding = true;
+
+	while(global.frames < frame && global.gameover <= 0) {
+		stage_logic_frame(fstate);
+	}
+
+	fstate->seek.fast_forwarding = false;
+}
+
+static void stage_replay_seek(StageFrameState *fstate, int frame) {
+	if(frame < global.frames) {
+		GameSnapshot *snap = snapshot_ring_find(frame);
+
+		if(!snap) {
+			log_warn("Can't seek back to frame %i: no snapshots that old", frame);
+			return;
+		}
+
+		snapshot_ring_restore(snap);
+	}
+
+	log_debug("Seeking from frame %i to %i", global.frames, frame);
+	stage_fast_forward(fstate, frame);
+}
+
+/*
+ * Restores the previous snapshot and simulates up to the one just taken, then compares
+ * the two. Together with the desync checks of the replay, which run again along the
+ * way, this validates that snapshots capture everything the simulation depends on.
+ */
+static void stage_verify_snapshot(StageFrameState *fstate, GameSnapshot *snap) {
+	int frame = snapshot_frame(snap);
+	uint64_t expected = snapshot_checksum(snap);
+	GameSnapshot *prev = snapshot_ring_find(frame - 1);
+
+	if(!prev) {
+		return;
+	}
+
+	int prev_frame = snapshot_frame(prev);
+	snapshot_ring_restore(prev);
+	stage_fast_forward(fstate, frame);
+
+	if(global.frames != frame || !(snap = snapshot_ring_update())) {
+		return;
+	}
+
+	if(snapshot_checksum(snap) != expected) {
+		log_warn("Frame %d: snapshot round trip from frame %d diverged! 0x%016"PRIx64" != 0x%016"PRIx64,
+			frame, prev_frame, snapshot_checksum(snap), expected
+		);
+		replay_stage_desync(global.replay_stage, frame);
+	} else if(global.is_replay_verification) {
+		log_info("Frame %d: snapshot round trip from frame %d OK", frame, prev_frame);
+	} else {
+		log_debug("Frame %d: snapshot round trip from frame %d OK", frame, prev_frame);
+	}
+}
+
+static void stage_replay_update_snapshots(StageFrameState *fstate) {
+	if(global.gameover == GAMEOVER_TRANSITIONING) {
+		// The transition itself is not part of the snapshots
+		return;
+	}
+
+	if(fstate->seek.fast_forwarding) {
+		snapshot_ring_update();
+		return;
+	}
+
+	if(fstate->seek.pending) {
+		fstate->seek.pending = false;
+		stage_replay_seek(fstate, fstate->seek.target);
+	}
+
+	GameSnapshot *snap = snapshot_ring_update();
+
+	if(snap && fstate->seek.verify) {
+		stage_verify_snapshot(fstate, snap);
+	}
+}
+
 static LogicFrameAction stage_logic_frame(void *arg) {
 	StageFrameState *fstate = arg;
 	StageInfo *stage = fstate->stage;
 
+	if(global.replaymode == REPLAY_PLAY) {
+		stage_replay_update_snapshots(fstate);
+
+		if(global.gameover > 0) {
+			return LFRAME_STOP;
+		}
+	}
+
 	++fstate->logic_calls;
 
 	stage_update_fps(fstate);
@@ -740,7 +911,11 @@ static LogicFrameAction stage_logic_frame(void *arg) {
 		}
 	}
 
-	((global.replaymode == REPLAY_PLAY) ? replay_input : stage_input)();
+	if(global.replaymode == REPLAY_PLAY) {
+		replay_input(fstate);
+	} else {
+		stage_input();
+	}
 
 	if(global.gameover != GAMEOVER_TRANSITIONING) {
 		if((!global.boss || boss_is_fleeing(global.boss)) && !global.dialog) {
@@ -761,6 +936,12 @@ static LogicFrameAction stage_logic_frame(void *arg) {
 	}
 
 	replay_stage_check_desync(global.replay_stage, global.frames, (tsrand() ^ global.plr.points) & 0xFFFF, global.replaymode);
+
+	if(global.gameover == GAMEOVER_ABORT) {
+		// replay verification failed
+		return LFRAME_STOP;
+	}
+
 	stage_logic();
 
 	if(fstate->transition_delay) {
@@ -827,15 +1008,17 @@ void stage_enter(StageInfo *stage, CallChain next) {
 
 	ent_init();
 	stage_objpools_alloc();
+	preload_plan_begin(stage->title);
 	stage_preload();
 	stage_draw_init();
+	preload_plan_end(NULL);
 
 	tsrand_switch(&global.rand_game);
 	stage_start(stage);
 
 	if(global.replaymode == REPLAY_RECORD) {
 		uint64_t start_time = (uint64_t)time(0);
-		uint64_t seed = makeseed();
+		uint64_t seed = global.is_benchmark ? BENCH_RNG_SEED : makeseed();
 		tsrand_seed_p(&global.rand_game, seed);
 
 		global.replay_stage = replay_create_stage(&global.replay, stage, start_time, seed, global.diff, &global.plr);
@@ -844,6 +1027,11 @@ void stage_enter(StageInfo *stage, CallChain next) {
 		player_init(&global.plr);
 		replay_stage_sync_player_state(global.replay_stage, &global.plr);
 
+		if(global.is_benchmark) {
+			// nobody's at the controls
+			global.plr.iddqd = true;
+		}
+
 		log_debug("Start time: %"PRIu64, start_time);
 		log_debug("Random seed: 0x%"PRIx64, seed);
 
@@ -871,7 +1059,7 @@ void stage_enter(StageInfo *stage, CallChain next) {
 		global.diff = stg->diff;
 		player_init(&global.plr);
 		replay_stage_sync_player_state(stg, &global.plr);
-		stg->playpos = 0;
+		replay_stage_rewind(stg);
 	}
 
 	stage->procs->begin();
@@ -884,13 +1072,36 @@ void stage_enter(StageInfo *stage, CallChain next) {
 	StageFrameState *fstate = calloc(1 , sizeof(*fstate));
 	fstate->stage = stage;
 	fstate->cc = next;
+	snapshot_register_section("stage transition", &fstate->transition_delay, sizeof(fstate->transition_delay));
+
+	if(global.replaymode == REPLAY_PLAY) {
+		// Only the interactive viewer can seek; headless runs would just pay for the snapshots.
+		int interval = env_get("TAISEI_REPLAY_SNAPSHOT_INTERVAL", global.is_headless ? 0 : FPS * 5);
 
+		if(interval > 0) {
+			snapshot_ring_init(interval, imax(1, env_get("TAISEI_REPLAY_SNAPSHOTS", 60)));
+			fstate->seek.verify = env_get("TAISEI_REPLAY_SNAPSHOT_VERIFY", false);
+		}
+	}
+
+	fstate->start_time = time_get();
 	eventloop_enter(fstate, stage_logic_frame, stage_render_frame, stage_end_loop, FPS);
 }
 
 void stage_end_loop(void* ctx) {
 	StageFrameState *s = ctx;
 
+	if(global.is_headless) {
+		// Simulation throughput, without the time spent loading the stage
+		double seconds = (time_get() - s->start_time) / (double)HRTIME_RESOLUTION;
+		log_info("%s: %i ticks in %.3f s (%.0f ticks per second)",
+			s->stage->title, s->logic_calls, seconds, s->logic_calls / fmax(seconds, 1e-9)
+		);
+	}
+
+	snapshot_ring_shutdown();
+	snapshot_unregister_section(&s->transition_delay);
+
 	if(global.replaymode == REPLAY_RECORD) {
 		replay_stage_event(global.replay_stage, global.frames, EV_OVER, 0);
 		global.replay_stage->plr_points_final = global.plr.points;
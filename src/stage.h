@@ -117,6 +117,7 @@ StageProgress* stage_get_progress(uint16_t id, Difficulty diff, bool allocate);
 StageProgress* stage_get_progress_from_info(StageInfo *stage, Difficulty diff, bool allocate);
 
 void stage_init_array(void);
+void stage_add_stress_tests(void);
 void stage_free_array(void);
 
 void stage_enter(StageInfo *stage, CallChain next);
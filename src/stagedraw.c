@@ -14,6 +14,7 @@
 #include "video.h"
 #include "resource/postprocess.h"
 #include "entity.h"
+#include "profiler.h"
 
 #ifdef DEBUG
 	#define GRAPHS_DEFAULT 1
@@ -305,7 +306,7 @@ static void stage_draw_destroy_framebuffers(void) {
 	}
 }
 
-void stage_draw_init(void) {
+static void stage_draw_load_resources(void) {
 	preload_resources(RES_POSTPROCESS, RESF_OPTIONAL,
 		"viewport",
 	NULL);
@@ -350,9 +351,6 @@ void stage_draw_init(void) {
 		"monosmall",
 	NULL);
 
-	stagedraw.framerate_graphs = env_get("TAISEI_FRAMERATE_GRAPHS", GRAPHS_DEFAULT);
-	stagedraw.objpool_stats = env_get("TAISEI_OBJPOOL_STATS", OBJPOOLSTATS_DEFAULT);
-
 	if(stagedraw.framerate_graphs) {
 		preload_resources(RES_SHADER_PROGRAM, RESF_PERMANENT,
 			"graph",
@@ -378,6 +376,16 @@ void stage_draw_init(void) {
 	stagedraw.dummy.w = 1;
 	stagedraw.dummy.h = 1;
 	#endif
+}
+
+void stage_draw_init(void) {
+	stagedraw.framerate_graphs = env_get("TAISEI_FRAMERATE_GRAPHS", GRAPHS_DEFAULT);
+	stagedraw.objpool_stats = env_get("TAISEI_OBJPOOL_STATS", OBJPOOLSTATS_DEFAULT);
+
+	// In logic-only mode, none of these would ever be used.
+	if(!global.is_logic_only) {
+		stage_draw_load_resources();
+	}
 
 	stage_draw_setup_framebuffers();
 
@@ -390,6 +398,7 @@ void stage_draw_init(void) {
 }
 
 void stage_draw_shutdown(void) {
+	r_stage_time(0);
 	events_unregister_handler(stage_draw_event);
 	stage_draw_destroy_framebuffers();
 }
@@ -660,6 +669,13 @@ static bool powersurge_draw_predicate(EntityInterface *ent) {
 }
 
 static bool draw_powersurge_effect(Framebuffer *target_fb, BlendMode blend) {
+	static UniformCache u_blur_resolution = UNIFORM_CACHE("blur_resolution");
+	static UniformCache u_blur_direction = UNIFORM_CACHE("blur_direction");
+	static UniformCache u_fade = UNIFORM_CACHE("fade");
+	static UniformCache u_shotlayer = UNIFORM_CACHE("shotlayer");
+	static UniformCache u_flowlayer = UNIFORM_CACHE("flowlayer");
+	static UniformCache u_time = UNIFORM_CACHE("time");
+
 	r_state_push();
 	r_blend(BLEND_NONE);
 	r_disable(RCAP_DEPTH_TEST);
@@ -676,24 +692,24 @@ static bool draw_powersurge_effect(Framebuffer *target_fb, BlendMode blend) {
 	// TODO: Add heuristic to not run the effect if the buffer can be reasonably assumed to be empty.
 
 	r_shader("powersurge_feedback");
-	r_uniform_vec2("blur_resolution", 0.5*VIEWPORT_W, 0.5*VIEWPORT_H);
+	r_uniform_vec2(r_uniform_cached(&u_blur_resolution), 0.5*VIEWPORT_W, 0.5*VIEWPORT_H);
 
 	r_framebuffer(stagedraw.powersurge_fbpair.back);
-	r_uniform_vec2("blur_direction", 1, 0);
-	r_uniform_vec4("fade", 1, 1, 1, 1);
+	r_uniform_vec2(r_uniform_cached(&u_blur_direction), 1, 0);
+	r_uniform_vec4(r_uniform_cached(&u_fade), 1, 1, 1, 1);
 	draw_framebuffer_tex(stagedraw.powersurge_fbpair.front, VIEWPORT_W, VIEWPORT_H);
 	fbpair_swap(&stagedraw.powersurge_fbpair);
 
 	r_framebuffer(stagedraw.powersurge_fbpair.back);
-	r_uniform_vec2("blur_direction", 0, 1);
-	r_uniform_vec4("fade", 0.9, 0.9, 0.9, 0.9);
+	r_uniform_vec2(r_uniform_cached(&u_blur_direction), 0, 1);
+	r_uniform_vec4(r_uniform_cached(&u_fade), 0.9, 0.9, 0.9, 0.9);
 	draw_framebuffer_tex(stagedraw.powersurge_fbpair.front, VIEWPORT_W, VIEWPORT_H);
 
 	r_framebuffer(target_fb);
 	r_shader("powersurge_effect");
-	r_uniform_sampler("shotlayer", r_framebuffer_get_attachment(stagedraw.powersurge_fbpair.back, FRAMEBUFFER_ATTACH_COLOR0));
-	r_uniform_sampler("flowlayer", "powersurge_flow");
-	r_uniform_float("time", global.frames/60.0);
+	r_uniform_sampler(r_uniform_cached(&u_shotlayer), r_framebuffer_get_attachment(stagedraw.powersurge_fbpair.back, FRAMEBUFFER_ATTACH_COLOR0));
+	r_uniform_sampler(r_uniform_cached(&u_flowlayer), "powersurge_flow");
+	r_uniform_float(r_uniform_cached(&u_time), global.frames/60.0);
 	r_blend(blend);
 	r_cull(CULL_BACK);
 	r_mat_push();
@@ -709,6 +725,13 @@ static bool draw_powersurge_effect(Framebuffer *target_fb, BlendMode blend) {
 }
 
 static bool boss_distortion_rule(Framebuffer *fb) {
+	static UniformCache u_blur_orig = UNIFORM_CACHE("blur_orig");
+	static UniformCache u_fix_orig = UNIFORM_CACHE("fix_orig");
+	static UniformCache u_blur_rad = UNIFORM_CACHE("blur_rad");
+	static UniformCache u_rad = UNIFORM_CACHE("rad");
+	static UniformCache u_ratio = UNIFORM_CACHE("ratio");
+	static UniformCache u_color = UNIFORM_CACHE("color");
+
 	if(global.boss == NULL) {
 		return false;
 	}
@@ -721,12 +744,12 @@ static bool boss_distortion_rule(Framebuffer *fb) {
 	complex pos = fpos + 15*cexp(I*global.frames/4.5);
 
 	r_shader("boss_zoom");
-	r_uniform_vec2("blur_orig", creal(pos)  / VIEWPORT_W,  1-cimag(pos)  / VIEWPORT_H);
-	r_uniform_vec2("fix_orig",  creal(fpos) / VIEWPORT_W,  1-cimag(fpos) / VIEWPORT_H);
-	r_uniform_float("blur_rad", 1.5*(0.2+0.025*sin(global.frames/15.0)));
-	r_uniform_float("rad", 0.24);
-	r_uniform_float("ratio", (float)VIEWPORT_H/VIEWPORT_W);
-	r_uniform_vec4_rgba("color", &global.boss->zoomcolor);
+	r_uniform_vec2(r_uniform_cached(&u_blur_orig), creal(pos)  / VIEWPORT_W,  1-cimag(pos)  / VIEWPORT_H);
+	r_uniform_vec2(r_uniform_cached(&u_fix_orig),  creal(fpos) / VIEWPORT_W,  1-cimag(fpos) / VIEWPORT_H);
+	r_uniform_float(r_uniform_cached(&u_blur_rad), 1.5*(0.2+0.025*sin(global.frames/15.0)));
+	r_uniform_float(r_uniform_cached(&u_rad), 0.24);
+	r_uniform_float(r_uniform_cached(&u_ratio), (float)VIEWPORT_H/VIEWPORT_W);
+	r_uniform_vec4_rgba(r_uniform_cached(&u_color), &global.boss->zoomcolor);
 	draw_framebuffer_tex(fb, VIEWPORT_W, VIEWPORT_H);
 
 	r_state_pop();
@@ -842,6 +865,7 @@ static void apply_bg_shaders(ShaderRule *shaderrules, FBPair *fbos) {
 }
 
 static void stage_render_bg(StageInfo *stage) {
+	PROFILE_ZONE("stage_render_bg");
 	FBPair *background = stage_get_fbpair(FBPAIR_BG);
 
 	r_framebuffer(background->back);
@@ -896,6 +920,7 @@ static bool stage_draw_predicate(EntityInterface *ent) {
 }
 
 static void stage_draw_objects(void) {
+	PROFILE_ZONE("stage_draw_objects");
 	r_shader("sprite_default");
 
 	if(global.boss) {
@@ -917,6 +942,7 @@ static void stage_draw_objects(void) {
 }
 
 void stage_draw_overlay(void) {
+	PROFILE_ZONE("stage_draw_overlay");
 	r_state_push();
 	r_shader("sprite_default");
 	r_blend(BLEND_PREMUL_ALPHA);
@@ -939,9 +965,13 @@ void stage_draw_overlay(void) {
 }
 
 static void postprocess_prepare(Framebuffer *fb, ShaderProgram *s) {
-	r_uniform_int("frames", global.frames);
-	r_uniform_vec2("viewport", VIEWPORT_W, VIEWPORT_H);
-	r_uniform_vec2("player", creal(global.plr.pos), VIEWPORT_H - cimag(global.plr.pos));
+	static UniformCache u_frames = UNIFORM_CACHE("frames");
+	static UniformCache u_viewport = UNIFORM_CACHE("viewport");
+	static UniformCache u_player = UNIFORM_CACHE("player");
+
+	r_uniform_int(r_shader_uniform_cached(s, &u_frames), global.frames);
+	r_uniform_vec2(r_shader_uniform_cached(s, &u_viewport), VIEWPORT_W, VIEWPORT_H);
+	r_uniform_vec2(r_shader_uniform_cached(s, &u_player), creal(global.plr.pos), VIEWPORT_H - cimag(global.plr.pos));
 }
 
 static inline void begin_viewport_shake(void) {
@@ -1008,9 +1038,11 @@ void stage_draw_end_noshake(void) {
 }
 
 void stage_draw_viewport(void) {
+	static UniformCache u_tex = UNIFORM_CACHE("tex");
+
 	FloatRect dest_vp;
 	r_framebuffer_viewport_current(r_framebuffer_current(), &dest_vp);
-	r_uniform_sampler("tex", r_framebuffer_get_attachment(stagedraw.fb_pairs[FBPAIR_FG].front, FRAMEBUFFER_ATTACH_COLOR0));
+	r_uniform_sampler(r_uniform_cached(&u_tex), r_framebuffer_get_attachment(stagedraw.fb_pairs[FBPAIR_FG].front, FRAMEBUFFER_ATTACH_COLOR0));
 
 	// CAUTION: Very intricate pixel perfect scaling that will ruin your day.
 	float facw = dest_vp.w / SCREEN_W;
@@ -1028,6 +1060,8 @@ void stage_draw_viewport(void) {
 }
 
 void stage_draw_scene(StageInfo *stage) {
+	PROFILE_ZONE("stage_draw_scene");
+
 #ifdef DEBUG
 	bool key_nobg = gamekeypressed(KEY_NOBACKGROUND);
 #else
@@ -1037,10 +1071,14 @@ void stage_draw_scene(StageInfo *stage) {
 	FBPair *background = stage_get_fbpair(FBPAIR_BG);
 	FBPair *foreground = stage_get_fbpair(FBPAIR_FG);
 
+	r_stage_time(global.frames / (float)FPS);
+
 	bool draw_bg = !config_get_int(CONFIG_NO_STAGEBG) && !key_nobg;
 
 	if(draw_bg) {
+		r_gpu_timer_begin("background");
 		stage_render_bg(stage);
+		r_gpu_timer_end();
 	}
 
 	// prepare for 2D rendering into the game viewport framebuffer
@@ -1071,7 +1109,9 @@ void stage_draw_scene(StageInfo *stage) {
 	}
 
 	// draw the 2D objects
+	r_gpu_timer_begin("objects");
 	stage_draw_objects();
+	r_gpu_timer_end();
 
 	end_viewport_shake();
 
@@ -1083,6 +1123,9 @@ void stage_draw_scene(StageInfo *stage) {
 	fbpair_swap(foreground);
 	r_blend(BLEND_NONE);
 
+	PROFILE_BEGIN(pz_pp, "stage_postprocess");
+	r_gpu_timer_begin("stage postprocess");
+
 	// stage postprocessing
 	apply_shader_rules(global.stage->procs->postprocess_rules, foreground);
 
@@ -1092,6 +1135,8 @@ void stage_draw_scene(StageInfo *stage) {
 		apply_shader_rules(rules, foreground);
 	}
 
+	r_gpu_timer_end();
+
 	// custom postprocessing
 	postprocess(
 		stagedraw.viewport_pp,
@@ -1102,6 +1147,8 @@ void stage_draw_scene(StageInfo *stage) {
 		VIEWPORT_H
 	);
 
+	PROFILE_END(pz_pp);
+
 	// prepare for 2D rendering into the main framebuffer (actual screen)
 	r_framebuffer(NULL);
 	set_ortho(SCREEN_W, SCREEN_H);
@@ -1110,7 +1157,9 @@ void stage_draw_scene(StageInfo *stage) {
 	stage_draw_viewport();
 
 	// draw HUD
+	r_gpu_timer_begin("hud");
 	stage_draw_hud();
+	r_gpu_timer_end();
 }
 
 #define HUD_X_PADDING 16
@@ -1221,10 +1270,14 @@ static void stage_draw_hud_objpool_stats(float x, float y, float width) {
 	r_shader("text_default");
 	for(ObjectPool **pool = &stage_object_pools.first; pool <= last; ++pool) {
 		ObjectPoolStats stats;
-		char buf[32];
+		char buf[48];
 		objpool_get_stats(*pool, &stats);
 
-		snprintf(buf, sizeof(buf), "%zu | %5zu", stats.usage, stats.peak_usage);
+		if(stats.reclaimed_bytes) {
+			snprintf(buf, sizeof(buf), "%zuK | %zu | %5zu", stats.reclaimed_bytes / 1024, stats.usage, stats.peak_usage);
+		} else {
+			snprintf(buf, sizeof(buf), "%zu | %5zu", stats.usage, stats.peak_usage);
+		}
 		// draw_text(ALIGN_LEFT  | AL_Flag_NoAdjust, (int)x,           (int)y, stats.tag, font);
 		// draw_text(ALIGN_RIGHT | AL_Flag_NoAdjust, (int)(x + width), (int)y, buf,       font);
 		// y += stringheight(buf, font) * 1.1;
@@ -1243,6 +1296,109 @@ static void stage_draw_hud_objpool_stats(float x, float y, float width) {
 
 		y += font_get_lineskip(font);
 	}
+
+	SpriteBatchStats batch_stats;
+	char buf[48];
+	r_sprite_batch_stats(&batch_stats);
+	snprintf(buf, sizeof(buf), "%u | %5u", batch_stats.flushes, batch_stats.sprites);
+
+	text_draw("Sprite batches", &(TextParams) {
+		.pos = { x, y },
+		.font_ptr = font,
+		.align = ALIGN_LEFT,
+	});
+
+	text_draw(buf, &(TextParams) {
+		.pos = { x + width, y },
+		.font_ptr = font,
+		.align = ALIGN_RIGHT,
+	});
+
+	y += font_get_lineskip(font);
+
+	RendererStateStats state_stats;
+	r_state_stats(&state_stats);
+	snprintf(buf, sizeof(buf), "%u | %5u", state_stats.changes, state_stats.avoided);
+
+	text_draw("State changes", &(TextParams) {
+		.pos = { x, y },
+		.font_ptr = font,
+		.align = ALIGN_LEFT,
+	});
+
+	text_draw(buf, &(TextParams) {
+		.pos = { x + width, y },
+		.font_ptr = font,
+		.align = ALIGN_RIGHT,
+	});
+
+	y += font_get_lineskip(font);
+
+	TextureUploadStats upload_stats;
+	r_texture_upload_stats(&upload_stats);
+	snprintf(buf, sizeof(buf), "%zuK %.2fms | %zuK | %u",
+		upload_stats.frame_bytes / 1024,
+		upload_stats.frame_time / (double)(HRTIME_RESOLUTION / 1000),
+		upload_stats.pending_bytes / 1024,
+		upload_stats.hitches
+	);
+
+	text_draw("Tex uploads", &(TextParams) {
+		.pos = { x, y },
+		.font_ptr = font,
+		.align = ALIGN_LEFT,
+	});
+
+	text_draw(buf, &(TextParams) {
+		.pos = { x + width, y },
+		.font_ptr = font,
+		.align = ALIGN_RIGHT,
+	});
+
+	y += font_get_lineskip(font);
+
+	GPUTimerStats gpu_stats;
+	r_gpu_timer_stats(&gpu_stats);
+
+	if(gpu_stats.available) {
+		hrtime_t gpu_total = 0;
+
+		for(uint i = 0; i < gpu_stats.num_passes; ++i) {
+			gpu_total += gpu_stats.passes[i].time;
+		}
+
+		snprintf(buf, sizeof(buf), "%.2fms | %u", gpu_total / (double)(HRTIME_RESOLUTION / 1000), gpu_stats.latency);
+
+		text_draw("GPU passes", &(TextParams) {
+			.pos = { x, y },
+			.font_ptr = font,
+			.align = ALIGN_LEFT,
+		});
+
+		text_draw(buf, &(TextParams) {
+			.pos = { x + width, y },
+			.font_ptr = font,
+			.align = ALIGN_RIGHT,
+		});
+
+		for(uint i = 0; i < gpu_stats.num_passes; ++i) {
+			y += font_get_lineskip(font);
+			snprintf(buf, sizeof(buf), "%.2fms", gpu_stats.passes[i].time / (double)(HRTIME_RESOLUTION / 1000));
+
+			text_draw(gpu_stats.passes[i].name, &(TextParams) {
+				.pos = { x + 8, y },
+				.font_ptr = font,
+				.align = ALIGN_LEFT,
+			});
+
+			text_draw(buf, &(TextParams) {
+				.pos = { x + width, y },
+				.font_ptr = font,
+				.align = ALIGN_RIGHT,
+			});
+		}
+	}
+
 	r_shader_ptr(sh_prev);
 }
 
@@ -1639,6 +1795,7 @@ static void stage_draw_framerate_graphs(float x, float y, float w, float h) {
 }
 
 void stage_draw_hud(void) {
+	PROFILE_ZONE("stage_draw_hud");
 	// Background
 	r_mat_push();
 	r_mat_translate(SCREEN_W*0.5, SCREEN_H*0.5, 0);
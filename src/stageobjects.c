@@ -22,6 +22,14 @@
 #define MAX_lasers                  64
 #define MAX_stagetext               1024
 
+// Pools that overflow grow by this many objects at a time. Smaller chunks are more
+// likely to become empty again after a burst, so that they can be reclaimed.
+#define CHUNK_projectiles           (MAX_projectiles / 4)
+#define CHUNK_items                 (MAX_items / 4)
+#define CHUNK_enemies               MAX_enemies
+#define CHUNK_lasers                MAX_lasers
+#define CHUNK_stagetext             (MAX_stagetext / 4)
+
 #define OBJECT_POOLS \
 	OBJECT_POOL(Projectile, projectiles) \
 	OBJECT_POOL(Item, items) \
@@ -30,6 +38,7 @@
 	OBJECT_POOL(StageText, stagetext) \
 
 StageObjectPools stage_object_pools;
+static bool hold_extents;
 
 void stage_objpools_alloc(void) {
 	stage_object_pools = (StageObjectPools){
@@ -39,6 +48,38 @@ void stage_objpools_alloc(void) {
 		OBJECT_POOLS
 		#undef OBJECT_POOL
 	};
+
+	#define OBJECT_POOL(type,field) \
+		objpool_set_growth(stage_object_pools.field, OBJPOOL_GROW_FIXED, CHUNK_##field);
+
+	OBJECT_POOLS
+	#undef OBJECT_POOL
+
+	// These churn the most; keep their live objects packed towards the start of the pool.
+	objpool_set_order(stage_object_pools.projectiles, OBJPOOL_LOWEST_FIRST);
+	objpool_set_order(stage_object_pools.items, OBJPOOL_LOWEST_FIRST);
+}
+
+void stage_objpools_reclaim(void) {
+	if(hold_extents) {
+		return;
+	}
+
+	size_t freed = 0;
+
+	#define OBJECT_POOL(type,field) \
+		freed += objpool_reclaim(stage_object_pools.field);
+
+	OBJECT_POOLS
+	#undef OBJECT_POOL
+
+	if(freed) {
+		log_debug("Reclaimed %zu bytes from stage object pools", freed);
+	}
+}
+
+void stage_objpools_hold_extents(bool hold) {
+	hold_extents = hold;
 }
 
 void stage_objpools_free(void) {
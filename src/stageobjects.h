@@ -32,4 +32,12 @@ extern StageObjectPools stage_object_pools;
 void stage_objpools_alloc(void);
 void stage_objpools_free(void);
 
+// Releases any pool extents that are completely unused. Called at the start of boss
+// attacks and when the system reports low memory.
+void stage_objpools_reclaim(void);
+
+// While held, stage_objpools_reclaim does nothing. Needed for as long as any pool snapshots may be
+// restored; see objpool_snapshot.
+void stage_objpools_hold_extents(bool hold);
+
 #endif // IGUARD_stageobjects_h
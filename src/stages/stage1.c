@@ -324,6 +324,8 @@ static void stage1_start(void) {
 	stage_3d_context.cx[2] = 700;
 	stage_3d_context.cv[1] = 4;
 
+	stage1_attack_state_register();
+
 	FBAttachmentConfig cfg = { 0 };
 	cfg.attachment = FRAMEBUFFER_ATTACH_COLOR0;
 	cfg.tex_params.filter.min = TEX_FILTER_LINEAR;
@@ -360,6 +362,7 @@ static void stage1_preload(void) {
 }
 
 static void stage1_end(void) {
+	stage1_attack_state_unregister();
 	free_stage3d(&stage_3d_context);
 }
 
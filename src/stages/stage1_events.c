@@ -10,6 +10,7 @@
 
 #include "stage1_events.h"
 #include "global.h"
+#include "snapshot.h"
 #include "stagetext.h"
 
 static Dialog *stage1_dialog_pre_boss(void) {
@@ -567,25 +568,27 @@ static int halation_orb(Projectile *p, int time) {
 	return 1;
 }
 
+// TODO: get rid of the "static" nonsense already! #ArgsForBossAttacks2017
+// tfw it's 2018 and still no args
+// tfw when you then add another static
+static struct {
+	complex center;
+	float rotation;
+	int cheater;
+} halation;
+
 void cirno_snow_halation(Boss *c, int time) {
 	int t = time % 300;
 	TIMER(&t);
 
-	// TODO: get rid of the "static" nonsense already! #ArgsForBossAttacks2017
-	// tfw it's 2018 and still no args
-	// tfw when you then add another static
-	static complex center;
-	static float rotation;
-	static int cheater;
-
 	if(time == EVENT_BIRTH)
-		cheater = 0;
+		halation.cheater = 0;
 
 	if(time < 0) {
 		return;
 	}
 
-	if(cheater >= 8) {
+	if(halation.cheater >= 8) {
 		GO_TO(c, global.plr.pos,0.05);
 		aniplayer_queue(&c->ani,"(9)",0);
 	} else {
@@ -593,8 +596,8 @@ void cirno_snow_halation(Boss *c, int time) {
 	}
 
 	AT(60) {
-		center = global.plr.pos;
-		rotation = (M_PI/2.0) * (1 + time / 300);
+		halation.center = global.plr.pos;
+		halation.rotation = (M_PI/2.0) * (1 + time / 300);
 		aniplayer_queue(&c->ani,"(9)",0);
 	}
 
@@ -611,11 +614,11 @@ void cirno_snow_halation(Boss *c, int time) {
 
 			PROJECTILE(
 				.proto = pp_plainball,
-				.pos = halation_calc_orb_pos(center, rotation, p, projs),
+				.pos = halation_calc_orb_pos(halation.center, halation.rotation, p, projs),
 				.color = &clr,
 				.rule = halation_orb,
 				.args = {
-					center, rotation, p + I * projs, halate_time
+					halation.center, halation.rotation, p + I * projs, halate_time
 				},
 				.max_viewport_dist = 200,
 				.flags = PFLAG_NOCLEAR | PFLAG_NOCOLLISION,
@@ -626,7 +629,7 @@ void cirno_snow_halation(Boss *c, int time) {
 	AT(100 + interval * projs/2) {
 		aniplayer_queue(&c->ani,"main",0);
 
-		if(cabs(global.plr.pos-center)>cabs(halation_calc_orb_pos(0,0,0,projs))) {
+		if(cabs(global.plr.pos-halation.center)>cabs(halation_calc_orb_pos(0,0,0,projs))) {
 			char *text[] = {
 				"",
 				"What are you doing??",
@@ -638,9 +641,9 @@ void cirno_snow_halation(Boss *c, int time) {
 				"You- You Idiootttt!",
 			};
 
-			if(cheater < sizeof(text)/sizeof(text[0])) {
-				stagetext_add(text[cheater], global.boss->pos+100*I, ALIGN_CENTER, get_font("standard"), RGB(1,1,1), 0, 100, 10, 20);
-				cheater++;
+			if(halation.cheater < sizeof(text)/sizeof(text[0])) {
+				stagetext_add(text[halation.cheater], global.boss->pos+100*I, ALIGN_CENTER, get_font("standard"), RGB(1,1,1), 0, 100, 10, 20);
+				halation.cheater++;
 			}
 		}
 	}
@@ -1365,3 +1368,11 @@ void stage1_events(void) {
 		stage_finish(GAMEOVER_SCORESCREEN);
 	}
 }
+
+void stage1_attack_state_register(void) {
+	snapshot_register_zeroed_section("stage1 snow halation", &halation, sizeof(halation));
+}
+
+void stage1_attack_state_unregister(void) {
+	snapshot_unregister_section(&halation);
+}
@@ -22,6 +22,8 @@ void cirno_crystal_blizzard(Boss*, int);
 void cirno_benchmark(Boss*, int);
 
 void stage1_events(void);
+void stage1_attack_state_register(void);
+void stage1_attack_state_unregister(void);
 Boss* stage1_spawn_cirno(complex pos);
 
 #endif // IGUARD_stages_stage1_events_h
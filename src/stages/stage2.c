@@ -181,6 +181,8 @@ static void stage2_start(void) {
 	add_model(&stage_3d_context, stage2_bg_grass_draw, stage2_bg_grass_pos);
 	add_model(&stage_3d_context, stage2_bg_grass_draw, stage2_bg_grass_pos2);
 	add_model(&stage_3d_context, stage2_bg_leaves_draw, stage2_bg_pos);
+
+	stage2_attack_state_register();
 }
 
 static void stage2_preload(void) {
@@ -211,6 +213,7 @@ static void stage2_preload(void) {
 }
 
 static void stage2_end(void) {
+	stage2_attack_state_unregister();
 	free_stage3d(&stage_3d_context);
 }
 
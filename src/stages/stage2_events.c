@@ -10,6 +10,7 @@
 
 #include "stage2_events.h"
 #include "global.h"
+#include "snapshot.h"
 #include "stage.h"
 #include "enemy.h"
 
@@ -547,12 +548,14 @@ void hina_bad_pick(Boss *h, int time) {
 
 #undef SLOTS
 
+static struct {
+	int dir;
+} wheel;
+
 void hina_wheel(Boss *h, int time) {
 	int t = time % 400;
 	TIMER(&t);
 
-	static int dir = 0;
-
 	if(time < 0)
 		return;
 
@@ -564,9 +567,9 @@ void hina_wheel(Boss *h, int time) {
 	if(time < 60) {
 		if(time == 0) {
 			if(global.diff > D_Normal) {
-				dir = 1 - 2 * (tsrand()%2);
+				wheel.dir = 1 - 2 * (tsrand()%2);
 			} else {
-				dir = 1;
+				wheel.dir = 1;
 			}
 		}
 
@@ -582,7 +585,7 @@ void hina_wheel(Boss *h, int time) {
 		float d = max(0, (int)global.diff - D_Normal);
 
 		for(i = 1; i < 6+d; i++) {
-			float a = dir * 2*M_PI/(5+d)*(i+(1 + 0.4 * d)*time/100.0+(1 + 0.2 * d)*frand()*time/1700.0);
+			float a = wheel.dir * 2*M_PI/(5+d)*(i+(1 + 0.4 * d)*time/100.0+(1 + 0.2 * d)*frand()*time/1700.0);
 			PROJECTILE(
 				.proto = pp_crystal,
 				.pos = h->pos,
@@ -691,13 +694,16 @@ static void hina_monty_slave_visual(Enemy *s, int time, bool render) {
 	r_shader("sprite_default");
 }
 
+static struct {
+	short slave_pos, bad_pos, good_pos, plr_pos;
+	complex targetpos;
+} monty;
+
 void hina_monty(Boss *h, int time) {
 	int t = time % 720;
 	TIMER(&t);
 
-	static short slave_pos, bad_pos, good_pos, plr_pos;
-	static int cwidth = VIEWPORT_W / 3.0;
-	static complex targetpos;
+	const int cwidth = VIEWPORT_W / 3.0;
 
 	if(time == EVENT_DEATH) {
 		enemy_kill_all(&global.enemies);
@@ -705,14 +711,14 @@ void hina_monty(Boss *h, int time) {
 	}
 
 	if(time < 0) {
-		targetpos = VIEWPORT_W/2.0 + VIEWPORT_H/2.0 * I;
+		monty.targetpos = VIEWPORT_W/2.0 + VIEWPORT_H/2.0 * I;
 		return;
 	}
 
 	AT(0) {
-		plr_pos = creal(global.plr.pos) / cwidth;
-		bad_pos = tsrand() % 3;
-		do good_pos = tsrand() % 3; while(good_pos == bad_pos);
+		monty.plr_pos = creal(global.plr.pos) / cwidth;
+		monty.bad_pos = tsrand() % 3;
+		do monty.good_pos = tsrand() % 3; while(monty.good_pos == monty.bad_pos);
 
 		play_sound("laser1");
 
@@ -726,10 +732,10 @@ void hina_monty(Boss *h, int time) {
 	}
 
 	AT(120) {
-		do slave_pos = tsrand() % 3; while(slave_pos == plr_pos || slave_pos == good_pos);
-		while(bad_pos == slave_pos || bad_pos == good_pos) bad_pos = tsrand() % 3;
+		do monty.slave_pos = tsrand() % 3; while(monty.slave_pos == monty.plr_pos || monty.slave_pos == monty.good_pos);
+		while(monty.bad_pos == monty.slave_pos || monty.bad_pos == monty.good_pos) monty.bad_pos = tsrand() % 3;
 
-		complex o = cwidth * (0.5 + slave_pos) + VIEWPORT_H/2.0*I - 200.0*I;
+		complex o = cwidth * (0.5 + monty.slave_pos) + VIEWPORT_H/2.0*I - 200.0*I;
 
 		play_sound("laser1");
 		create_laserline_ab(h->pos, o, 15, 30, 60, RGBA(1.0, 0.3, 0.3, 0.0));
@@ -739,11 +745,11 @@ void hina_monty(Boss *h, int time) {
 
 	AT(140) {
 		play_sound("shot_special1");
-		create_enemy4c(cwidth * (0.5 + slave_pos) + VIEWPORT_H/2.0*I - 200.0*I, ENEMY_IMMUNE, hina_monty_slave_visual, hina_monty_slave, 0, 0, 0, 1);
+		create_enemy4c(cwidth * (0.5 + monty.slave_pos) + VIEWPORT_H/2.0*I - 200.0*I, ENEMY_IMMUNE, hina_monty_slave_visual, hina_monty_slave, 0, 0, 0, 1);
 	}
 
 	AT(190) {
-		targetpos = cwidth * (0.5 + good_pos) + VIEWPORT_H/2.0*I - 200.0*I;
+		monty.targetpos = cwidth * (0.5 + monty.good_pos) + VIEWPORT_H/2.0*I - 200.0*I;
 	}
 
 	AT(240) {
@@ -757,7 +763,7 @@ void hina_monty(Boss *h, int time) {
 		float cnt = (2.0+global.diff) * 5;
 		for(int i = 0; i < cnt; i++) {
 			bool top = ((global.diff > D_Hard) && (_i % 2));
-			complex o = !top*VIEWPORT_H*I + cwidth*(bad_pos + i/(double)(cnt - 1));
+			complex o = !top*VIEWPORT_H*I + cwidth*(monty.bad_pos + i/(double)(cnt - 1));
 
 			PROJECTILE(
 				.proto = pp_ball,
@@ -821,14 +827,14 @@ void hina_monty(Boss *h, int time) {
 	}
 
 	FROM_TO(240, 390, 5) {
-		create_item(VIEWPORT_H*I + cwidth*(good_pos + frand()), -50.0*I, _i % 2 ? ITEM_POINTS : ITEM_POWER);
+		create_item(VIEWPORT_H*I + cwidth*(monty.good_pos + frand()), -50.0*I, _i % 2 ? ITEM_POINTS : ITEM_POWER);
 	}
 
 	AT(600) {
-		targetpos = cwidth * (0.5 + slave_pos) + VIEWPORT_H/2.0*I;
+		monty.targetpos = cwidth * (0.5 + monty.slave_pos) + VIEWPORT_H/2.0*I;
 	}
 
-	GO_TO(h, targetpos, 0.06);
+	GO_TO(h, monty.targetpos, 0.06);
 }
 
 void hina_spell_bg(Boss *h, int time) {
@@ -954,3 +960,13 @@ void stage2_events(void) {
 		stage_finish(GAMEOVER_SCORESCREEN);
 	}
 }
+
+void stage2_attack_state_register(void) {
+	snapshot_register_zeroed_section("stage2 wheel", &wheel, sizeof(wheel));
+	snapshot_register_zeroed_section("stage2 monty", &monty, sizeof(monty));
+}
+
+void stage2_attack_state_unregister(void) {
+	snapshot_unregister_section(&wheel);
+	snapshot_unregister_section(&monty);
+}
@@ -20,6 +20,8 @@ void hina_wheel(Boss*, int);
 void hina_monty(Boss*, int);
 
 void stage2_events(void);
+void stage2_attack_state_register(void);
+void stage2_attack_state_unregister(void);
 Boss* stage2_spawn_hina(complex pos);
 
 #endif // IGUARD_stages_stage2_events_h
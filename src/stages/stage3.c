@@ -14,6 +14,7 @@
 #include "global.h"
 #include "stage.h"
 #include "stageutils.h"
+#include "snapshot.h"
 
 /*
  *  See the definition of AttackInfo in boss.h for information on how to set up the idmaps.
@@ -157,6 +158,7 @@ static void stage3_start(void) {
 	stgstate.clr_b = 0.5;
 	stgstate.clr_mixfactor = 1.0;
 	stgstate.fog_brightness = 0.5;
+	snapshot_register_section("stage3 background", &stgstate, sizeof(stgstate));
 }
 
 static void stage3_preload(void) {
@@ -188,6 +190,7 @@ static void stage3_preload(void) {
 }
 
 static void stage3_end(void) {
+	snapshot_unregister_section(&stgstate);
 	free_stage3d(&stage_3d_context);
 }
 
@@ -15,6 +15,7 @@
 #include "stageutils.h"
 #include "global.h"
 #include "resource/model.h"
+#include "snapshot.h"
 
 /*
  *  See the definition of AttackInfo in boss.h for information on how to set up the idmaps.
@@ -159,6 +160,9 @@ static void stage5_start(void) {
 	stage_3d_context.crot[0] = 60;
 	stagedata.rotshift = 140;
 	stagedata.rad = 2800;
+	snapshot_register_section("stage5 background", &stagedata, sizeof(stagedata));
+
+	stage5_attack_state_register();
 }
 
 static void stage5_preload(void) {
@@ -195,6 +199,8 @@ static void stage5_preload(void) {
 }
 
 static void stage5_end(void) {
+	stage5_attack_state_unregister();
+	snapshot_unregister_section(&stagedata);
 	free_stage3d(&stage_3d_context);
 }
 
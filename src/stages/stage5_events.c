@@ -11,6 +11,7 @@
 #include "stage5_events.h"
 #include "stage5.h"
 #include "global.h"
+#include "snapshot.h"
 
 static Dialog *stage5_dialog_post_midboss(void) {
 	PlayerMode *pm = global.plr.mode;
@@ -632,15 +633,17 @@ static complex bolts2_laser(Laser *l, float t) {
 	return creal(l->args[0])+I*cimag(l->pos) + sign(cimag(l->args[0]-l->pos))*0.06*I*t*t + (20+4*diff)*sin(t*0.025*diff+creal(l->args[0]))*l->args[1];
 }
 
+// FIXME: ANOTHER one of these... get rid of this hack when attacks have proper state
+static struct {
+	bool flip_laser;
+} bolts2;
+
 static void iku_bolts2(Boss *b, int time) {
 	int t = time % 400;
 	TIMER(&t);
 
-	// FIXME: ANOTHER one of these... get rid of this hack when attacks have proper state
-	static bool flip_laser;
-
 	if(time == EVENT_BIRTH) {
-		flip_laser = true;
+		bolts2.flip_laser = true;
 	}
 
 	FROM_TO(0, 400, 2) {
@@ -648,10 +651,10 @@ static void iku_bolts2(Boss *b, int time) {
 	}
 
 	FROM_TO(0, 400, 60) {
-		flip_laser = !flip_laser;
-		aniplayer_queue(&b->ani, flip_laser ? "dashdown_left" : "dashdown_right", 1);
+		bolts2.flip_laser = !bolts2.flip_laser;
+		aniplayer_queue(&b->ani, bolts2.flip_laser ? "dashdown_left" : "dashdown_right", 1);
 		aniplayer_queue(&b->ani, "main", 0);
-		create_lasercurve3c(creal(global.plr.pos), 100, 200, RGBA(0.3, 1, 1, 0), bolts2_laser, global.plr.pos, flip_laser*2-1, global.diff);
+		create_lasercurve3c(creal(global.plr.pos), 100, 200, RGBA(0.3, 1, 1, 0), bolts2_laser, global.plr.pos, bolts2.flip_laser*2-1, global.diff);
 		play_sound_ex("laser1", 0, false);
 	}
 
@@ -1462,3 +1465,11 @@ void stage5_events(void) {
 		stage_finish(GAMEOVER_SCORESCREEN);
 	}
 }
+
+void stage5_attack_state_register(void) {
+	snapshot_register_zeroed_section("stage5 bolts2", &bolts2, sizeof(bolts2));
+}
+
+void stage5_attack_state_unregister(void) {
+	snapshot_unregister_section(&bolts2);
+}
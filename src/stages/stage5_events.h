@@ -21,6 +21,8 @@ void iku_induction(Boss*, int);
 void iku_extra(Boss*, int);
 
 void stage5_events(void);
+void stage5_attack_state_register(void);
+void stage5_attack_state_unregister(void);
 Boss* stage5_spawn_iku(complex pos);
 
 #endif // IGUARD_stages_stage5_events_h
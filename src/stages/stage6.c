@@ -16,6 +16,7 @@
 #include "global.h"
 #include "resource/model.h"
 #include "stagedraw.h"
+#include "snapshot.h"
 
 /*
  *  See the definition of AttackInfo in boss.h for information on how to set up the idmaps.
@@ -218,6 +219,8 @@ static void stage6_start(void) {
 
 	init_stage3d(&stage_3d_context, 128);
 	fall_over = 0;
+	snapshot_register_section("stage6 fall_over", &fall_over, sizeof(fall_over));
+	stage6_attack_state_register();
 
 	add_model(&stage_3d_context, stage6_skysphere_draw, stage6_skysphere_pos);
 	add_model(&stage_3d_context, stage6_towertop_draw, stage6_towertop_pos);
@@ -327,6 +330,8 @@ static void stage6_preload(void) {
 }
 
 static void stage6_end(void) {
+	snapshot_unregister_section(&fall_over);
+	stage6_attack_state_unregister();
 	free_stage3d(&stage_3d_context);
 }
 
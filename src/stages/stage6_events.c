@@ -11,6 +11,7 @@
 #include "stage6_events.h"
 #include "stage6.h"
 #include "global.h"
+#include "snapshot.h"
 #include "stagetext.h"
 #include "stagedraw.h"
 
@@ -1235,6 +1236,10 @@ static int broglie_charge(Projectile *p, int t) {
 	return ACTION_NONE;
 }
 
+static struct {
+	double aim_angle;
+} broglie;
+
 static int baryon_broglie(Enemy *e, int t) {
 	if(t < 0) {
 		return 1;
@@ -1276,11 +1281,9 @@ static int baryon_broglie(Enemy *e, int t) {
 	int cnt = 3;
 	int fire_delay = 120;
 
-	static double aim_angle;
-
 	AT(delay) {
 		elly_clap(global.boss,fire_delay);
-		aim_angle = carg(e->pos - global.boss->pos);
+		broglie.aim_angle = carg(e->pos - global.boss->pos);
 	}
 
 	FROM_TO(delay, delay + step * cnt - 1, step) {
@@ -1300,7 +1303,7 @@ static int baryon_broglie(Enemy *e, int t) {
 				hue
 			},
 			.flags = PFLAG_NOCLEAR,
-			.angle = (2*M_PI*_i)/cnt + aim_angle,
+			.angle = (2*M_PI*_i)/cnt + broglie.aim_angle,
 		);
 	}
 
@@ -3017,3 +3020,11 @@ void stage6_events(void) {
 		stage_finish(GAMEOVER_SCORESCREEN);
 	}
 }
+
+void stage6_attack_state_register(void) {
+	snapshot_register_zeroed_section("stage6 broglie", &broglie, sizeof(broglie));
+}
+
+void stage6_attack_state_unregister(void) {
+	snapshot_unregister_section(&broglie);
+}
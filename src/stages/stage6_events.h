@@ -33,6 +33,8 @@ void elly_intro(Boss*, int);
 void elly_spawn_baryons(complex pos);
 
 void stage6_events(void);
+void stage6_attack_state_register(void);
+void stage6_attack_state_unregister(void);
 Boss* stage6_spawn_elly(complex pos);
 
 void Scythe(Enemy *e, int t, bool render);
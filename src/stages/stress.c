@@ -0,0 +1,107 @@
+/*
+ * This software is licensed under the terms of the MIT-License
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2019, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2019, Andrei Alexeyev <akari@alienslab.net>.
+ */
+
+#include "taisei.h"
+
+#include "stress.h"
+#include "global.h"
+#include "laser.h"
+#include "item.h"
+
+// Arms of the spiral, each firing a bullet every frame. With the bullets taking about 5 seconds
+// to leave the screen, that's about 5000 of them alive at once.
+#define STRESS_SPIRAL_ARMS 16
+
+#define STRESS_LASERS_PER_WAVE 24
+#define STRESS_ITEMS_PER_FRAME 12
+
+static void stress_stub_proc(void) { }
+
+static void stress_finish(void) {
+	if(global.timer == STRESS_DURATION) {
+		stage_finish(GAMEOVER_WIN);
+	}
+}
+
+static void stage_stress_bullets_events(void) {
+	TIMER(&global.timer);
+
+	FROM_TO(0, STRESS_DURATION - FPS * 5, 1) {
+		complex origin = VIEWPORT_W/2 + VIEWPORT_H/3*I;
+
+		for(int i = 0; i < STRESS_SPIRAL_ARMS; ++i) {
+			complex dir = cexp(I*(_i * 0.05 + i * 2 * M_PI / STRESS_SPIRAL_ARMS));
+
+			PROJECTILE(
+				.proto = pp_rice,
+				.pos = origin,
+				.color = RGB(0.2, 0.4, 1.0),
+				.rule = linear,
+				.args = { 1.5 * dir },
+			);
+		}
+	}
+
+	stress_finish();
+}
+
+static void stage_stress_lasers_events(void) {
+	TIMER(&global.timer);
+
+	FROM_TO(0, STRESS_DURATION - FPS * 5, 20) {
+		complex origin = VIEWPORT_W/2 + VIEWPORT_H/4*I;
+
+		for(int i = 0; i < STRESS_LASERS_PER_WAVE; ++i) {
+			complex dir = cexp(I*(_i * 0.3 + i * 2 * M_PI / STRESS_LASERS_PER_WAVE));
+			create_lasercurve3c(origin, 40, 200, RGBA(1.0, 0.3, 0.1, 0), las_sine, 3 * dir, 20, 0.1);
+		}
+	}
+
+	stress_finish();
+}
+
+static void stage_stress_items_events(void) {
+	TIMER(&global.timer);
+
+	FROM_TO(0, STRESS_DURATION - FPS * 5, 1) {
+		complex pos = VIEWPORT_W * frand() + VIEWPORT_H/4*frand()*I;
+		spawn_items(pos, ITEM_POINTS, STRESS_ITEMS_PER_FRAME / 2, ITEM_POWER_MINI, STRESS_ITEMS_PER_FRAME / 2);
+	}
+
+	stress_finish();
+}
+
+StageProcs stage_stress_bullets_procs = {
+	.begin = stress_stub_proc,
+	.preload = stress_stub_proc,
+	.end = stress_stub_proc,
+	.draw = stress_stub_proc,
+	.update = stress_stub_proc,
+	.event = stage_stress_bullets_events,
+	.shader_rules = (ShaderRule[]) { NULL },
+};
+
+StageProcs stage_stress_lasers_procs = {
+	.begin = stress_stub_proc,
+	.preload = stress_stub_proc,
+	.end = stress_stub_proc,
+	.draw = stress_stub_proc,
+	.update = stress_stub_proc,
+	.event = stage_stress_lasers_events,
+	.shader_rules = (ShaderRule[]) { NULL },
+};
+
+StageProcs stage_stress_items_procs = {
+	.begin = stress_stub_proc,
+	.preload = stress_stub_proc,
+	.end = stress_stub_proc,
+	.draw = stress_stub_proc,
+	.update = stress_stub_proc,
+	.event = stage_stress_items_events,
+	.shader_rules = (ShaderRule[]) { NULL },
+};
@@ -0,0 +1,25 @@
+/*
+ * This software is licensed under the terms of the MIT-License
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2019, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2019, Andrei Alexeyev <akari@alienslab.net>.
+ */
+
+#ifndef IGUARD_stages_stress_h
+#define IGUARD_stages_stress_h
+
+#include "taisei.h"
+
+#include "stage.h"
+
+// Synthetic stages that hammer one subsystem each, for the benchmark (see bench.h).
+// They end by themselves after STRESS_DURATION frames.
+
+#define STRESS_DURATION (FPS * 60)
+
+extern StageProcs stage_stress_bullets_procs;
+extern StageProcs stage_stress_lasers_procs;
+extern StageProcs stage_stress_items_procs;
+
+#endif // IGUARD_stages_stress_h
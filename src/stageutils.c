@@ -12,6 +12,7 @@
 #include "global.h"
 #include "util/glm.h"
 #include "video.h"
+#include "snapshot.h"
 
 Stage3D stage_3d_context;
 
@@ -20,6 +21,9 @@ void init_stage3d(Stage3D *s, uint pos_buffer_size) {
 	s->projangle = 45;
 	s->pos_buffer_size = pos_buffer_size;
 	s->pos_buffer = calloc(s->pos_buffer_size, sizeof(vec3));
+
+	// The stages move the camera in their update procs
+	snapshot_register_section("stage3d camera", &s->cx, offsetof(Stage3D, projangle) - offsetof(Stage3D, cx));
 }
 
 void add_model(Stage3D *s, SegmentDrawRule draw, SegmentPositionRule pos) {
@@ -77,6 +81,7 @@ void draw_stage3d(Stage3D *s, float maxrange) {
 }
 
 void free_stage3d(Stage3D *s) {
+	snapshot_unregister_section(&s->cx);
 	free(s->models);
 	free(s->pos_buffer);
 }
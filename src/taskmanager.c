@@ -11,6 +11,7 @@
 #include "taskmanager.h"
 #include "list.h"
 #include "util.h"
+#include "profiler.h"
 
 struct TaskManager {
 	LIST_ANCHOR(Task) queue;
@@ -79,6 +80,8 @@ static int taskmgr_thread(void *arg) {
 		log_sdl_error(LOG_WARN, "SDL_SetThreadPriority");
 	}
 
+	profiler_set_thread_name("taskmgr");
+
 	bool running;
 	bool aborted;
 
@@ -121,7 +124,9 @@ static int taskmgr_thread(void *arg) {
 				task->status = TASK_RUNNING;
 
 				SDL_UnlockMutex(task->mutex);
+				PROFILE_BEGIN(pz, "task");
 				task->result = task->callback(task->userdata);
+				PROFILE_END(pz);
 				SDL_LockMutex(task->mutex);
 
 				assert(task->in_queue);
@@ -0,0 +1,207 @@
+/*
+ * This software is licensed under the terms of the MIT-License
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2019, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2019, Andrei Alexeyev <akari@alienslab.net>.
+ */
+
+#include "taisei.h"
+
+#include <stdio.h>
+
+#include "renderer/gl33/ring_space.h"
+
+/*
+ * Drives RingSpace the way the gl33 streaming rings do (see stream_ring_next_window in
+ * renderer/gl33/common_buffer.c), with a queue of fake fences standing in for the GPU.
+ */
+
+#define WINDOW_SIZE (184 * 2048)
+#define RING_WINDOWS 4
+#define MAX_FENCES 16
+#define MAX_RETRIES 64
+
+#define CHECK(cond) do { \
+	if(!(cond)) { \
+		fprintf(stderr, "%s:%i: check failed: %s\n", __FILE__, __LINE__, #cond); \
+		exit(1); \
+	} \
+} while(0)
+
+typedef struct TestRing {
+	RingSpace space;
+	uint64_t window;
+	size_t window_end;
+	uint64_t fences[MAX_FENCES];
+	uint num_fences;
+} TestRing;
+
+noreturn void _ts_assert_fail(const char *cond, const char *func, const char *file, int line, bool use_log) {
+	fprintf(stderr, "%s:%i: %s(): assertion `%s` failed\n", file, line, func, cond);
+	abort();
+}
+
+static void push_fence(TestRing *r, uint64_t pos) {
+	if(r->num_fences > 0 && r->fences[r->num_fences - 1] == pos) {
+		return;
+	}
+
+	CHECK(r->num_fences < MAX_FENCES);
+	r->fences[r->num_fences++] = pos;
+}
+
+// The GPU is always done by the time we wait for it.
+static void pop_fence(TestRing *r) {
+	CHECK(r->num_fences > 0);
+	ring_space_release(&r->space, r->fences[0]);
+	memmove(r->fences, r->fences + 1, --r->num_fences * sizeof(*r->fences));
+}
+
+static void ring_init(TestRing *r) {
+	memset(r, 0, sizeof(*r));
+	r->space.size = (uint64_t)WINDOW_SIZE * RING_WINDOWS;
+	r->space.head = WINDOW_SIZE;
+}
+
+static void next_window(TestRing *r) {
+	size_t written = (r->window_end + 63) & ~(size_t)63;
+	written = written < WINDOW_SIZE ? written : WINDOW_SIZE;
+
+	ring_space_unreserve(&r->space, r->window + written);
+
+	uint64_t start;
+	uint retries = 0;
+
+	while(!ring_space_reserve(&r->space, WINDOW_SIZE, &start)) {
+		// Each pop must free something, or this would never end.
+		CHECK(++retries < MAX_RETRIES);
+
+		if(r->num_fences == 0) {
+			push_fence(r, r->space.head);
+		}
+
+		pop_fence(r);
+	}
+
+	CHECK(ring_space_used(&r->space) <= r->space.size);
+	CHECK(ring_space_offset(&r->space, start) + WINDOW_SIZE <= r->space.size);
+	CHECK(start >= r->window + written);
+
+	r->window = start;
+	r->window_end = 0;
+}
+
+static void write(TestRing *r, size_t size) {
+	CHECK(r->window_end + size <= WINDOW_SIZE);
+	r->window_end += size;
+}
+
+static void end_frame(TestRing *r) {
+	if(r->window_end > 0) {
+		push_fence(r, r->window + r->window_end);
+	}
+}
+
+static void test_full_windows(void) {
+	TestRing r;
+	ring_init(&r);
+
+	// More full windows than fit into the ring, all in one frame.
+	for(int i = 0; i < 5; ++i) {
+		next_window(&r);
+		write(&r, WINDOW_SIZE);
+	}
+
+	end_frame(&r);
+}
+
+static void test_full_then_small(void) {
+	TestRing r;
+	ring_init(&r);
+
+	for(int frame = 0; frame < 10; ++frame) {
+		for(int i = 0; i < 3; ++i) {
+			next_window(&r);
+			write(&r, WINDOW_SIZE);
+		}
+
+		for(int i = 0; i < 100; ++i) {
+			next_window(&r);
+			write(&r, 1 + (i * 97) % 4096);
+		}
+
+		end_frame(&r);
+	}
+}
+
+static void test_exactly_full(void) {
+	RingSpace rs = { .size = 4096 };
+	uint64_t start;
+
+	for(int i = 0; i < 4; ++i) {
+		CHECK(ring_space_reserve(&rs, 1024, &start));
+		CHECK(start == (uint64_t)i * 1024);
+	}
+
+	CHECK(ring_space_used(&rs) == rs.size);
+	CHECK(!ring_space_reserve(&rs, 1, &start));
+
+	// Releasing up to head must free the whole ring, even though head and tail are at the same offset.
+	ring_space_release(&rs, rs.head);
+	CHECK(ring_space_used(&rs) == 0);
+	CHECK(ring_space_reserve(&rs, 4096, &start));
+	CHECK(start == 4096);
+}
+
+static void test_wraparound(void) {
+	RingSpace rs = { .size = 4096 };
+	uint64_t start;
+
+	CHECK(ring_space_reserve(&rs, 3000, &start));
+	ring_space_release(&rs, 3000);
+
+	// Doesn't fit before the end, so it's placed at the start of the ring, skipping the rest.
+	CHECK(ring_space_reserve(&rs, 2000, &start));
+	CHECK(start == 4096);
+	CHECK(ring_space_offset(&rs, start) == 0);
+	CHECK(ring_space_used(&rs) == 3096);
+
+	// The skipped part still counts until released.
+	CHECK(!ring_space_reserve(&rs, 2000, &start));
+	ring_space_release(&rs, rs.head);
+	CHECK(ring_space_reserve(&rs, 2000, &start));
+}
+
+static void test_random(void) {
+	TestRing r;
+	ring_init(&r);
+	uint32_t rng = 0x7a15e1;
+
+	for(int frame = 0; frame < 1000; ++frame) {
+		uint windows = 1 + (rng = rng * 1103515245 + 12345) % 8;
+
+		for(uint i = 0; i < windows; ++i) {
+			next_window(&r);
+			rng = rng * 1103515245 + 12345;
+			write(&r, (rng >> 8) % 3 ? (rng >> 8) % WINDOW_SIZE : WINDOW_SIZE);
+		}
+
+		end_frame(&r);
+
+		// Sometimes the GPU catches up between frames.
+		while(r.num_fences > 1 && (rng >> 16) % 2) {
+			pop_fence(&r);
+			rng = rng * 1103515245 + 12345;
+		}
+	}
+}
+
+int main(int argc, char **argv) {
+	test_exactly_full();
+	test_wraparound();
+	test_full_windows();
+	test_full_then_small();
+	test_random();
+	return 0;
+}
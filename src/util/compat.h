@@ -237,6 +237,10 @@ typedef complex max_align_t;
 #define attr_returns_aligned(x) \
 	__attribute__ ((assume_aligned(x)))
 
+// Variable is passed by pointer to func when it goes out of scope.
+#define attr_cleanup(func) \
+	__attribute__ ((cleanup(func)))
+
 // Function returns a pointer aligned the same as max_align_t
 #define attr_returns_max_aligned \
 	attr_returns_aligned(alignof(max_align_t))
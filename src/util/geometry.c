@@ -108,6 +108,12 @@ bool lineseg_ellipse_intersect(LineSegment seg, Ellipse e) {
 	return lineseg_circle_intersect_fallback(seg, c) >= 0;
 }
 
+void lineseg_ellipse_intersect_batch(uint num, const LineSegment *segs, const Ellipse *ellipses, bool *out) {
+	for(uint i = 0; i < num; ++i) {
+		out[i] = lineseg_ellipse_intersect(segs[i], ellipses[i]);
+	}
+}
+
 double lineseg_circle_intersect(LineSegment seg, Circle c) {
 	Ellipse e = { .origin = c.origin, .axes = 2*c.radius + I*2*c.radius };
 	if(segment_ellipse_nonintersection_heuristic(seg, e)) {
@@ -74,6 +74,11 @@ bool point_in_ellipse(complex p, Ellipse e) attr_const;
 double lineseg_circle_intersect(LineSegment seg, Circle c) attr_const;
 bool lineseg_ellipse_intersect(LineSegment seg, Ellipse e) attr_const;
 
+// Same as out[i] = lineseg_ellipse_intersect(segs[i], ellipses[i]) for i < num.
+// See also lineseg_ellipse_intersect_batch_sse42 in util/sse42.h.
+void lineseg_ellipse_intersect_batch(uint num, const LineSegment *segs, const Ellipse *ellipses, bool *out)
+	attr_nonnull(2, 3, 4);
+
 static inline attr_must_inline attr_const
 double rect_x(Rect r) {
 	return creal(r.top_left);
@@ -13,6 +13,7 @@
 #include "vfs/public.h"
 #include "assert.h"
 #include "stringops.h"
+#include "resource/resindex.h"
 
 char* read_all(const char *filename, int *outsize) {
 	char *text;
@@ -114,7 +115,7 @@ void tsfprintf(FILE *out, const char *restrict fmt, ...) {
 char* try_path(const char *prefix, const char *name, const char *ext) {
 	char *p = strjoin(prefix, name, ext, NULL);
 
-	if(vfs_query(p).exists) {
+	if(resindex_path_exists(p)) {
 		return p;
 	}
 
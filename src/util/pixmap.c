@@ -11,6 +11,7 @@
 #include "pixmap.h"
 #include "util.h"
 #include "pixmap_loaders/loaders.h"
+#include "resource/resindex.h"
 
 // NOTE: this is pretty stupid and not at all optimized, patches welcome
 
@@ -339,6 +340,40 @@ void pixmap_flip_to_origin_inplace(Pixmap *src, PixmapOrigin origin) {
 	src->origin = origin;
 }
 
+#define PREMULTIPLY_UNORM(pixels, num, maxval) do { \
+	for(size_t i = 0; i < (num); ++i) { \
+		uint64_t a = (pixels)[i].a; \
+		(pixels)[i].r = ((pixels)[i].r * a + (maxval) / 2) / (maxval); \
+		(pixels)[i].g = ((pixels)[i].g * a + (maxval) / 2) / (maxval); \
+		(pixels)[i].b = ((pixels)[i].b * a + (maxval) / 2) / (maxval); \
+	} \
+} while(0)
+
+void pixmap_premultiply_alpha_inplace(Pixmap *px) {
+	if(PIXMAP_FORMAT_LAYOUT(px->format) != PIXMAP_LAYOUT_RGBA) {
+		return;
+	}
+
+	size_t num = px->width * px->height;
+
+	switch(px->format) {
+		case PIXMAP_FORMAT_RGBA8:  PREMULTIPLY_UNORM(px->data.rgba8,  num, UINT8_MAX);  break;
+		case PIXMAP_FORMAT_RGBA16: PREMULTIPLY_UNORM(px->data.rgba16, num, UINT16_MAX); break;
+		case PIXMAP_FORMAT_RGBA32: PREMULTIPLY_UNORM(px->data.rgba32, num, UINT32_MAX); break;
+
+		case PIXMAP_FORMAT_RGBA32F:
+			for(size_t i = 0; i < num; ++i) {
+				PixelRGBA32F *p = px->data.rgba32f + i;
+				p->r *= p->a;
+				p->g *= p->a;
+				p->b *= p->a;
+			}
+			break;
+
+		default: UNREACHABLE;
+	}
+}
+
 bool pixmap_load_stream_tga(SDL_RWops *stream, Pixmap *dst) {
 	return false;
 }
@@ -383,7 +418,7 @@ bool pixmap_load_stream(SDL_RWops *stream, Pixmap *dst) {
 }
 
 bool pixmap_load_file(const char *path, Pixmap *dst) {
-	SDL_RWops *stream = vfs_open(path, VFS_MODE_READ | VFS_MODE_SEEKABLE);
+	SDL_RWops *stream = vfs_open_mapped(path, VFS_MODE_READ | VFS_MODE_SEEKABLE);
 
 	if(!stream) {
 		log_error("VFS error: %s", vfs_get_error());
@@ -404,7 +439,7 @@ char* pixmap_source_path(const char *prefix, const char *path) {
 	strcpy(base_path, prefix);
 	strcpy(base_path + strlen(prefix), path);
 
-	if(pixmap_check_filename(base_path) && vfs_query(base_path).exists) {
+	if(pixmap_check_filename(base_path) && resindex_path_exists(base_path)) {
 		return strdup(base_path);
 	}
 
@@ -161,6 +161,9 @@ void pixmap_flip_to_origin(const Pixmap *src, Pixmap *dst, PixmapOrigin origin)
 void pixmap_flip_to_origin_alloc(const Pixmap *src, Pixmap *dst, PixmapOrigin origin) attr_nonnull(1, 2);
 void pixmap_flip_to_origin_inplace(Pixmap *src, PixmapOrigin origin) attr_nonnull(1);
 
+// No-op for formats without an alpha channel.
+void pixmap_premultiply_alpha_inplace(Pixmap *px) attr_nonnull(1);
+
 size_t pixmap_data_size(const Pixmap *px) attr_nonnull(1);
 
 bool pixmap_load_file(const char *path, Pixmap *dst) attr_nonnull(1, 2) attr_nodiscard;
@@ -20,3 +20,77 @@ uint32_t crc32str_sse42(uint32_t crc, const char *str) {
 
 	return crc;
 }
+
+/*
+ * Rejects segment/ellipse pairs whose bounding boxes don't overlap two at a time,
+ * which is the outcome for the vast majority of bullets. The remaining pairs are
+ * handed over to lineseg_ellipse_intersect.
+ *
+ * The bounding boxes are computed with the same operations as in geometry.c, so a
+ * pair is only rejected here if lineseg_ellipse_intersect would reject it as well.
+ * The complex arithmetic over there produces NaNs out of infinities in places where
+ * this code doesn't, so pairs with any non-finite inputs are never rejected.
+ */
+void lineseg_ellipse_intersect_batch_sse42(uint num, const LineSegment *segs, const Ellipse *ellipses, bool *out) {
+	const __m128d half = _mm_set1_pd(0.5);
+	uint i = 0;
+
+	for(; i + 2 <= num; i += 2) {
+		const double *s0 = (const double*)(segs + i);
+		const double *s1 = (const double*)(segs + i + 1);
+		const double *e0 = (const double*)(ellipses + i);
+		const double *e1 = (const double*)(ellipses + i + 1);
+
+		// Load (x, y) pairs and transpose them into (x0, x1) and (y0, y1).
+		__m128d a0 = _mm_loadu_pd(s0);
+		__m128d a1 = _mm_loadu_pd(s1);
+		__m128d b0 = _mm_loadu_pd(s0 + 2);
+		__m128d b1 = _mm_loadu_pd(s1 + 2);
+		__m128d o0 = _mm_loadu_pd(e0);
+		__m128d o1 = _mm_loadu_pd(e1);
+		__m128d x0 = _mm_loadu_pd(e0 + 2);
+		__m128d x1 = _mm_loadu_pd(e1 + 2);
+
+		__m128d ax = _mm_unpacklo_pd(a0, a1), ay = _mm_unpackhi_pd(a0, a1);
+		__m128d bx = _mm_unpacklo_pd(b0, b1), by = _mm_unpackhi_pd(b0, b1);
+		__m128d ox = _mm_unpacklo_pd(o0, o1), oy = _mm_unpackhi_pd(o0, o1);
+		__m128d axes_x = _mm_unpacklo_pd(x0, x1), axes_y = _mm_unpackhi_pd(x0, x1);
+
+		__m128d seg_left   = _mm_min_pd(ax, bx);
+		__m128d seg_right  = _mm_max_pd(ax, bx);
+		__m128d seg_top    = _mm_min_pd(ay, by);
+		__m128d seg_bottom = _mm_max_pd(ay, by);
+
+		// The radius is rounded to float, just like in ellipse_bbox.
+		__m128d r = _mm_cvtps_pd(_mm_cvtpd_ps(_mm_mul_pd(_mm_max_pd(axes_x, axes_y), half)));
+
+		__m128d e_left   = _mm_sub_pd(ox, r);
+		__m128d e_right  = _mm_add_pd(ox, r);
+		__m128d e_top    = _mm_sub_pd(oy, r);
+		__m128d e_bottom = _mm_add_pd(oy, r);
+
+		__m128d reject = _mm_or_pd(
+			_mm_or_pd(_mm_cmplt_pd(seg_bottom, e_top), _mm_cmpgt_pd(seg_top, e_bottom)),
+			_mm_or_pd(_mm_cmpgt_pd(seg_left, e_right), _mm_cmplt_pd(seg_right, e_left))
+		);
+
+		// x - x is 0 for finite x and NaN otherwise; the sum is NaN if anything isn't finite.
+		__m128d nonfinite = _mm_sub_pd(ax, ax);
+		nonfinite = _mm_add_pd(nonfinite, _mm_sub_pd(ay, ay));
+		nonfinite = _mm_add_pd(nonfinite, _mm_sub_pd(bx, bx));
+		nonfinite = _mm_add_pd(nonfinite, _mm_sub_pd(by, by));
+		nonfinite = _mm_add_pd(nonfinite, _mm_sub_pd(ox, ox));
+		nonfinite = _mm_add_pd(nonfinite, _mm_sub_pd(oy, oy));
+		nonfinite = _mm_add_pd(nonfinite, _mm_sub_pd(r, r));
+		reject = _mm_and_pd(reject, _mm_cmpord_pd(nonfinite, nonfinite));
+
+		int mask = _mm_movemask_pd(reject);
+
+		out[i]     = !(mask & 1) && lineseg_ellipse_intersect(segs[i], ellipses[i]);
+		out[i + 1] = !(mask & 2) && lineseg_ellipse_intersect(segs[i + 1], ellipses[i + 1]);
+	}
+
+	for(; i < num; ++i) {
+		out[i] = lineseg_ellipse_intersect(segs[i], ellipses[i]);
+	}
+}
@@ -11,10 +11,14 @@
 
 #include "taisei.h"
 
+#include "geometry.h"
+
 #ifdef TAISEI_BUILDCONF_USE_SSE42
 	uint32_t crc32str_sse42(uint32_t crc, const char *str) attr_hot attr_pure;
+	void lineseg_ellipse_intersect_batch_sse42(uint num, const LineSegment *segs, const Ellipse *ellipses, bool *out) attr_hot attr_nonnull(2, 3, 4);
 #else
 	#define crc32str_sse42 crc32str
+	#define lineseg_ellipse_intersect_batch_sse42 lineseg_ellipse_intersect_batch
 #endif
 
 #endif // IGUARD_util_sse42_h
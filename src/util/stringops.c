@@ -496,3 +496,24 @@ void expand_escape_sequences(char *str) {
 		p[-1] = 0;
 	}
 }
+
+char* json_escape(const char *str) {
+	char *out = malloc(strlen(str) * 6 + 1);
+	char *p = out;
+
+	for(; *str; ++str) {
+		uchar c = *str;
+
+		if(c == '"' || c == '\\') {
+			*p++ = '\\';
+			*p++ = c;
+		} else if(c < 0x20) {
+			p += snprintf(p, 7, "\\u%04x", c);
+		} else {
+			*p++ = c;
+		}
+	}
+
+	*p = 0;
+	return out;
+}
@@ -54,6 +54,9 @@ char* strappend(char **dst, char *src);
 char* strftimealloc(const char *fmt, const struct tm *timeinfo);
 void expand_escape_sequences(char *str);
 
+// Returns a copy of str with everything that can't appear verbatim in a JSON string escaped.
+char* json_escape(const char *str) attr_nonnull(1) attr_returns_nonnull attr_nodiscard;
+
 uint32_t* ucs4chr(const uint32_t *ucs4, uint32_t chr);
 size_t ucs4len(const uint32_t *ucs4);
 
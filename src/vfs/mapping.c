@@ -0,0 +1,127 @@
+/*
+ * This software is licensed under the terms of the MIT-License
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2019, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2019, Andrei Alexeyev <akari@alienslab.net>.
+ */
+
+#include "taisei.h"
+
+#include "private.h"
+
+bool vfs_map(const char *path, VFSMapping *mapping) {
+	char p[strlen(path)+1];
+	path = vfs_path_normalize(path, p);
+	VFSNode *node = vfs_locate(vfs_root, path);
+	bool ok = false;
+
+	memset(mapping, 0, sizeof(*mapping));
+
+	if(node) {
+		assert(node->funcs != NULL);
+
+		if(!(ok = vfs_node_map(node, mapping))) {
+			vfs_set_error("Can't map '%s': %s", path, vfs_get_error());
+		}
+
+		vfs_decref(node);
+	} else {
+		vfs_set_error("Node '%s' does not exist", path);
+	}
+
+	return ok;
+}
+
+void vfs_unmap(VFSMapping *mapping) {
+	if(mapping->release) {
+		mapping->release(mapping);
+	}
+
+	memset(mapping, 0, sizeof(*mapping));
+}
+
+/*
+ * Read-only stream over a mapping, which it owns.
+ */
+
+typedef struct MappedStream {
+	VFSMapping mapping;
+	size_t pos;
+} MappedStream;
+
+#define MSTREAM(rw) ((MappedStream*)((rw)->hidden.unknown.data1))
+
+static int mstream_close(SDL_RWops *rw) {
+	vfs_unmap(&MSTREAM(rw)->mapping);
+	free(MSTREAM(rw));
+	SDL_FreeRW(rw);
+	return 0;
+}
+
+static int64_t mstream_size(SDL_RWops *rw) {
+	return MSTREAM(rw)->mapping.size;
+}
+
+static int64_t mstream_seek(SDL_RWops *rw, int64_t offset, int whence) {
+	MappedStream *ms = MSTREAM(rw);
+	int64_t pos;
+
+	switch(whence) {
+		case RW_SEEK_SET: pos = offset; break;
+		case RW_SEEK_CUR: pos = ms->pos + offset; break;
+		case RW_SEEK_END: pos = ms->mapping.size + offset; break;
+		default: UNREACHABLE;
+	}
+
+	if(pos < 0 || (uint64_t)pos > ms->mapping.size) {
+		SDL_SetError("Seek out of range");
+		return -1;
+	}
+
+	return ms->pos = pos;
+}
+
+static size_t mstream_read(SDL_RWops *rw, void *ptr, size_t size, size_t maxnum) {
+	MappedStream *ms = MSTREAM(rw);
+
+	if(size == 0) {
+		return 0;
+	}
+
+	size_t num = umin(maxnum, (ms->mapping.size - ms->pos) / size);
+	memcpy(ptr, (const char*)ms->mapping.data + ms->pos, num * size);
+	ms->pos += num * size;
+	return num;
+}
+
+static size_t mstream_write(SDL_RWops *rw, const void *ptr, size_t size, size_t maxnum) {
+	SDL_SetError("Read-only stream");
+	return 0;
+}
+
+SDL_RWops* vfs_open_mapped(const char *path, VFSOpenMode mode) {
+	assert(!(mode & VFS_MODE_WRITE));
+
+	VFSMapping mapping;
+
+	if(!vfs_map(path, &mapping)) {
+		return vfs_open(path, mode | VFS_MODE_READ);
+	}
+
+	SDL_RWops *rw = SDL_AllocRW();
+	memset(rw, 0, sizeof(SDL_RWops));
+
+	MappedStream *ms = calloc(1, sizeof(*ms));
+	ms->mapping = mapping;
+
+	rw->hidden.unknown.data1 = ms;
+	rw->type = SDL_RWOPS_UNKNOWN;
+	rw->size = mstream_size;
+	rw->seek = mstream_seek;
+	rw->close = mstream_close;
+	rw->read = mstream_read;
+	rw->write = mstream_write;
+
+	return rw;
+}
@@ -143,3 +143,14 @@ SDL_RWops* vfs_node_open(VFSNode *filenode, VFSOpenMode mode) {
 
 	return stream;
 }
+
+bool vfs_node_map(VFSNode *filenode, VFSMapping *mapping) {
+	assert(filenode->funcs != NULL);
+
+	if(filenode->funcs->map == NULL) {
+		vfs_set_error("Node can't be mapped into memory");
+		return false;
+	}
+
+	return filenode->funcs->map(filenode, mapping);
+}
@@ -37,6 +37,7 @@ struct VFSNodeFuncs {
 	void        (*iter_stop)(VFSNode *dirnode, void **opaque) attr_nonnull(1);
 	bool        (*mkdir)(VFSNode *parent, const char *subdir) attr_nonnull(1);
 	SDL_RWops*  (*open)(VFSNode *filenode, VFSOpenMode mode) attr_nonnull(1);
+	bool        (*map)(VFSNode *filenode, VFSMapping *mapping) attr_nonnull(1, 2);
 };
 
 struct VFSNode {
@@ -68,6 +69,7 @@ const char* vfs_node_iter(VFSNode *node, void **opaque) attr_nonnull(1);
 void vfs_node_iter_stop(VFSNode *node, void **opaque) attr_nonnull(1);
 bool vfs_node_mkdir(VFSNode *parent, const char *subdir) attr_nonnull(1);
 SDL_RWops* vfs_node_open(VFSNode *filenode, VFSOpenMode mode) attr_nonnull(1);
+bool vfs_node_map(VFSNode *filenode, VFSMapping *mapping) attr_nonnull(1, 2) attr_nodiscard;
 
 void vfs_hook_on_shutdown(VFSShutdownHandler, void *arg);
 void vfs_print_tree_recurse(SDL_RWops *dest, VFSNode *root, char *prefix, const char *name) attr_nonnull(1, 2, 3, 4);
@@ -43,7 +43,29 @@ typedef enum VFSSyncMode {
 
 typedef struct VFSDir VFSDir;
 
+typedef struct VFSMapping VFSMapping;
+
+// A read-only view of a whole file's contents. Must be released with vfs_unmap.
+struct VFSMapping {
+	const void *data;
+	size_t size;
+
+	// private
+	void (*release)(VFSMapping *mapping);
+	void *opaque;
+};
+
 SDL_RWops* vfs_open(const char *path, VFSOpenMode mode);
+
+// Maps a file into memory without copying it, if the backend supports that: plain files on POSIX
+// systems, and uncompressed (stored) members of zip packages. Otherwise returns false and sets the
+// VFS error; the caller should then fall back to vfs_open.
+bool vfs_map(const char *path, VFSMapping *mapping) attr_nonnull(1, 2) attr_nodiscard;
+void vfs_unmap(VFSMapping *mapping) attr_nonnull(1);
+
+// Like vfs_open with VFS_MODE_READ, but reads straight from a mapping of the file if possible.
+// The returned stream is always seekable if VFS_MODE_SEEKABLE is passed.
+SDL_RWops* vfs_open_mapped(const char *path, VFSOpenMode mode);
 VFSInfo vfs_query(const char *path);
 
 bool vfs_mkdir(const char *path);
@@ -213,7 +213,8 @@ void vfs_setup(CallChain next) {
 	vfs_mount_alias("res", "resdirs");
 	// vfs_make_readonly("res");
 
-	vfs_unmount("resdirs");
+	// "resdirs" stays around, so that the resource index can tell which parts of the packages
+	// are overridden by loose files; see resource/resindex.c
 	vfs_unmount("respkgs");
 
 	run_call_chain(&next, NULL);
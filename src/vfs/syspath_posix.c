@@ -14,6 +14,11 @@
 #include <dirent.h>
 #include <errno.h>
 
+#ifdef TAISEI_BUILDCONF_HAVE_POSIX
+#include <fcntl.h>
+#include <sys/mman.h>
+#endif
+
 #include "syspath.h"
 
 #define _path_ data1
@@ -49,6 +54,53 @@ static SDL_RWops* vfs_syspath_open(VFSNode *node, VFSOpenMode mode) {
 	return rwops;
 }
 
+#ifdef TAISEI_BUILDCONF_HAVE_POSIX
+
+static void vfs_syspath_unmap(VFSMapping *mapping) {
+	munmap((void*)mapping->data, mapping->size);
+}
+
+static bool vfs_syspath_map(VFSNode *node, VFSMapping *mapping) {
+	int fd = open(node->_path_, O_RDONLY);
+
+	if(fd < 0) {
+		vfs_set_error("Can't open %s (errno: %i)", (char*)node->_path_, errno);
+		return false;
+	}
+
+	struct stat st;
+
+	if(fstat(fd, &st) < 0) {
+		vfs_set_error("Can't stat %s (errno: %i)", (char*)node->_path_, errno);
+		close(fd);
+		return false;
+	}
+
+	if(!S_ISREG(st.st_mode) || st.st_size <= 0 || (uintmax_t)st.st_size > SIZE_MAX) {
+		vfs_set_error("%s is not a regular non-empty file", (char*)node->_path_);
+		close(fd);
+		return false;
+	}
+
+	void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+
+	if(data == MAP_FAILED) {
+		vfs_set_error("Can't map %s (errno: %i)", (char*)node->_path_, errno);
+		return false;
+	}
+
+	*mapping = (VFSMapping) {
+		.data = data,
+		.size = st.st_size,
+		.release = vfs_syspath_unmap,
+	};
+
+	return true;
+}
+
+#endif
+
 static VFSNode* vfs_syspath_locate(VFSNode *node, const char *path) {
 	VFSNode *n = vfs_alloc();
 	vfs_syspath_init_internal(n, strfmt("%s%c%s", (char*)node->_path_, VFS_PATH_SEP, path));
@@ -135,6 +187,9 @@ static VFSNodeFuncs vfs_funcs_syspath = {
 	.iter_stop = vfs_syspath_iter_stop,
 	.mkdir = vfs_syspath_mkdir,
 	.open = vfs_syspath_open,
+#ifdef TAISEI_BUILDCONF_HAVE_POSIX
+	.map = vfs_syspath_map,
+#endif
 };
 
 void vfs_syspath_normalize(char *buf, size_t bufsize, const char *path) {
@@ -187,6 +187,18 @@ static SDL_RWops* vfs_union_open(VFSNode *unode, VFSOpenMode mode) {
 	return NULL;
 }
 
+static bool vfs_union_map(VFSNode *unode, VFSMapping *mapping) {
+	VFSNode *n = unode->_primary_member_;
+
+	if(n) {
+		return vfs_node_map(n, mapping);
+	} else {
+		vfs_set_error("Union object has no members");
+	}
+
+	return false;
+}
+
 static char* vfs_union_repr(VFSNode *node) {
 	char *mlist = strdup("union: "), *r;
 
@@ -237,6 +249,7 @@ static VFSNodeFuncs vfs_funcs_union = {
 	.iter_stop = vfs_union_iter_stop,
 	.mkdir = vfs_union_mkdir,
 	.open = vfs_union_open,
+	.map = vfs_union_map,
 };
 
 void vfs_union_init(VFSNode *node) {
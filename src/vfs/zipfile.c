@@ -149,6 +149,13 @@ static void vfs_zipfile_free(VFSNode *node) {
 				vfs_decref(zdata->source);
 			}
 
+			if(zdata->map.archive.data) {
+				vfs_unmap(&zdata->map.archive);
+			}
+
+			free(zdata->map.members);
+			SDL_DestroyMutex(zdata->map.mutex);
+
 			ht_destroy(&zdata->pathmap);
 			free(zdata);
 		}
@@ -355,6 +362,11 @@ bool vfs_zipfile_init(VFSNode *node, VFSNode *source) {
 		goto error;
 	}
 
+	if(!(zdata->map.mutex = SDL_CreateMutex())) {
+		vfs_set_error("SDL_CreateMutex() failed: %s", SDL_GetError());
+		goto error;
+	}
+
 	if(!vfs_zipfile_get_tls(node, true)) {
 		goto error;
 	}
@@ -368,3 +380,157 @@ error:
 	memcpy(node, &backup, sizeof(VFSNode));
 	return false;
 }
+
+/*
+ * Direct access to stored members.
+ *
+ * libzip has no way to tell where a member's data is located in the archive, so we find that out
+ * ourselves by walking the central directory of a memory-mapped archive. Only plain (non-ZIP64)
+ * archives are supported, which is all we ever produce. The walk is done at most once per archive,
+ * on the first vfs_zipfile_map_member call.
+ */
+
+#define ZIP_EOCD_SIGNATURE 0x06054b50
+#define ZIP_EOCD_SIZE 22
+#define ZIP_CDIR_SIGNATURE 0x02014b50
+#define ZIP_CDIR_SIZE 46
+#define ZIP_LOCAL_SIGNATURE 0x04034b50
+#define ZIP_LOCAL_SIZE 30
+#define ZIP_FLAG_ENCRYPTED 1
+
+static inline uint16_t zip_read16(const uint8_t *p) {
+	return p[0] | (p[1] << 8);
+}
+
+static inline uint32_t zip_read32(const uint8_t *p) {
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static const uint8_t* vfs_zipfile_find_eocd(const uint8_t *data, size_t size) {
+	if(size < ZIP_EOCD_SIZE) {
+		return NULL;
+	}
+
+	// the end of central directory record is followed by a comment of up to 64 KiB
+	const uint8_t *p = data + size - ZIP_EOCD_SIZE;
+	const uint8_t *end = data + size - umin(size, ZIP_EOCD_SIZE + UINT16_MAX);
+
+	for(; p >= end; --p) {
+		if(zip_read32(p) == ZIP_EOCD_SIGNATURE && p + ZIP_EOCD_SIZE + zip_read16(p + 20) == data + size) {
+			return p;
+		}
+	}
+
+	return NULL;
+}
+
+static bool vfs_zipfile_scan_members(VFSNode *zipnode) {
+	VFSZipFileData *zdata = zipnode->data1;
+	VFSZipFileTLS *tls = vfs_zipfile_get_tls(zipnode, true);
+
+	if(!vfs_node_map(zdata->source, &zdata->map.archive)) {
+		return false;
+	}
+
+	const uint8_t *data = zdata->map.archive.data;
+	size_t size = zdata->map.archive.size;
+	const uint8_t *eocd = vfs_zipfile_find_eocd(data, size);
+
+	if(!eocd) {
+		log_debug("End of central directory not found");
+		return false;
+	}
+
+	uint64_t num_members = zip_read16(eocd + 10);
+	uint64_t cdir_size = zip_read32(eocd + 12);
+	uint64_t cdir_offset = zip_read32(eocd + 16);
+
+	// libzip indexes the members in central directory order; make sure we agree with it
+	if(!tls || num_members != (uint64_t)zip_get_num_entries(tls->zip, 0) || cdir_offset + cdir_size > size) {
+		log_debug("Unsupported archive layout");
+		return false;
+	}
+
+	VFSZipFileMember *members = calloc(umax(num_members, 1), sizeof(*members));
+	const uint8_t *p = data + cdir_offset;
+	const uint8_t *cdir_end = p + cdir_size;
+
+	for(uint64_t i = 0; i < num_members; ++i) {
+		if(p + ZIP_CDIR_SIZE > cdir_end || zip_read32(p) != ZIP_CDIR_SIGNATURE) {
+			log_debug("Central directory is corrupt");
+			free(members);
+			return false;
+		}
+
+		uint16_t flags = zip_read16(p + 8);
+		uint16_t method = zip_read16(p + 10);
+		uint32_t comp_size = zip_read32(p + 20);
+		uint32_t size_uncompressed = zip_read32(p + 24);
+		uint64_t local_offset = zip_read32(p + 42);
+
+		if(
+			method == ZIP_CM_STORE &&
+			!(flags & ZIP_FLAG_ENCRYPTED) &&
+			comp_size == size_uncompressed &&
+			comp_size > 0 &&
+			local_offset + ZIP_LOCAL_SIZE <= size
+		) {
+			const uint8_t *local = data + local_offset;
+			uint64_t data_offset = local_offset + ZIP_LOCAL_SIZE + zip_read16(local + 26) + zip_read16(local + 28);
+
+			if(zip_read32(local) == ZIP_LOCAL_SIGNATURE && data_offset + comp_size <= size) {
+				members[i].offset = data_offset;
+				members[i].size = comp_size;
+			}
+		}
+
+		p += ZIP_CDIR_SIZE + zip_read16(p + 28) + zip_read16(p + 30) + zip_read16(p + 32);
+	}
+
+	zdata->map.members = members;
+	zdata->map.num_members = num_members;
+	return true;
+}
+
+static void vfs_zipfile_unmap_member(VFSMapping *mapping) {
+	vfs_decref(mapping->opaque);
+}
+
+bool vfs_zipfile_map_member(VFSNode *zipnode, uint64_t index, VFSMapping *mapping) {
+	VFSZipFileData *zdata = zipnode->data1;
+
+	SDL_LockMutex(zdata->map.mutex);
+
+	if(!zdata->map.initialized) {
+		if(!vfs_zipfile_scan_members(zipnode)) {
+			char *r = vfs_node_repr(zdata->source, true);
+			log_debug("Members of '%s' can't be mapped", r);
+			free(r);
+
+			if(zdata->map.archive.data) {
+				vfs_unmap(&zdata->map.archive);
+			}
+		}
+
+		zdata->map.initialized = true;
+	}
+
+	SDL_UnlockMutex(zdata->map.mutex);
+
+	if(index >= zdata->map.num_members || !zdata->map.members[index].offset) {
+		vfs_set_error("File can't be mapped");
+		return false;
+	}
+
+	VFSZipFileMember *m = zdata->map.members + index;
+	vfs_incref(zipnode);
+
+	*mapping = (VFSMapping) {
+		.data = (const uint8_t*)zdata->map.archive.data + m->offset,
+		.size = m->size,
+		.release = vfs_zipfile_unmap_member,
+		.opaque = zipnode,
+	};
+
+	return true;
+}
@@ -23,10 +23,24 @@ typedef struct VFSZipFileTLS {
 	zip_error_t error;
 } VFSZipFileTLS;
 
+typedef struct VFSZipFileMember {
+	uint32_t offset; // of the data in the archive, 0 if the member can't be mapped
+	uint32_t size;
+} VFSZipFileMember;
+
 typedef struct VFSZipFileData {
 	VFSNode *source;
 	ht_str2int_t pathmap;
 	SDL_TLSID tls_id;
+
+	// Set up lazily by vfs_zipfile_map_member
+	struct {
+		SDL_mutex *mutex;
+		VFSMapping archive;
+		VFSZipFileMember *members;
+		uint64_t num_members;
+		bool initialized;
+	} map;
 } VFSZipFileData;
 
 typedef struct VFSZipFileIterData {
@@ -52,5 +66,6 @@ typedef struct VFSZipPathData {
 
 void vfs_zippath_init(VFSNode *node, VFSNode *zipnode, zip_int64_t idx);
 VFSZipFileTLS* vfs_zipfile_get_tls(VFSNode *node, bool create);
+bool vfs_zipfile_map_member(VFSNode *zipnode, uint64_t index, VFSMapping *mapping);
 
 #endif // IGUARD_vfs_zipfile_impl_h
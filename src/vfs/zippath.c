@@ -96,6 +96,17 @@ static SDL_RWops* vfs_zippath_open(VFSNode *node, VFSOpenMode mode) {
 	return SDL_RWFromZipFile(node, zdata);
 }
 
+static bool vfs_zippath_map(VFSNode *node, VFSMapping *mapping) {
+	VFSZipPathData *zdata = node->data1;
+
+	if(!zdata->seekable) {
+		vfs_set_error("Compressed files in ZIP archives can't be mapped");
+		return false;
+	}
+
+	return vfs_zipfile_map_member(zdata->zipnode, zdata->index, mapping);
+}
+
 static VFSNodeFuncs vfs_funcs_zippath = {
 	.repr = vfs_zippath_repr,
 	.query = vfs_zippath_query,
@@ -107,6 +118,7 @@ static VFSNodeFuncs vfs_funcs_zippath = {
 	.iter_stop = vfs_zippath_iter_stop,
 	//.mkdir = vfs_zippath_mkdir,
 	.open = vfs_zippath_open,
+	.map = vfs_zippath_map,
 };
 
 void vfs_zippath_init(VFSNode *node, VFSNode *zipnode, zip_int64_t idx) {